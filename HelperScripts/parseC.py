@@ -4,30 +4,39 @@ import os
 import datetime
 import clang.cindex
 import subprocess
-from paths import path_to_components, path_to_gameobjects, path_to_cmake, path_to_src
+from paths import path_to_components, path_to_gameobjects, path_to_cmake, path_to_src, \
+    path_to_thirdparty, path_to_llvm, path_to_libclang, path_to_clang_format
+
+clang.cindex.Config.set_library_path(str(path_to_libclang))
+
+include_dirs = [path_to_src,
+                path_to_src / "misc",
+                path_to_src / "graphics",
+                path_to_src / "components",
+                path_to_thirdparty / "SDL" / "include",
+                path_to_thirdparty / "glm",
+                path_to_thirdparty / "glad" / "include",
+                path_to_thirdparty / "imgui",
+                path_to_thirdparty / "imguiGizmo",
+                path_to_thirdparty / "json",
+                path_to_thirdparty / "tinyGltf",
+                path_to_thirdparty / "freetype-2.9",
+                path_to_thirdparty / "stb",
+                path_to_thirdparty / "physx-3.4" / "Include",
+                path_to_llvm / "include"]
 
 args = ["-xc++",
         "-D__CODE_GENERATOR__",
-        "-std=c++17",
-        "-IC:/Projects/DingoEngine/src",
-        "-IC:/Projects/DingoEngine/src/misc",
-        "-IC:/Projects/DingoEngine/src/graphics",
-        "-IC:/Projects/DingoEngine/src/components",
-        "-IC:/Projects/DingoEngine/ThirdParty/SDL-mirror/include",
-        "-IC:/Projects/DingoEngine/ThirdParty/glm",
-        "-IC:/Projects/DingoEngine/ThirdParty/glad/include",
-        "-IC:/Projects/DingoEngine/ThirdParty/imgui",
-        "-IC:/Projects/DingoEngine/ThirdParty/imguiGizmo",
-        "-IC:/Projects/DingoEngine/ThirdParty/tinyGltf",
-        "-IC:/Projects/DingoEngine/ThirdParty/freetype-2.9",
-        "-IC:/Projects/DingoEngine/ThirdParty/stb",
-        "-IC:/Projects/DingoEngine/ThirdParty/physx-3.4/Include",
-        "-Ic:/Program Files/LLVM/include"]
+        "-DSOURCEPATH=" + path_to_src.as_posix(),
+        "-std=c++17"] + ["-I" + p.as_posix() for p in include_dirs if p.exists()]
 
 
 class Field:
     def __init__(self, cursor):
         self.name = cursor.spelling
+        # _renderableId -> RenderableId, used as json key and reflection name
+        self.display_name = self.name.lstrip("_")
+        self.display_name = self.display_name[:1].upper() + self.display_name[1:]
         self.attributes = []
         self.type = cursor.type.spelling
         for c in cursor.get_children():
@@ -125,10 +134,11 @@ class File:
             with open(str(path / self.output_filename_cpp), "w") as file:
                 output_file(file, True, self.output_filename_cpp, self)
 
-        # format outputted files
-        arguments = [r"c:\Program Files\LLVM\bin\clang-format.exe", "-i", "-style=file",
-                     str(path / self.output_filename_h), str(path / self.output_filename_cpp)]
-        subprocess.Popen(arguments)
+            # format outputted files
+            if path_to_clang_format:
+                subprocess.run([path_to_clang_format, "-i", "-style=file",
+                                str(path / self.output_filename_h),
+                                str(path / self.output_filename_cpp)])
 
     def build_classes(self, cursor):
         for c in cursor.get_children():
@@ -166,15 +176,18 @@ def output_file(file, with_impl, filename, ast_file):
     )
 
     if with_impl:
-        file.write('#include "engine/Serialize.h"\n')
         file.write('#include "{}"\n'.format(filename.replace(".cpp", ".h")))
 
     file.write(
-        '#include "../{}"\n'
-        "\n".format(ast_file.filename.name)
+        '#include "../{}"\n'.format(ast_file.filename.name)
     )
 
+    if with_impl:
+        file.write('#include "engine/Reflection.h"\n')
+        file.write('#include "engine/Serialize.h"\n')
+
     file.write(
+        "\n"
         "namespace DG\n"
         "{\n"
     )
@@ -182,6 +195,7 @@ def output_file(file, with_impl, filename, ast_file):
     # Output all functions here
     for c in ast_file.classes:
         parsed_class: Class = c
+        properties = [f for f in parsed_class.fields if f.attributes and f.attributes[0] == "DPROPERTY"]
         file.write(
             'void Serialize{}(const {}* item, nlohmann::json& json)'.format(parsed_class.name,
                                                                             parsed_class.name))
@@ -192,16 +206,42 @@ def output_file(file, with_impl, filename, ast_file):
             )
 
             # Find all attributes in files and export them here!
-            for f in parsed_class.fields:
-                field: Field = f
-                if field.attributes:
-                    if field.attributes[0] == "DPROPERTY":
-                        file.write(
-                            '    json["{}"] = Serialize(item->{});\n'.format(field.name, field.name)
-                        )
+            for field in properties:
+                file.write(
+                    '    json["{}"] = Serialize(item->{});\n'.format(field.display_name, field.name)
+                )
 
             file.write(
                 '}\n'
+                '\n'
+            )
+        else:
+            file.write(";\n")
+
+        # Static reflection table, registered by index of the class type before main runs
+        file.write('const ClassReflection* Reflect{}()'.format(parsed_class.name))
+        if with_impl:
+            file.write(
+                '\n'
+                '{\n'
+            )
+            if properties:
+                file.write('    static const FieldReflection fields[] = {\n')
+                for field in properties:
+                    file.write('        DG_REFLECT_FIELD({}, {}, "{}"),\n'.format(parsed_class.name, field.name,
+                                                                              field.display_name))
+                file.write('    };\n')
+                fields, field_count = "fields", "COUNT_OF(fields)"
+            else:
+                fields, field_count = "nullptr", "0"
+
+            file.write(
+                '    static const ClassReflection reflection = {{{0}::GetClassType(), sizeof({0}), {1},\n'
+                '                                                {2}}};\n'
+                '    return &reflection;\n'
+                '}}\n'
+                'static const bool Is{0}Registered = RegisterClassReflection(Reflect{0}());\n'.format(
+                    parsed_class.name, fields, field_count)
             )
         else:
             file.write(";\n")
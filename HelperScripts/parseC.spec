@@ -4,7 +4,7 @@ block_cipher = None
 
 
 a = Analysis(['parseC.py'],
-             pathex=['C:\\Projects\\DingoEngine\\HelperScripts'],
+             pathex=[SPECPATH],
              binaries=[],
              datas=[],
              hiddenimports=[],
@@ -1,5 +1,7 @@
 import os
 import pathlib
+import shutil
+import subprocess
 
 _dir_path = os.path.dirname(os.path.realpath(__file__))
 path_to_engine = pathlib.Path(_dir_path).parent
@@ -9,3 +11,24 @@ path_to_cmake = path_to_engine / "CMakeLists.txt"
 path_to_res = path_to_engine / "res"
 path_to_components = path_to_src / "components"
 path_to_gameobjects = path_to_src / "gameobjects"
+path_to_thirdparty = path_to_engine / "ThirdParty"
+
+
+def _default_llvm_path():
+    if os.name == "nt":
+        return pathlib.Path("C:/Program Files/LLVM")
+    llvm_config = shutil.which("llvm-config")
+    if llvm_config:
+        prefix = subprocess.run([llvm_config, "--prefix"], stdout=subprocess.PIPE,
+                                universal_newlines=True).stdout.strip()
+        if prefix:
+            return pathlib.Path(prefix)
+    return pathlib.Path("/usr")
+
+
+# Override with DINGO_LLVM_PATH, e.g. /usr/lib/llvm-14 or "C:/Program Files/LLVM"
+path_to_llvm = pathlib.Path(os.environ["DINGO_LLVM_PATH"]) if "DINGO_LLVM_PATH" in os.environ \
+    else _default_llvm_path()
+path_to_libclang = path_to_llvm / ("bin" if os.name == "nt" else "lib")
+path_to_clang_format = os.environ.get("DINGO_CLANG_FORMAT") or shutil.which(
+    str(path_to_llvm / "bin" / "clang-format")) or shutil.which("clang-format")
@@ -1,18 +1,27 @@
 #version 440
 
-uniform vec3 lightColor;
+// Per view constants, mirrors ViewConstants in GraphicsSystem.h
+layout(std140, binding = 0) uniform ViewConstants
+{
+    mat4 proj;
+    mat4 view;
+    mat4 cascadeViewProjections[4];
+    vec4 cascadeSplits;  // View depth where each cascade ends
+    vec3 lightDirection;
+    float bias;
+    vec3 lightColor;
+    vec2 shadowMapSize;
+};
 
 in vec3 frag_colors;
 
 in vec3 view_normal;
 in vec3 view_light_dir;
 in vec3 view_pos;
-in vec3 lightSpacePosition;
+in vec3 world_pos;
 
 out vec4 out_color;
 
-uniform float bias;
-uniform vec2 resolution;
 uniform sampler2DShadow texSampler;
 
 void main()
@@ -25,17 +34,36 @@ void main()
     vec3 lightDir = normalize(-view_light_dir);
     vec3 viewDir = normalize(-view_pos);
 
-    vec2 poissonDisk[4] = vec2[](vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
-                                 vec2(-0.094184101, -0.92938870), vec2(0.34495938, 0.29387760));
+    // First cascade that reaches this far, nothing beyond the last one is shadowed
+    float depth = -view_pos.z;
+    int cascade = 0;
+    while (cascade < 4 && depth > cascadeSplits[cascade]) cascade++;
 
-    float total = 0;
-    for (int i = 0; i < 4; i++)
+    float shadowFactor = 1;
+    if (cascade < 4)
     {
-        vec2 newUv = lightSpacePosition.xy + poissonDisk[i] / resolution;
+        vec4 lightPosition = cascadeViewProjections[cascade] * vec4(world_pos, 1);
+        vec3 lightSpacePosition = (lightPosition.xyz / lightPosition.w + vec3(1)) / 2.0;
+
+        // The cascades are tiles of a 2x2 atlas, taps stay inside their tile
+        vec2 tileOrigin = vec2(cascade & 1, cascade >> 1) * 0.5;
+        vec2 texel = 1.0 / shadowMapSize;
+        vec2 tileMin = tileOrigin + texel;
+        vec2 tileMax = tileOrigin + 0.5 - texel;
+
+        vec2 poissonDisk[4] = vec2[](vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+                                     vec2(-0.094184101, -0.92938870), vec2(0.34495938, 0.29387760));
+
+        float total = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            vec2 newUv = tileOrigin + lightSpacePosition.xy * 0.5 + poissonDisk[i] * texel;
+            newUv = clamp(newUv, tileMin, tileMax);
 
-        total = total + texture(texSampler, vec3(newUv, lightSpacePosition.z - bias));
+            total = total + texture(texSampler, vec3(newUv, lightSpacePosition.z - bias));
+        }
+        shadowFactor = total / 4.0;
     }
-    float shadowFactor = total / 4.0;
 
     // Diffuse Light
     float cosTheta = dot(norm, lightDir);
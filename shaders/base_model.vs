@@ -4,18 +4,27 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 norm;
 layout(location = 2) in vec3 tangent;
 layout(location = 3) in vec2 uv;
+// Per instance, see InstanceBuffer::InstanceAttribute
+layout(location = 8) in mat4 model;
 
-uniform mat4 proj;
-uniform mat4 view;
-uniform mat4 model;
-uniform mat4 lightMVP;
-uniform vec3 lightDirection;
+// Per view constants, mirrors ViewConstants in GraphicsSystem.h
+layout(std140, binding = 0) uniform ViewConstants
+{
+    mat4 proj;
+    mat4 view;
+    mat4 cascadeViewProjections[4];
+    vec4 cascadeSplits;  // View depth where each cascade ends
+    vec3 lightDirection;
+    float bias;
+    vec3 lightColor;
+    vec2 shadowMapSize;
+};
 
 out vec3 frag_colors;
 out vec3 view_normal;
 out vec3 view_light_dir;
 out vec3 view_pos;
-out vec3 lightSpacePosition;
+out vec3 world_pos;
 
 void main()
 {
@@ -27,10 +36,7 @@ void main()
     frag_colors = vec3(1);
 
     vec4 world_pos_vec4 = model * vec4(position, 1.0);
-
-	vec4 bla = (lightMVP * world_pos_vec4);
-	vec3 lightDivision = bla.xyz / bla.w;
-    lightSpacePosition = (lightDivision + vec3(1,1,1)) / 2.0;
+    world_pos = world_pos_vec4.xyz;
 
     vec4 view_pos_vec4 = view * world_pos_vec4;
     view_pos = view_pos_vec4.xyz;
@@ -1,8 +1,23 @@
 #version 440
 
 layout(location = 0) in vec3 position;
+// Per instance, see InstanceBuffer::InstanceAttribute
+layout(location = 8) in mat4 m;
 
-uniform mat4 vp;
-uniform mat4 m;
+// Per view constants, mirrors ViewConstants in GraphicsSystem.h
+layout(std140, binding = 0) uniform ViewConstants
+{
+    mat4 proj;
+    mat4 view;
+    mat4 cascadeViewProjections[4];
+    vec4 cascadeSplits;  // View depth where each cascade ends
+    vec3 lightDirection;
+    float bias;
+    vec3 lightColor;
+    vec2 shadowMapSize;
+};
 
-void main() { gl_Position = vp * m * vec4(position, 1); }
+// Atlas tile that is rendered
+uniform int cascade;
+
+void main() { gl_Position = cascadeViewProjections[cascade] * m * vec4(position, 1); }
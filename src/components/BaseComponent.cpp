@@ -5,7 +5,12 @@
  */
 
 #include "BaseComponent.h"
+#include "gameobjects/Actor.h"
 
 namespace DG
 {
+BaseComponent::BaseComponent(Actor* actor)
+    : _actor(actor), _handle(actor->GetGameWorld()->TakeConstructingComponentHandle())
+{
+}
 }  // namespace DG
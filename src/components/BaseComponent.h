@@ -5,6 +5,7 @@
  */
 
 #pragma once
+#include "engine/Handle.h"
 #include "engine/Type.h"
 
 namespace DG
@@ -12,18 +13,33 @@ namespace DG
 class GameWorld;
 class Actor;
 
+// Picks constructors that leave the world alone. World files restore members as raw bytes and only
+// need the vtable pointer of such an object, see GetComponentTypeInfo.
+struct RestoreTag
+{
+};
+
 class BaseComponent : public TypeBase
 {
     DECLARE_CLASS_TYPE(BaseComponent, TypeBase)
+    friend class ComponentStorage;
+    friend class GameWorld;
+
    public:
-    BaseComponent(Actor* actor) : _actor(actor) {}
+    // The handle is reserved by the world before construction so constructors can hand it out
+    BaseComponent(Actor* actor);
+    explicit BaseComponent(RestoreTag) {}
 
     Actor* GetOwningActor() const { return _actor; }
+    Handle<BaseComponent> GetHandle() const { return _handle; }
 
    private:
     Actor* _actor;
+    Handle<BaseComponent> _handle;
 };
 
+typedef Handle<BaseComponent> ComponentHandle;
+
 SDL_FORCE_INLINE void SerializeBaseComponent(const BaseComponent* component, nlohmann::json& json)
 {
 }
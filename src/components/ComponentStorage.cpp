@@ -5,48 +5,549 @@
  */
 
 #include "ComponentStorage.h"
+#include <algorithm>
+#include "gameobjects/Actor.h"
 
 namespace DG
 {
-BaseComponentStorage::BaseComponentStorage(StackAllocator *allocator, u32 itemSize)
-    : _itemSize(itemSize), _allocator(allocator)
+static const u32 CACHE_LINE_SIZE = 64;
+
+static u32 AlignToCacheLine(u32 value)
 {
+    return (value + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
 }
 
-void *BaseComponentStorage::CreateComponent()
+struct RegisteredComponentType
 {
-    if (!_nextFree)
-        AllocateNewChunk();
+    const char* Name;
+    const ComponentTypeInfo* (*GetInfo)();
+};
 
-    void *component = _nextFree;
-    _nextFree = *(BaseComponent **)_nextFree;
+// Zero initialized before the components register
+static RegisteredComponentType RegisteredTypes[TypeInfo::MaxTypeCount];
+static u32 RegisteredTypeCount = 0;
 
-    SDL_memset(component, 0, _itemSize);
-    return component;
+bool RegisterComponentType(const char* name, const ComponentTypeInfo* (*getInfo)())
+{
+    Assert(RegisteredTypeCount < TypeInfo::MaxTypeCount);
+    RegisteredTypes[RegisteredTypeCount++] = {name, getInfo};
+    return true;
+}
+
+const ComponentTypeInfo* FindComponentType(const char* name)
+{
+    for (u32 i = 0; i < RegisteredTypeCount; ++i)
+    {
+        if (SDL_strcmp(RegisteredTypes[i].Name, name) == 0)
+            return RegisteredTypes[i].GetInfo();
+    }
+    return nullptr;
+}
+
+void Archetype::GetColumnOffsets(const TypeId* types, u32 count, u32* offsets) const
+{
+    for (u32 i = 0; i < count; ++i)
+    {
+        const s32 column = FindColumn(types[i]);
+        Assert(column >= 0);
+        offsets[i] = ColumnOffsets[column];
+    }
+}
+
+u32 Archetype::GetChunkRowCount(u32 index) const
+{
+    const u32 firstRow = index * ChunkCapacity;
+    const u32 rowsLeft = RowCount - firstRow;
+    return rowsLeft < ChunkCapacity ? rowsLeft : ChunkCapacity;
+}
+
+u8* Archetype::GetComponent(u32 column, u32 row) const
+{
+    u8* chunk = (u8*)Chunks[row / ChunkCapacity];
+    return chunk + ColumnOffsets[column] + (row % ChunkCapacity) * Types[column]->Size;
+}
+
+Actor** Archetype::GetActor(u32 row) const
+{
+    u8* chunk = (u8*)Chunks[row / ChunkCapacity];
+    return (Actor**)(chunk + ActorColumnOffset) + (row % ChunkCapacity);
+}
+
+void ComponentStorage::Initialize(StackAllocator* allocator, HandleTable* handles)
+{
+    _allocator = allocator;
+    _handles = handles;
+}
+
+void ComponentStorage::Shutdown()
+{
+    // Memory belongs to the allocator, only the chunk lists need to go
+    for (Archetype* archetype : _archetypes)
+    {
+        archetype->~Archetype();
+    }
+    _archetypes.clear();
+    _spawnTable = nullptr;
+}
+
+void* ComponentStorage::AddComponent(Actor* actor, const ComponentTypeInfo* info)
+{
+    ArchetypeLocation& location = actor->_location;
+    Archetype* from = location.Table;
+    const TypeMask typeMask = info->Type->Mask;
+    if (location.Reserved & typeMask)
+    {
+        location.Reserved &= ~typeMask;
+        return InitializeComponent(from, location.Row, info);
+    }
+    if (!from && _isSpawning && (_spawnTable->Mask & typeMask))
+    {
+        _isSpawning = false;
+        location.Table = _spawnTable;
+        location.Row = AllocateRow(_spawnTable, actor);
+        location.Reserved = _spawnTable->Mask & ~typeMask;
+        return InitializeComponent(_spawnTable, location.Row, info);
+    }
+
+    // Same types plus the new one, kept sorted
+    const ComponentTypeInfo* types[Archetype::MaxComponentTypes];
+    u32 count = 0;
+    if (from)
+    {
+        Assert(from->FindColumn(info->Type) < 0);  // Only one component per type and actor
+        Assert(from->TypeCount < Archetype::MaxComponentTypes);
+        for (u32 i = 0; i < from->TypeCount; ++i)
+        {
+            if (count == i && from->Types[i]->Type->Index > info->Type->Index)
+                types[count++] = info;
+            types[count++] = from->Types[i];
+        }
+    }
+    if (count == (from ? from->TypeCount : 0))
+        types[count++] = info;
+
+    Archetype* to = FindOrCreateArchetype(types, count);
+    const u32 row = AllocateRow(to, actor);
+    if (from)
+    {
+        MoveComponents(from, location.Row, to, row, location.Reserved);
+        RemoveRow(from, location.Row);
+    }
+    location.Table = to;
+    location.Row = row;
+    return InitializeComponent(to, row, info);
+}
+
+void ComponentStorage::BeginSpawn(const ComponentTypeInfo* const* types, u32 count)
+{
+    Assert(count > 0 && count <= Archetype::MaxComponentTypes);
+    TypeMask mask = 0;
+    for (u32 i = 0; i < count; ++i) mask |= types[i]->Type->Mask;
+
+    if (!_spawnTable || _spawnTable->Mask != mask)
+    {
+        const ComponentTypeInfo* sortedTypes[Archetype::MaxComponentTypes];
+        SDL_memcpy(sortedTypes, types, count * sizeof(types[0]));
+        std::sort(sortedTypes, sortedTypes + count,
+                  [](const ComponentTypeInfo* a, const ComponentTypeInfo* b) {
+                      return a->Type->Index < b->Type->Index;
+                  });
+        _spawnTable = FindOrCreateArchetype(sortedTypes, count);
+    }
+    _isSpawning = true;
+}
+
+void ComponentStorage::EndSpawn(Actor* actor)
+{
+    _isSpawning = false;
+    ArchetypeLocation& location = actor->_location;
+    if (!location.Reserved)
+        return;
+
+    // Nothing was added for some of the types, the row moves to the archetype of the rest
+    Archetype* from = location.Table;
+    const ComponentTypeInfo* types[Archetype::MaxComponentTypes];
+    u32 count = 0;
+    for (u32 i = 0; i < from->TypeCount; ++i)
+    {
+        if (!(from->Types[i]->Type->Mask & location.Reserved))
+            types[count++] = from->Types[i];
+    }
+    location.Reserved = 0;
+
+    if (count == 0)
+    {
+        RemoveRow(from, location.Row);
+        location = ArchetypeLocation();
+        return;
+    }
+
+    // Reserved columns don't exist in there, nothing to skip
+    Archetype* to = FindOrCreateArchetype(types, count);
+    const u32 row = AllocateRow(to, actor);
+    MoveComponents(from, location.Row, to, row, 0);
+    RemoveRow(from, location.Row);
+    location.Table = to;
+    location.Row = row;
+}
+
+void ComponentStorage::RemoveComponent(BaseComponent* component)
+{
+    Actor* actor = component->GetOwningActor();
+    ArchetypeLocation& location = actor->_location;
+    Archetype* from = location.Table;
+    Assert(!location.Reserved);  // Not while the actor is being spawned
+    const s32 removedColumn = from->FindColumn(component->GetInstanceType());
+    Assert(removedColumn >= 0);
+    Assert(from->GetComponent(removedColumn, location.Row) == (u8*)component);
+    DG_TRACK_FREE(from->Types[removedColumn]->Tag, from->Types[removedColumn]->Size);
+    _handles->Destroy(component->GetHandle().Index);
+    component->~BaseComponent();
+
+    if (from->TypeCount == 1)
+    {
+        RemoveRow(from, location.Row);
+        location = ArchetypeLocation();
+        return;
+    }
+
+    const ComponentTypeInfo* types[Archetype::MaxComponentTypes];
+    u32 count = 0;
+    for (u32 i = 0; i < from->TypeCount; ++i)
+    {
+        if ((s32)i != removedColumn)
+            types[count++] = from->Types[i];
+    }
+
+    Archetype* to = FindOrCreateArchetype(types, count);
+    const u32 row = AllocateRow(to, actor);
+    MoveComponents(from, location.Row, to, row, 0);
+    RemoveRow(from, location.Row);
+    location.Table = to;
+    location.Row = row;
+}
+
+void ComponentStorage::RemoveAllComponents(Actor* actor)
+{
+    ArchetypeLocation& location = actor->_location;
+    if (!location.Table)
+        return;
+    Assert(!location.Reserved);
+
+    for (u32 i = 0; i < location.Table->TypeCount; ++i)
+    {
+        DG_TRACK_FREE(location.Table->Types[i]->Tag, location.Table->Types[i]->Size);
+    }
+    DestroyRow(location.Table, location.Row);
+    RemoveRow(location.Table, location.Row);
+    location = ArchetypeLocation();
+}
+
+Archetype* ComponentStorage::FindOrCreateArchetype(const ComponentTypeInfo** types, u32 count)
+{
+    TypeMask mask = 0;
+    for (u32 i = 0; i < count; ++i) mask |= types[i]->Type->Mask;
+
+    for (Archetype* archetype : _archetypes)
+    {
+        if (archetype->Mask == mask)
+            return archetype;
+    }
+
+    Archetype* archetype = _allocator->PushAndConstruct<Archetype>();
+    archetype->TypeCount = count;
+    archetype->Mask = mask;
+    SDL_memset(archetype->ColumnByType, -1, sizeof(archetype->ColumnByType));
+    u32 rowSize = sizeof(Actor*);
+    for (u32 i = 0; i < count; ++i)
+    {
+        archetype->Types[i] = types[i];
+        archetype->ColumnByType[types[i]->Type->Index] = (s8)i;
+        rowSize += types[i]->Size;
+    }
+
+    // Every column can lose up to a cache line to alignment
+    const u32 headerSize = AlignToCacheLine(sizeof(ArchetypeChunk));
+    const u32 usableSize = Archetype::ChunkSize - headerSize - (count + 1) * CACHE_LINE_SIZE;
+    archetype->ChunkCapacity = usableSize / rowSize;
+    Assert(archetype->ChunkCapacity > 0);
+
+    u32 offset = headerSize;
+    archetype->ActorColumnOffset = offset;
+    offset = AlignToCacheLine(offset + archetype->ChunkCapacity * (u32)sizeof(Actor*));
+    for (u32 i = 0; i < count; ++i)
+    {
+        archetype->ColumnOffsets[i] = offset;
+        offset = AlignToCacheLine(offset + archetype->ChunkCapacity * types[i]->Size);
+    }
+    Assert(offset <= Archetype::ChunkSize);
+
+    _archetypes.push_back(archetype);
+    return archetype;
+}
+
+u32 ComponentStorage::AllocateRow(Archetype* archetype, Actor* actor)
+{
+    const u32 row = archetype->RowCount;
+    if (row / archetype->ChunkCapacity == archetype->Chunks.size())
+    {
+        archetype->Chunks.push_back(
+            (ArchetypeChunk*)_allocator->Push(Archetype::ChunkSize, CACHE_LINE_SIZE));
+    }
+    archetype->RowCount++;
+    archetype->Chunks[row / archetype->ChunkCapacity]->Count =
+        archetype->GetChunkRowCount(row / archetype->ChunkCapacity);
+    *archetype->GetActor(row) = actor;
+    return row;
+}
+
+void ComponentStorage::Defragment()
+{
+    std::vector<std::pair<u32, u32>> order;  // Actor handle index, row
+    std::vector<u8> savedRow;
+    for (Archetype* archetype : _archetypes)
+    {
+        order.clear();
+        for (u32 row = 0; row < archetype->RowCount; ++row)
+        {
+            order.emplace_back((*archetype->GetActor(row))->GetHandle().Index, row);
+        }
+        std::sort(order.begin(), order.end());
+
+        u32 rowSize = 0;
+        for (u32 i = 0; i < archetype->TypeCount; ++i) rowSize += archetype->Types[i]->Size;
+        savedRow.resize(rowSize);
+
+        // order[row].second is the row that has to end up in row, walk every cycle once
+        for (u32 start = 0; start < archetype->RowCount; ++start)
+        {
+            if (order[start].second == start)
+                continue;
+
+            Actor* savedActor = *archetype->GetActor(start);
+            u8* saved = savedRow.data();
+            for (u32 i = 0; i < archetype->TypeCount; ++i)
+            {
+                SDL_memcpy(saved, archetype->GetComponent(i, start), archetype->Types[i]->Size);
+                saved += archetype->Types[i]->Size;
+            }
+
+            u32 row = start;
+            while (order[row].second != start)
+            {
+                const u32 source = order[row].second;
+                *archetype->GetActor(row) = *archetype->GetActor(source);
+                for (u32 i = 0; i < archetype->TypeCount; ++i)
+                {
+                    SDL_memcpy(archetype->GetComponent(i, row), archetype->GetComponent(i, source),
+                               archetype->Types[i]->Size);
+                }
+                order[row].second = row;
+                row = source;
+            }
+
+            *archetype->GetActor(row) = savedActor;
+            saved = savedRow.data();
+            for (u32 i = 0; i < archetype->TypeCount; ++i)
+            {
+                SDL_memcpy(archetype->GetComponent(i, row), saved, archetype->Types[i]->Size);
+                saved += archetype->Types[i]->Size;
+            }
+            order[row].second = row;
+        }
+
+        for (u32 row = 0; row < archetype->RowCount; ++row)
+        {
+            (*archetype->GetActor(row))->_location.Row = row;
+            for (u32 i = 0; i < archetype->TypeCount; ++i)
+            {
+                BaseComponent* component = (BaseComponent*)archetype->GetComponent(i, row);
+                _handles->Relocate(component->GetHandle().Index, component);
+            }
+        }
+    }
 }
 
-void BaseComponentStorage::DestroyComponent(BaseComponent *component)
+void ComponentStorage::CloneInto(ComponentStorage* target, std::ptrdiff_t actorOffset) const
 {
-    *(BaseComponent **)component = _nextFree;
-    _nextFree = component;
+    Assert(target->_archetypes.empty());
+    for (Archetype* archetype : _archetypes)
+    {
+        // Same types give the same layout
+        Archetype* to = target->FindOrCreateArchetype(archetype->Types, archetype->TypeCount);
+        Assert(to->ChunkCapacity == archetype->ChunkCapacity);
+        to->RowCount = archetype->RowCount;
+
+        const u32 chunkCount = archetype->GetChunkCount();
+        for (u32 i = 0; i < chunkCount; ++i)
+        {
+            const u8* from = (const u8*)archetype->GetChunk(i);
+            u8* chunk = target->_allocator->Push(Archetype::ChunkSize, CACHE_LINE_SIZE);
+            to->Chunks.push_back((ArchetypeChunk*)chunk);
+
+            const u32 count = archetype->GetChunk(i)->Count;
+            ((ArchetypeChunk*)chunk)->Count = count;
+            SDL_memcpy(chunk + to->ActorColumnOffset, from + archetype->ActorColumnOffset,
+                       count * sizeof(Actor*));
+            for (u32 column = 0; column < to->TypeCount; ++column)
+            {
+                SDL_memcpy(chunk + to->ColumnOffsets[column],
+                           from + archetype->ColumnOffsets[column],
+                           count * to->Types[column]->Size);
+            }
+
+            // Only the owner pointers lead back into the old world, handles stay the same
+            Actor** actors = (Actor**)(chunk + to->ActorColumnOffset);
+            for (u32 row = 0; row < count; ++row)
+            {
+                actors[row] = (Actor*)((u8*)actors[row] + actorOffset);
+                actors[row]->_location.Table = to;
+            }
+            for (u32 column = 0; column < to->TypeCount; ++column)
+            {
+                u8* component = chunk + to->ColumnOffsets[column];
+                for (u32 row = 0; row < count; ++row, component += to->Types[column]->Size)
+                {
+                    ((BaseComponent*)component)->_actor = actors[row];
+                    target->_handles->Relocate(((BaseComponent*)component)->GetHandle().Index,
+                                               component);
+                }
+            }
+        }
+
+        for (u32 column = 0; column < to->TypeCount; ++column)
+        {
+            DG_TRACK_ALLOCATION(to->Types[column]->Tag, to->RowCount * to->Types[column]->Size);
+        }
+    }
+}
+
+void ComponentStorage::SaveRows(const Archetype* archetype, u32* actors, u8* const* columns) const
+{
+    const u32 chunkCount = archetype->GetChunkCount();
+    u32 firstRow = 0;
+    for (u32 i = 0; i < chunkCount; ++i)
+    {
+        const u8* chunk = (const u8*)archetype->GetChunk(i);
+        const u32 count = archetype->GetChunk(i)->Count;
+        Actor* const* owners = (Actor* const*)(chunk + archetype->ActorColumnOffset);
+        for (u32 row = 0; row < count; ++row) actors[firstRow + row] = owners[row]->_worldIndex;
+
+        for (u32 column = 0; column < archetype->TypeCount; ++column)
+        {
+            const u32 size = archetype->Types[column]->Size;
+            u8* destination = columns[column] + firstRow * size;
+            SDL_memcpy(destination, chunk + archetype->ColumnOffsets[column], count * size);
+            for (u32 row = 0; row < count; ++row, destination += size)
+            {
+                ((BaseComponent*)destination)->_actor =
+                    (Actor*)(uintptr_t)actors[firstRow + row];
+                SDL_memset(destination, 0, sizeof(void*));
+            }
+        }
+        firstRow += count;
+    }
 }
 
-void BaseComponentStorage::AllocateNewChunk()
+void ComponentStorage::LoadRows(const ComponentTypeInfo* const* types, u32 count, u32 rowCount,
+                                Actor* const* actors, const u8* const* columns,
+                                void** handleObjects, u32 handleCount)
 {
-    ChunkHeader **c = &_baseChunk;
-    while (*c) c = &((*c)->Next);
+    // Files keep the types in the order of the saving process, indices may differ here
+    const ComponentTypeInfo* sortedTypes[Archetype::MaxComponentTypes];
+    SDL_memcpy(sortedTypes, types, count * sizeof(types[0]));
+    std::sort(sortedTypes, sortedTypes + count,
+              [](const ComponentTypeInfo* a, const ComponentTypeInfo* b) {
+                  return a->Type->Index < b->Type->Index;
+              });
+    Archetype* archetype = FindOrCreateArchetype(sortedTypes, count);
 
-    u8 *chunk = _allocator->Push(sizeof(ChunkHeader) + _itemSize * ChunkSize, 4);
-    ChunkHeader *allocatedChunk = (ChunkHeader *)chunk;
-    *c = allocatedChunk;
-    allocatedChunk->Data = (u8 *)(chunk + sizeof(ChunkHeader));
+    const u32 firstRow = archetype->RowCount;
+    for (u32 i = 0; i < rowCount; ++i)
+    {
+        actors[i]->_location.Table = archetype;
+        actors[i]->_location.Row = AllocateRow(archetype, actors[i]);
+    }
 
-    _nextFree = (BaseComponent *)allocatedChunk->Data;
-    for (u32 i = 0; i < ChunkSize - 1; ++i)
+    for (u32 i = 0; i < count; ++i)
+    {
+        const u32 column = (u32)archetype->FindColumn(types[i]->Type);
+        const u32 size = types[i]->Size;
+        Assert(types[i]->VTable);
+        DG_TRACK_ALLOCATION(types[i]->Tag, rowCount * size);
+
+        // One copy per chunk, then patch what was swapped out by SaveRows
+        u32 copied = 0;
+        while (copied < rowCount)
+        {
+            const u32 row = firstRow + copied;
+            const u32 chunkRows = archetype->ChunkCapacity - row % archetype->ChunkCapacity;
+            const u32 runCount = rowCount - copied < chunkRows ? rowCount - copied : chunkRows;
+            u8* component = archetype->GetComponent(column, row);
+            SDL_memcpy(component, columns[i] + copied * size, runCount * size);
+            for (u32 j = 0; j < runCount; ++j, component += size)
+            {
+                SDL_memcpy(component, &types[i]->VTable, sizeof(void*));
+                ((BaseComponent*)component)->_actor = actors[copied + j];
+                // Callers check the handles before anything is loaded
+                const u32 handleIndex = ((BaseComponent*)component)->GetHandle().Index;
+                Assert(handleIndex && handleIndex < handleCount && !handleObjects[handleIndex]);
+                handleObjects[handleIndex] = component;
+            }
+            copied += runCount;
+        }
+    }
+}
+
+void ComponentStorage::MoveComponents(const Archetype* from, u32 fromRow, const Archetype* to,
+                                      u32 toRow, TypeMask reserved)
+{
+    for (u32 i = 0; i < from->TypeCount; ++i)
+    {
+        const s32 column = to->FindColumn(from->Types[i]->Type);
+        if (column < 0 || (from->Types[i]->Type->Mask & reserved))
+            continue;
+
+        u8* source = from->GetComponent(i, fromRow);
+        u8* destination = to->GetComponent(column, toRow);
+        SDL_memcpy(destination, source, from->Types[i]->Size);
+        _handles->Relocate(((BaseComponent*)destination)->GetHandle().Index, destination);
+    }
+}
+
+void* ComponentStorage::InitializeComponent(Archetype* archetype, u32 row,
+                                            const ComponentTypeInfo* info)
+{
+    DG_TRACK_ALLOCATION(info->Tag, info->Size);
+    u8* component = archetype->GetComponent(archetype->FindColumn(info->Type), row);
+    SDL_memset(component, 0, info->Size);
+    return component;
+}
+
+void ComponentStorage::DestroyRow(const Archetype* archetype, u32 row)
+{
+    for (u32 i = 0; i < archetype->TypeCount; ++i)
+    {
+        BaseComponent* component = (BaseComponent*)archetype->GetComponent(i, row);
+        _handles->Destroy(component->GetHandle().Index);
+        component->~BaseComponent();
+    }
+}
+
+void ComponentStorage::RemoveRow(Archetype* archetype, u32 row)
+{
+    const u32 lastRow = archetype->RowCount - 1;
+    if (row != lastRow)
     {
-        *(u8 **)(allocatedChunk->Data + i * _itemSize) = (allocatedChunk->Data + i * _itemSize + 1);
+        // Keep the rows packed, the last one fills the hole
+        Actor* movedActor = *archetype->GetActor(lastRow);
+        MoveComponents(archetype, lastRow, archetype, row, movedActor->_location.Reserved);
+        *archetype->GetActor(row) = movedActor;
+        movedActor->_location.Row = row;
     }
 
-    *(u8 **)(allocatedChunk->Data + (ChunkSize - 1) * _itemSize) = nullptr;
+    archetype->RowCount--;
+    const u32 lastChunk = lastRow / archetype->ChunkCapacity;
+    archetype->Chunks[lastChunk]->Count = archetype->GetChunkRowCount(lastChunk);
 }
 }  // namespace DG
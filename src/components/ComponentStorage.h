@@ -5,66 +5,231 @@
  */
 
 #pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "BaseComponent.h"
+#include "engine/Handle.h"
 #include "engine/Types.h"
 #include "memory/Memory.h"
 
 namespace DG
 {
-class BaseComponentStorage
+struct ComponentTypeInfo
 {
-    enum
+    typedef void (*ConstructFunction)(void* memory);
+
+    TypeId Type;
+    u32 Size;
+    MemoryTag Tag;
+    const void* VTable;           // Null if T has no RestoreTag constructor and can't be loaded
+    ConstructFunction Construct;  // Placement news T with the RestoreTag constructor
+};
+
+// JSON levels build components with this, fields the file leaves out keep their defaults
+template <class T>
+void ConstructForRestore(void* memory)
+{
+    new (memory) T(RestoreTag());
+}
+
+// Builds a throwaway T with the RestoreTag constructor and keeps its vtable pointer. The object is
+// never destroyed, destructors of components talk to the world.
+template <class T>
+const void* GetRestoreVTable()
+{
+    if constexpr (std::is_constructible<T, RestoreTag>::value)
     {
-        ChunkSize = 64
-    };
+        alignas(T) u8 memory[sizeof(T)];
+        const void* vtable;
+        SDL_memcpy(&vtable, new (memory) T(RestoreTag()), sizeof(vtable));
+        return vtable;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
 
-   public:
-    void DestroyComponent(BaseComponent *component);
+template <class T>
+ComponentTypeInfo::ConstructFunction GetRestoreConstructor()
+{
+    if constexpr (std::is_constructible<T, RestoreTag>::value)
+        return &ConstructForRestore<T>;
+    else
+        return nullptr;
+}
 
-   protected:
-    BaseComponentStorage(StackAllocator *allocator, u32 itemSize);
+template <class T>
+const ComponentTypeInfo* GetComponentTypeInfo()
+{
+    static const ComponentTypeInfo info = [] {
+        ComponentTypeInfo result = {T::GetClassType(), (u32)sizeof(T), 0, GetRestoreVTable<T>(),
+                                    GetRestoreConstructor<T>()};
+#if DG_MEMORY_TRACKING
+        char tagName[64];
+        SDL_snprintf(tagName, sizeof(tagName), "ComponentStorage<%s>",
+                     T::GetClassType()->Name);
+        result.Tag = RegisterMemoryTag(tagName);
+#endif
+        return result;
+    }();
+    return &info;
+}
 
-    void *CreateComponent();
+// Loading a world file looks component types up by name, before any component of the type might
+// exist. Register with DG_REGISTER_COMPONENT in the .cpp of the component, the info itself is only
+// created on the first lookup.
+bool RegisterComponentType(const char* name, const ComponentTypeInfo* (*getInfo)());
+const ComponentTypeInfo* FindComponentType(const char* name);
 
-   private:
-    void AllocateNewChunk();
+#define DG_REGISTER_COMPONENT(Class)                 \
+    static const bool Is##Class##StorageRegistered = \
+        RegisterComponentType(STRFY(Class), &GetComponentTypeInfo<Class>);
+
+// Rows live in fixed size chunks. Every chunk starts with the owning actors, followed by one cache
+// line aligned column per component type. Row r sits in chunk r / ChunkCapacity.
+struct ArchetypeChunk
+{
+    u32 Count;
+};
 
-    struct ChunkHeader
+// All actors with exactly the same set of component types, one component per type
+class Archetype
+{
+   public:
+    enum
     {
-        ChunkHeader *Next;
-        u8 *Data;
+        MaxComponentTypes = 16,
+        ChunkSize = 16 * 1024
     };
 
-    static_assert(sizeof(ChunkHeader) % 4 == 0);  // To not loose alignment for data
+    s32 FindColumn(TypeId type) const { return ColumnByType[type->Index]; }
+    // All of the types have to be present, offsets are relative to the chunk
+    void GetColumnOffsets(const TypeId* types, u32 count, u32* offsets) const;
+
+    u32 GetChunkCount() const { return (RowCount + ChunkCapacity - 1) / ChunkCapacity; }
+    ArchetypeChunk* GetChunk(u32 index) const { return Chunks[index]; }
+    u32 GetChunkRowCount(u32 index) const;
+
+    u8* GetComponent(u32 column, u32 row) const;
+    Actor** GetActor(u32 row) const;
 
-    u32 _itemSize;
-    StackAllocator *_allocator;
-    ChunkHeader *_baseChunk = nullptr;
-    BaseComponent *_nextFree = nullptr;
+    const ComponentTypeInfo* Types[MaxComponentTypes];  // Sorted by type index
+    u32 ColumnOffsets[MaxComponentTypes];
+    s8 ColumnByType[TypeInfo::MaxTypeCount];  // -1 if the archetype doesn't have the type
+    TypeMask Mask = 0;
+    u32 TypeCount = 0;
+    u32 ActorColumnOffset = 0;
+    u32 ChunkCapacity = 0;
+    u32 RowCount = 0;
+    std::vector<ArchetypeChunk*> Chunks;  // Chunks are kept around once allocated
 };
-template <class T>
-class ComponentStorage : public BaseComponentStorage
+
+struct ArchetypeLocation
 {
-    // static_assert(std::is_base_of<BaseComponent<T>, T>::value, "T not derived from
-    // BaseComponent");
-    static_assert(sizeof(T *) <= sizeof(T));
+    Archetype* Table = nullptr;
+    u32 Row = 0;
+    TypeMask Reserved = 0;  // Columns of the row whose component isn't constructed yet
+};
 
+// Components grouped by archetype so a query walks packed columns instead of actors.
+// Rows stay packed: removing one moves the last row into the hole, adding or removing a component
+// moves the actor to another archetype. Every move updates the handle table, hold on to
+// ComponentHandles, raw pointers go stale. No structural changes while iterating!
+class ComponentStorage
+{
    public:
-    ComponentStorage(StackAllocator *allocator);
+    void Initialize(StackAllocator* allocator, HandleTable* handles);
+
+    // Returns zeroed memory for the new component, construct it in place
+    void* AddComponent(Actor* actor, const ComponentTypeInfo* info);
+    // For spawns whose components are known up front. The first component of the next actor puts
+    // it straight into the archetype of types, the other types are reserved in its row until added.
+    // EndSpawn drops the reservations nothing was added for.
+    void BeginSpawn(const ComponentTypeInfo* const* types, u32 count);
+    void EndSpawn(Actor* actor);
+    // Removing calls the destructor, Shutdown just drops the memory
+    void RemoveComponent(BaseComponent* component);
+    void RemoveAllComponents(Actor* actor);
+    // Sorts the rows of every archetype by owning actor, swap removes scramble the order over time
+    void Defragment();
+    // Copies every row into the empty target column by column. The actors have to be copied
+    // already, actorOffset moves a pointer to an actor of this storage to its copy.
+    void CloneInto(ComponentStorage* target, std::ptrdiff_t actorOffset) const;
+    void Shutdown();
+
+    const std::vector<Archetype*>& GetArchetypes() const { return _archetypes; }
+    // World files keep an archetype as one packed column per type. Saving writes the world index
+    // of the owner per row and the components as raw bytes, with the vtable pointer cleared and
+    // the owner pointer swapped for the world index.
+    void SaveRows(const Archetype* archetype, u32* actors, u8* const* columns) const;
+    // Appends rowCount rows of the types, columns as written by SaveRows in the order of types.
+    // Vtables and owners are restored, handles are not: handleObjects[index] receives every
+    // component for HandleTable::Restore.
+    void LoadRows(const ComponentTypeInfo* const* types, u32 count, u32 rowCount,
+                  Actor* const* actors, const u8* const* columns, void** handleObjects,
+                  u32 handleCount);
 
-    T *CreateComponent();
+    // Calls function(T0&, T1&, ...) for every actor that has all of the exact types
+    template <class... Ts, class Function>
+    void Each(Function&& function) const;
+
+   private:
+    Archetype* FindOrCreateArchetype(const ComponentTypeInfo** types, u32 count);
+    u32 AllocateRow(Archetype* archetype, Actor* actor);
+    void* InitializeComponent(Archetype* archetype, u32 row, const ComponentTypeInfo* info);
+    // Reserved columns hold no component yet and are skipped
+    void MoveComponents(const Archetype* from, u32 fromRow, const Archetype* to, u32 toRow,
+                        TypeMask reserved);
+    void RemoveRow(Archetype* archetype, u32 row);
+    void DestroyRow(const Archetype* archetype, u32 row);
+
+    template <class... Ts, class Function, size_t... I>
+    static void EachInChunk(u8* chunk, const u32* offsets, u32 count, Function& function,
+                            std::index_sequence<I...>);
+
+    StackAllocator* _allocator = nullptr;
+    HandleTable* _handles = nullptr;
+    std::vector<Archetype*> _archetypes;
+    Archetype* _spawnTable = nullptr;  // Kept between spawns, groups of them share it
+    bool _isSpawning = false;
 };
 
-template <class T>
-ComponentStorage<T>::ComponentStorage(StackAllocator *allocator)
-    : BaseComponentStorage(allocator, sizeof(T))
+template <class... Ts, class Function>
+void ComponentStorage::Each(Function&& function) const
 {
+    static_assert(sizeof...(Ts) > 0, "Each needs at least one component type");
+    const TypeId types[] = {Ts::GetClassType()...};
+    TypeMask mask = 0;
+    for (TypeId type : types) mask |= type->Mask;
+    u32 offsets[sizeof...(Ts)];
+
+    for (const Archetype* archetype : _archetypes)
+    {
+        if (archetype->RowCount == 0 || (archetype->Mask & mask) != mask)
+            continue;
+        archetype->GetColumnOffsets(types, sizeof...(Ts), offsets);
+
+        const u32 chunkCount = archetype->GetChunkCount();
+        for (u32 i = 0; i < chunkCount; ++i)
+        {
+            ArchetypeChunk* chunk = archetype->GetChunk(i);
+            EachInChunk<Ts...>((u8*)chunk, offsets, chunk->Count, function,
+                               std::index_sequence_for<Ts...>{});
+        }
+    }
 }
 
-template <class T>
-T *ComponentStorage<T>::CreateComponent()
+template <class... Ts, class Function, size_t... I>
+void ComponentStorage::EachInChunk(u8* chunk, const u32* offsets, u32 count, Function& function,
+                                   std::index_sequence<I...>)
 {
-    return (T *)BaseComponentStorage::CreateComponent();
+    for (u32 row = 0; row < count; ++row)
+    {
+        function(((Ts*)(chunk + offsets[I]))[row]...);
+    }
 }
-
 }  // namespace DG
@@ -8,15 +8,40 @@
 
 namespace DG
 {
-mat4 SceneComponent::GetGlobalModelMatrix() const
+DG_REGISTER_COMPONENT(SceneComponent)
+
+SceneComponent::SceneComponent(Actor* actor)
+    : BaseComponent(actor), _parent(actor->GetRootSceneComponentHandle())
+{
+    const SceneComponent* parent = actor->GetGameWorld()->Resolve(_parent);
+    _transformId = GetTransformHierarchy()->AddNode(
+        parent ? parent->_transformId : InvalidTransformId, _transform.GetModelMatrix());
+}
+
+SceneComponent::~SceneComponent()
+{
+    GetOwningActor()->GetGameWorld()->RemoveSpatialBounds(_transformId);
+    GetTransformHierarchy()->RemoveNode(_transformId);
+}
+
+const mat4& SceneComponent::GetGlobalModelMatrix() const
+{
+    return GetTransformHierarchy()->GetWorldMatrix(_transformId);
+}
+
+void SceneComponent::SetLocalTransform(const Transform& transform)
+{
+    _transform = transform;
+    GetTransformHierarchy()->SetLocalMatrix(_transformId, _transform.GetModelMatrix());
+}
+
+void SceneComponent::SetLocalBounds(const AABB& local)
+{
+    GetOwningActor()->GetGameWorld()->SetSpatialBounds(this, local);
+}
+
+TransformHierarchy* SceneComponent::GetTransformHierarchy() const
 {
-    auto parent = _parent;
-    mat4 model = _transform.GetModelMatrix();
-    while (parent)
-    {
-        model = parent->_transform.GetModelMatrix() * model;
-        parent = parent->_parent;
-    }
-    return model;
+    return GetOwningActor()->GetGameWorld()->GetTransformHierarchy();
 }
 }  // namespace DG
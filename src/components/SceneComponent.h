@@ -6,6 +6,7 @@
 
 #pragma once
 #include "BaseComponent.h"
+#include "math/BoundingBox.h"
 #include "math/Transform.h"
 #include "gameobjects/Actor.h"
 namespace DG
@@ -13,18 +14,29 @@ namespace DG
 class SceneComponent : public BaseComponent
 {
     DECLARE_CLASS_TYPE(SceneComponent, BaseComponent)
+    friend class GameWorld;
+
    public:
-    explicit SceneComponent(Actor* actor) : BaseComponent(actor)
-    {
-        auto parent = actor->GetRootSceneComponent();
-        if (parent != this)
-            _parent = parent;
-    }
+    // The root scene component is created first and ends up without a parent
+    explicit SceneComponent(Actor* actor);
+    explicit SceneComponent(RestoreTag tag) : BaseComponent(tag) {}
+    ~SceneComponent();
 
-    mat4 GetGlobalModelMatrix() const;
+    // World matrices are updated once per frame by GameWorld::Update
+    const mat4& GetGlobalModelMatrix() const;
+    const Transform& GetLocalTransform() const { return _transform; }
+    void SetLocalTransform(const Transform& transform);
 
    protected:
+    // Puts the component into the spatial tree of the world, local is in component space
+    void SetLocalBounds(const AABB& local);
+
     DPROPERTY Transform _transform;
-    DPROPERTY SceneComponent* _parent = nullptr;
+    DPROPERTY Handle<SceneComponent> _parent;
+
+   private:
+    TransformHierarchy* GetTransformHierarchy() const;
+
+    TransformId _transformId;
 };
 }  // namespace DG
@@ -8,4 +8,5 @@
 
 namespace DG
 {
+DG_REGISTER_COMPONENT(StaticMeshComponent)
 }  // namespace DG
@@ -15,22 +15,35 @@ namespace DG
 class StaticMeshComponent : public SceneComponent
 {
     DECLARE_CLASS_TYPE(StaticMeshComponent, SceneComponent)
+    friend class GameWorld;
+
    public:
     StaticMeshComponent(Actor* actor, StringId renderableId, Transform transform)
         : SceneComponent(actor), _renderableId(renderableId)
     {
-        auto model = g_Managers->ModelManager->Exists(renderableId);
-        Assert(model);
-
-        _transform = transform;
-
-        _physicsData = actor->GetGameWorld()->GetPhysicsWorld()->AddStaticModel(
-            *model, _transform.GetModelMatrix() * model->meshes[0].localTransform, this);
+        SetLocalTransform(transform);
+        AddToWorld();
     }
+    explicit StaticMeshComponent(RestoreTag tag) : SceneComponent(tag) {}
 
     StringId GetRenderable() const { return _renderableId; }
 
    private:
+    // Loading checks this before anything is created, AddToWorld needs the model
+    bool HasModel() const { return g_Managers->ModelManager->Exists(_renderableId) != nullptr; }
+    // Also used by GameWorld after loading, the pointer in the file is stale
+    void AddToWorld()
+    {
+        auto model = g_Managers->ModelManager->Exists(_renderableId);
+        Assert(model);
+
+        // PhysX only stores the handle, the component may move
+        _physicsData = GetOwningActor()->GetGameWorld()->GetPhysicsWorld()->AddStaticModel(
+            *model, _transform.GetModelMatrix() * model->meshes[0].localTransform,
+            (void*)(uintptr_t)GetHandle().ToU64());
+        SetLocalBounds(model->aabb);
+    }
+
     void* _physicsData;
     DPROPERTY StringId _renderableId = "";
 };
@@ -1,12 +1,13 @@
 /**
  *  @file    SceneComponent.generated.cpp
  *  @author  Generated by DingoGenerator (written by Faaux)
- *  @date    19 February 2018
+ *  @date    17 October 2026
  *  This file was generated, do not edit!*/
 
 #pragma once
 #include "SceneComponent.generated.h"
 #include "../SceneComponent.h"
+#include "engine/Reflection.h"
 #include "engine/Serialize.h"
 
 namespace DG
@@ -16,4 +17,16 @@ void SerializeSceneComponent(const SceneComponent* item, nlohmann::json& json)
     json["Transform"] = Serialize(item->_transform);
     json["Parent"] = Serialize(item->_parent);
 }
+
+const ClassReflection* ReflectSceneComponent()
+{
+    static const FieldReflection fields[] = {
+        DG_REFLECT_FIELD(SceneComponent, _transform, "Transform"),
+        DG_REFLECT_FIELD(SceneComponent, _parent, "Parent"),
+    };
+    static const ClassReflection reflection = {SceneComponent::GetClassType(),
+                                               sizeof(SceneComponent), fields, COUNT_OF(fields)};
+    return &reflection;
+}
+static const bool IsSceneComponentRegistered = RegisterClassReflection(ReflectSceneComponent());
 }  // namespace DG
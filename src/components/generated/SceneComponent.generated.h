@@ -1,7 +1,7 @@
 /**
  *  @file    SceneComponent.generated.h
  *  @author  Generated by DingoGenerator (written by Faaux)
- *  @date    19 February 2018
+ *  @date    17 October 2026
  *  This file was generated, do not edit!*/
 
 #pragma once
@@ -10,4 +10,5 @@
 namespace DG
 {
 void SerializeSceneComponent(const SceneComponent* item, nlohmann::json& json);
+const ClassReflection* ReflectSceneComponent();
 }  // namespace DG
@@ -1,12 +1,13 @@
 /**
  *  @file    StaticMeshComponent.generated.cpp
  *  @author  Generated by DingoGenerator (written by Faaux)
- *  @date    19 February 2018
+ *  @date    17 October 2026
  *  This file was generated, do not edit!*/
 
 #pragma once
 #include "StaticMeshComponent.generated.h"
 #include "../StaticMeshComponent.h"
+#include "engine/Reflection.h"
 #include "engine/Serialize.h"
 
 namespace DG
@@ -15,4 +16,17 @@ void SerializeStaticMeshComponent(const StaticMeshComponent* item, nlohmann::jso
 {
     json["RenderableId"] = Serialize(item->_renderableId);
 }
+
+const ClassReflection* ReflectStaticMeshComponent()
+{
+    static const FieldReflection fields[] = {
+        DG_REFLECT_FIELD(StaticMeshComponent, _renderableId, "RenderableId"),
+    };
+    static const ClassReflection reflection = {StaticMeshComponent::GetClassType(),
+                                               sizeof(StaticMeshComponent), fields,
+                                               COUNT_OF(fields)};
+    return &reflection;
+}
+static const bool IsStaticMeshComponentRegistered =
+    RegisterClassReflection(ReflectStaticMeshComponent());
 }  // namespace DG
@@ -1,7 +1,7 @@
 /**
  *  @file    StaticMeshComponent.generated.h
  *  @author  Generated by DingoGenerator (written by Faaux)
- *  @date    19 February 2018
+ *  @date    17 October 2026
  *  This file was generated, do not edit!*/
 
 #pragma once
@@ -10,4 +10,5 @@
 namespace DG
 {
 void SerializeStaticMeshComponent(const StaticMeshComponent* item, nlohmann::json& json);
+const ClassReflection* ReflectStaticMeshComponent();
 }  // namespace DG
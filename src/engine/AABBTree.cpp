@@ -0,0 +1,398 @@
+/**
+ *  @file    AABBTree.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "AABBTree.h"
+#include <algorithm>
+
+namespace DG
+{
+static f32 GetSurfaceArea(const AABB& aabb)
+{
+    const vec3 size = aabb.Max - aabb.Min;
+    return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+u32 AABBTree::CreateProxy(const AABB& aabb, u64 userData)
+{
+    u32 proxy;
+    if (!_freeProxies.empty())
+    {
+        proxy = _freeProxies.back();
+        _freeProxies.pop_back();
+    }
+    else
+    {
+        proxy = (u32)_proxies.size();
+        _proxies.push_back({});
+    }
+
+    // A destroyed proxy can still be in the queue, it is reused from there
+    Proxy& entry = _proxies[proxy];
+    entry.Bounds = aabb;
+    entry.UserData = userData;
+    entry.Leaf = InvalidNode;
+    entry.IsAlive = true;
+    if (!entry.IsQueued)
+    {
+        entry.IsQueued = true;
+        _queued.push_back(proxy);
+    }
+    _proxyCount++;
+    return proxy;
+}
+
+void AABBTree::DestroyProxy(u32 proxy)
+{
+    Proxy& entry = _proxies[proxy];
+    Assert(entry.IsAlive);
+    if (entry.Leaf != InvalidNode)
+    {
+        RemoveLeaf(entry.Leaf);
+        FreeNode(entry.Leaf);
+        entry.Leaf = InvalidNode;
+    }
+    entry.IsAlive = false;
+    _freeProxies.push_back(proxy);
+    _proxyCount--;
+}
+
+void AABBTree::MoveProxy(u32 proxy, const AABB& aabb)
+{
+    Proxy& entry = _proxies[proxy];
+    Assert(entry.IsAlive);
+    entry.Bounds = aabb;
+    if (entry.Leaf != InvalidNode && ContainsAABB(entry.Fat, aabb))
+    {
+        _nodes[entry.Leaf].Box = aabb;
+        return;
+    }
+    if (!entry.IsQueued)
+    {
+        entry.IsQueued = true;
+        _queued.push_back(proxy);
+    }
+}
+
+void AABBTree::Update()
+{
+    if (_queued.size() > 64 && _queued.size() * RebuildFraction > _proxyCount)
+    {
+        Rebuild();
+        return;
+    }
+
+    for (u32 proxy : _queued)
+    {
+        Proxy& entry = _proxies[proxy];
+        entry.IsQueued = false;
+        if (!entry.IsAlive)
+            continue;
+
+        if (entry.Leaf == InvalidNode)
+        {
+            entry.Fat = Fatten(entry.Bounds);
+            entry.Leaf = AllocateNode();
+            Node& leaf = _nodes[entry.Leaf];
+            leaf.Box = entry.Bounds;
+            leaf.Proxy = proxy;
+            InsertLeaf(entry.Leaf);
+        }
+        else if (OverlapsAABB(entry.Fat, entry.Bounds))
+        {
+            // Moved a bit too far, growing the ancestors is cheaper than finding a new spot
+            entry.Fat = Fatten(entry.Bounds);
+            _nodes[entry.Leaf].Box = entry.Bounds;
+            RefitLeaf(entry.Leaf);
+        }
+        else
+        {
+            RemoveLeaf(entry.Leaf);
+            entry.Fat = Fatten(entry.Bounds);
+            _nodes[entry.Leaf].Box = entry.Bounds;
+            InsertLeaf(entry.Leaf);
+        }
+    }
+    _queued.clear();
+
+    // Refits only ever grow inner boxes, start over once a good part of the tree went through one
+    if (_refitCount > 64 && _refitCount * 2 > _proxyCount)
+        Rebuild();
+}
+
+void AABBTree::Rebuild()
+{
+    for (u32 proxy : _queued) _proxies[proxy].IsQueued = false;
+    _queued.clear();
+
+    std::vector<u32> proxies;
+    proxies.reserve(_proxyCount);
+    for (u32 i = 0; i < (u32)_proxies.size(); ++i)
+    {
+        Proxy& entry = _proxies[i];
+        if (!entry.IsAlive)
+            continue;
+        entry.Fat = Fatten(entry.Bounds);
+        proxies.push_back(i);
+    }
+
+    _nodes.clear();
+    _freeNodes.clear();
+    _refitCount = 0;
+    _root = InvalidNode;
+    if (proxies.empty())
+        return;
+
+    _nodes.reserve(2 * proxies.size() - 1);
+    _root = BuildRange(proxies.data(), (u32)proxies.size(), InvalidNode);
+}
+
+void AABBTree::Clear()
+{
+    _nodes.clear();
+    _freeNodes.clear();
+    _proxies.clear();
+    _freeProxies.clear();
+    _queued.clear();
+    _root = InvalidNode;
+    _proxyCount = 0;
+    _refitCount = 0;
+}
+
+u32 AABBTree::GetHeight() const { return _root == InvalidNode ? 0 : _nodes[_root].Height; }
+
+bool AABBTree::GetRootAABB(AABB* aabb) const
+{
+    if (_root == InvalidNode)
+        return false;
+    *aabb = _nodes[_root].Box;
+    return true;
+}
+
+AABB AABBTree::Fatten(const AABB& aabb) const
+{
+    return {aabb.Min - vec3(_margin), aabb.Max + vec3(_margin)};
+}
+
+u32 AABBTree::AllocateNode()
+{
+    u32 node;
+    if (!_freeNodes.empty())
+    {
+        node = _freeNodes.back();
+        _freeNodes.pop_back();
+    }
+    else
+    {
+        node = (u32)_nodes.size();
+        _nodes.push_back({});
+    }
+    Node& result = _nodes[node];
+    result.Parent = InvalidNode;
+    result.Children[0] = result.Children[1] = InvalidNode;
+    result.Proxy = InvalidProxy;
+    result.Height = 0;
+    return node;
+}
+
+void AABBTree::FreeNode(u32 node) { _freeNodes.push_back(node); }
+
+u32 AABBTree::BuildRange(u32* proxies, u32 count, u32 parent)
+{
+    const u32 node = AllocateNode();
+    _nodes[node].Parent = parent;
+    if (count == 1)
+    {
+        Proxy& entry = _proxies[proxies[0]];
+        entry.Leaf = node;
+        _nodes[node].Box = entry.Bounds;
+        _nodes[node].Proxy = proxies[0];
+        return node;
+    }
+
+    // Split the centers at the median of the axis they spread most along
+    vec3 centerMin = _proxies[proxies[0]].Fat.Min + _proxies[proxies[0]].Fat.Max;
+    vec3 centerMax = centerMin;
+    for (u32 i = 1; i < count; ++i)
+    {
+        const vec3 center = _proxies[proxies[i]].Fat.Min + _proxies[proxies[i]].Fat.Max;
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+    const vec3 spread = centerMax - centerMin;
+    u32 axis = spread.x > spread.y ? 0 : 1;
+    if (spread.z > spread[axis])
+        axis = 2;
+    const u32 half = count / 2;
+    std::nth_element(proxies, proxies + half, proxies + count, [this, axis](u32 a, u32 b) {
+        return _proxies[a].Fat.Min[axis] + _proxies[a].Fat.Max[axis] <
+               _proxies[b].Fat.Min[axis] + _proxies[b].Fat.Max[axis];
+    });
+
+    // Building the children can reallocate the nodes, no references across the calls
+    const u32 left = BuildRange(proxies, half, node);
+    const u32 right = BuildRange(proxies + half, count - half, node);
+    _nodes[node].Children[0] = left;
+    _nodes[node].Children[1] = right;
+    UpdateInnerNode(node);
+    return node;
+}
+
+void AABBTree::InsertLeaf(u32 leaf)
+{
+    _nodes[leaf].Parent = InvalidNode;
+    if (_root == InvalidNode)
+    {
+        _root = leaf;
+        return;
+    }
+
+    // Walk down to the sibling with the least added surface area
+    const AABB leafBox = GetEnclosedAABB(leaf);
+    u32 index = _root;
+    while (!IsLeaf(index))
+    {
+        const Node& node = _nodes[index];
+        const f32 area = GetSurfaceArea(node.Box);
+        const f32 combinedArea = GetSurfaceArea(CombineAABB(node.Box, leafBox));
+
+        // Making a new parent for this node and the leaf, or pushing the leaf further down
+        const f32 cost = 2.f * combinedArea;
+        const f32 inheritanceCost = 2.f * (combinedArea - area);
+        f32 childCosts[2];
+        for (u32 i = 0; i < 2; ++i)
+        {
+            const u32 child = node.Children[i];
+            const AABB combined = CombineAABB(leafBox, GetEnclosedAABB(child));
+            childCosts[i] = IsLeaf(child)
+                                ? GetSurfaceArea(combined) + inheritanceCost
+                                : GetSurfaceArea(combined) -
+                                      GetSurfaceArea(_nodes[child].Box) + inheritanceCost;
+        }
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = childCosts[0] < childCosts[1] ? node.Children[0] : node.Children[1];
+    }
+
+    const u32 sibling = index;
+    const u32 oldParent = _nodes[sibling].Parent;
+    const u32 newParent = AllocateNode();
+    Node& parent = _nodes[newParent];
+    parent.Parent = oldParent;
+    parent.Children[0] = sibling;
+    parent.Children[1] = leaf;
+    _nodes[sibling].Parent = newParent;
+    _nodes[leaf].Parent = newParent;
+    if (oldParent == InvalidNode)
+    {
+        _root = newParent;
+    }
+    else
+    {
+        Node& grandParent = _nodes[oldParent];
+        grandParent.Children[grandParent.Children[0] == sibling ? 0 : 1] = newParent;
+    }
+    FixUpwards(newParent);
+}
+
+void AABBTree::RemoveLeaf(u32 leaf)
+{
+    if (leaf == _root)
+    {
+        _root = InvalidNode;
+        return;
+    }
+
+    const u32 parent = _nodes[leaf].Parent;
+    const u32 grandParent = _nodes[parent].Parent;
+    const u32* children = _nodes[parent].Children;
+    const u32 sibling = children[0] == leaf ? children[1] : children[0];
+    FreeNode(parent);
+    _nodes[leaf].Parent = InvalidNode;
+
+    _nodes[sibling].Parent = grandParent;
+    if (grandParent == InvalidNode)
+    {
+        _root = sibling;
+        return;
+    }
+    Node& node = _nodes[grandParent];
+    node.Children[node.Children[0] == parent ? 0 : 1] = sibling;
+    FixUpwards(grandParent);
+}
+
+void AABBTree::RefitLeaf(u32 leaf)
+{
+    _refitCount++;
+    for (u32 index = _nodes[leaf].Parent; index != InvalidNode; index = _nodes[index].Parent)
+    {
+        const AABB old = _nodes[index].Box;
+        UpdateInnerNode(index);
+        const AABB& box = _nodes[index].Box;
+        if (old.Min == box.Min && old.Max == box.Max)
+            break;
+    }
+}
+
+void AABBTree::FixUpwards(u32 node)
+{
+    for (u32 index = node; index != InvalidNode; index = _nodes[index].Parent)
+    {
+        index = Balance(index);
+        UpdateInnerNode(index);
+    }
+}
+
+void AABBTree::UpdateInnerNode(u32 node)
+{
+    Node& result = _nodes[node];
+    const u32 left = result.Children[0];
+    const u32 right = result.Children[1];
+    result.Box = CombineAABB(GetEnclosedAABB(left), GetEnclosedAABB(right));
+    result.Height = 1 + glm::max(_nodes[left].Height, _nodes[right].Height);
+}
+
+u32 AABBTree::Balance(u32 a)
+{
+    // Rotates the higher child of a up if the heights of its children differ by more than one
+    if (IsLeaf(a) || _nodes[a].Height < 2)
+        return a;
+
+    const s32 balance = (s32)_nodes[_nodes[a].Children[1]].Height -
+                        (s32)_nodes[_nodes[a].Children[0]].Height;
+    if (balance >= -1 && balance <= 1)
+        return a;
+
+    // up is the child that takes the place of a, a keeps its other child
+    const u32 upSide = balance > 1 ? 1 : 0;
+    const u32 up = _nodes[a].Children[upSide];
+    const u32 upLeft = _nodes[up].Children[0];
+    const u32 upRight = _nodes[up].Children[1];
+
+    _nodes[up].Children[0] = a;
+    _nodes[up].Parent = _nodes[a].Parent;
+    _nodes[a].Parent = up;
+    if (_nodes[up].Parent == InvalidNode)
+    {
+        _root = up;
+    }
+    else
+    {
+        Node& parent = _nodes[_nodes[up].Parent];
+        parent.Children[parent.Children[0] == a ? 0 : 1] = up;
+    }
+
+    // The higher grandchild stays with up, the lower one moves below a
+    const bool isLeftHigher = _nodes[upLeft].Height > _nodes[upRight].Height;
+    const u32 keep = isLeftHigher ? upLeft : upRight;
+    const u32 move = isLeftHigher ? upRight : upLeft;
+    _nodes[up].Children[1] = keep;
+    _nodes[a].Children[upSide] = move;
+    _nodes[move].Parent = a;
+    UpdateInnerNode(a);
+    UpdateInnerNode(up);
+    return up;
+}
+}  // namespace DG
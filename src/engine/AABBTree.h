@@ -0,0 +1,267 @@
+/**
+ *  @file    AABBTree.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <cstring>
+#include <vector>
+#include "engine/Types.h"
+#include "math/BoundingBox.h"
+
+namespace DG
+{
+// Dynamic bounding volume hierarchy over proxies with a box and a u64 of user data each.
+// Every proxy is inserted with a fattened box. Moves that stay inside of it only update the leaf,
+// larger ones are queued and handled in batches by Update: short moves refit the ancestors, jumps
+// remove and reinsert the leaf, and large batches rebuild the whole tree top down. Insertion picks
+// the cheapest sibling by surface area and rotates to keep the tree balanced.
+// Leaves hold the exact box, queries only report proxies whose exact box passes.
+class AABBTree
+{
+   public:
+    enum : u32
+    {
+        InvalidProxy = 0xFFFFFFFF,
+        InvalidNode = 0xFFFFFFFF,
+        // Nodes a query keeps on the stack of the caller, deeper trees spill to the heap
+        QueryStackSize = 128,
+        // Batches above 1 / RebuildFraction of the proxies rebuild the whole tree
+        RebuildFraction = 8
+    };
+
+    // Added to every side of a box on insertion, moves within that are free
+    void SetMargin(f32 margin) { _margin = margin; }
+
+    // The proxy enters the tree with the next Update
+    u32 CreateProxy(const AABB& aabb, u64 userData);
+    void DestroyProxy(u32 proxy);
+    void MoveProxy(u32 proxy, const AABB& aabb);
+
+    // Inserts new proxies and handles the queued moves
+    void Update();
+    // Top down build over all proxies, median split along the longest axis
+    void Rebuild();
+    void Clear();
+
+    const AABB& GetAABB(u32 proxy) const { return _proxies[proxy].Bounds; }
+    // Encloses every proxy in the tree, false while it is empty
+    bool GetRootAABB(AABB* aabb) const;
+    u64 GetUserData(u32 proxy) const { return _proxies[proxy].UserData; }
+    u32 GetProxyCount() const { return _proxyCount; }
+    u32 GetHeight() const;
+
+    // Calls function(u32 proxy, u64 userData) for every proxy in the tree that passes the test.
+    // Queries only read, any number of threads can query at once.
+    template <class Function>
+    void QueryAABB(const AABB& aabb, Function&& function) const;
+    template <class Function>
+    void QuerySphere(vec3 center, f32 radius, Function&& function) const;
+    // Subtrees completely inside the frustum are reported without further tests
+    template <class Function>
+    void QueryFrustum(const Frustum& frustum, Function&& function) const;
+    // Calls f32 function(u32 proxy, u64 userData, f32 distance) for proxies whose box the ray
+    // enters within maxDistance. The result is the new maxDistance: the hit distance to only look
+    // for closer hits, 0 to stop.
+    template <class Function>
+    void RayCast(vec3 origin, vec3 direction, f32 maxDistance, Function&& function) const;
+
+   private:
+    struct Node
+    {
+        AABB Box;  // Exact for leaves, inner nodes enclose the fat boxes of their leaves
+        u32 Parent;
+        u32 Children[2];
+        u32 Proxy;   // InvalidProxy for inner nodes
+        u32 Height;  // 0 for leaves
+    };
+
+    struct Proxy
+    {
+        AABB Bounds;
+        AABB Fat;
+        u64 UserData;
+        u32 Leaf;  // InvalidNode until inserted
+        bool IsAlive;
+        bool IsQueued;
+    };
+
+    // Traversal stack of the queries. Balancing keeps it small, trees built from degenerate boxes
+    // can still go deeper.
+    class QueryStack
+    {
+       public:
+        QueryStack() = default;
+        QueryStack(const QueryStack&) = delete;
+        QueryStack& operator=(const QueryStack&) = delete;
+
+        bool IsEmpty() const { return _count == 0; }
+        u32 Pop() { return _data[--_count]; }
+        void Push(u32 entry)
+        {
+            if (_count == _capacity)
+                Grow();
+            _data[_count++] = entry;
+        }
+
+       private:
+        void Grow()
+        {
+            _capacity *= 2;
+            _heap.resize(_capacity);
+            if (_data == _inline)
+                memcpy(_heap.data(), _inline, sizeof(_inline));
+            _data = _heap.data();
+        }
+
+        u32 _inline[QueryStackSize];
+        std::vector<u32> _heap;
+        u32* _data = _inline;
+        u32 _count = 0;
+        u32 _capacity = QueryStackSize;
+    };
+
+    bool IsLeaf(u32 node) const { return _nodes[node].Proxy != InvalidProxy; }
+    // What the parent has to enclose
+    const AABB& GetEnclosedAABB(u32 node) const
+    {
+        return IsLeaf(node) ? _proxies[_nodes[node].Proxy].Fat : _nodes[node].Box;
+    }
+    AABB Fatten(const AABB& aabb) const;
+
+    u32 AllocateNode();
+    void FreeNode(u32 node);
+    void InsertLeaf(u32 leaf);
+    void RemoveLeaf(u32 leaf);
+    void RefitLeaf(u32 leaf);
+    // Recomputes box and height of node and its ancestors, rotating where needed
+    void FixUpwards(u32 node);
+    u32 Balance(u32 node);
+    void UpdateInnerNode(u32 node);
+    u32 BuildRange(u32* proxies, u32 count, u32 parent);
+
+    std::vector<Node> _nodes;
+    std::vector<u32> _freeNodes;
+    std::vector<Proxy> _proxies;
+    std::vector<u32> _freeProxies;
+    std::vector<u32> _queued;
+    u32 _root = InvalidNode;
+    u32 _proxyCount = 0;
+    u32 _refitCount = 0;  // Since the last rebuild, refits let the inner boxes grow
+    f32 _margin = 0.1f;
+};
+
+template <class Function>
+void AABBTree::QueryAABB(const AABB& aabb, Function&& function) const
+{
+    if (_root == InvalidNode)
+        return;
+
+    QueryStack stack;
+    stack.Push(_root);
+    while (!stack.IsEmpty())
+    {
+        const Node& node = _nodes[stack.Pop()];
+        if (!OverlapsAABB(node.Box, aabb))
+            continue;
+        if (node.Proxy != InvalidProxy)
+        {
+            function(node.Proxy, _proxies[node.Proxy].UserData);
+            continue;
+        }
+        stack.Push(node.Children[0]);
+        stack.Push(node.Children[1]);
+    }
+}
+
+template <class Function>
+void AABBTree::QuerySphere(vec3 center, f32 radius, Function&& function) const
+{
+    if (_root == InvalidNode)
+        return;
+
+    const f32 radiusSquared = radius * radius;
+    QueryStack stack;
+    stack.Push(_root);
+    while (!stack.IsEmpty())
+    {
+        const Node& node = _nodes[stack.Pop()];
+        const vec3 closest = glm::clamp(center, node.Box.Min, node.Box.Max);
+        const vec3 offset = closest - center;
+        if (glm::dot(offset, offset) > radiusSquared)
+            continue;
+        if (node.Proxy != InvalidProxy)
+        {
+            function(node.Proxy, _proxies[node.Proxy].UserData);
+            continue;
+        }
+        stack.Push(node.Children[0]);
+        stack.Push(node.Children[1]);
+    }
+}
+
+template <class Function>
+void AABBTree::QueryFrustum(const Frustum& frustum, Function&& function) const
+{
+    if (_root == InvalidNode)
+        return;
+
+    // The top bit marks nodes below one that was completely inside
+    const u32 insideBit = 0x80000000;
+    QueryStack stack;
+    stack.Push(_root);
+    while (!stack.IsEmpty())
+    {
+        const u32 entry = stack.Pop();
+        const Node& node = _nodes[entry & ~insideBit];
+        u32 childBit = entry & insideBit;
+        if (!childBit)
+        {
+            const FrustumTest test = TestAABBInFrustum(node.Box, frustum);
+            if (test == FrustumTest::Outside)
+                continue;
+            if (test == FrustumTest::Inside)
+                childBit = insideBit;
+        }
+        if (node.Proxy != InvalidProxy)
+        {
+            function(node.Proxy, _proxies[node.Proxy].UserData);
+            continue;
+        }
+        stack.Push(node.Children[0] | childBit);
+        stack.Push(node.Children[1] | childBit);
+    }
+}
+
+template <class Function>
+void AABBTree::RayCast(vec3 origin, vec3 direction, f32 maxDistance, Function&& function) const
+{
+    if (_root == InvalidNode)
+        return;
+
+    // Slab test, infinities take care of axis parallel rays
+    const vec3 inverse = 1.f / direction;
+    QueryStack stack;
+    stack.Push(_root);
+    while (!stack.IsEmpty() && maxDistance > 0.f)
+    {
+        const Node& node = _nodes[stack.Pop()];
+        const vec3 t0 = (node.Box.Min - origin) * inverse;
+        const vec3 t1 = (node.Box.Max - origin) * inverse;
+        const vec3 tMin = glm::min(t0, t1);
+        const vec3 tMax = glm::max(t0, t1);
+        const f32 enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.f));
+        const f32 exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+        if (enter > exit)
+            continue;
+        if (node.Proxy != InvalidProxy)
+        {
+            maxDistance = function(node.Proxy, _proxies[node.Proxy].UserData, enter);
+            continue;
+        }
+        stack.Push(node.Children[0]);
+        stack.Push(node.Children[1]);
+    }
+}
+}  // namespace DG
@@ -26,6 +26,8 @@ class Camera
     vec3 GetUp() const;
     vec3 GetForward() const;
     const quat& GetOrientation() const;
+    float GetNear() const { return _near; }
+    float GetFar() const { return _far; }
     void Set(vec3 newPosition, quat newOrientation);
     void Set(vec3 newPosition, vec3 lookAt);
 
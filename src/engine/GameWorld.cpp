@@ -5,7 +5,13 @@
  */
 
 #include "GameWorld.h"
+#include <algorithm>
+#include "components/StaticMeshComponent.h"
+#include "engine/JsonReader.h"
+#include "engine/Serialize.h"
+#include "engine/WorldFile.h"
 #include "imgui/DG_Imgui.h"
+#include "memory/VirtualMemory.h"
 namespace DG
 {
 void GameWorld::Startup(u8* worldMemory, s32 worldMemorySize)
@@ -13,34 +19,833 @@ void GameWorld::Startup(u8* worldMemory, s32 worldMemorySize)
     Assert(!_isShutdown);
     _worldMemory.Init(worldMemory, worldMemorySize);
     _actorMemory.Init(_worldMemory.Push(worldMemorySize / 10, 16), worldMemorySize / 10);
+    _worldMemory.SetMemoryTag(RegisterMemoryTag("World"));
+    _actorMemory.SetMemoryTag(RegisterMemoryTag("WorldActors"));
+    _componentStorage.Initialize(&_worldMemory, &_handles);
     _physicsWorld.Init(_worldClock);
 }
 
 void GameWorld::Shutdown()
 {
     Assert(!_isShutdown);
+    for (WorldCommandBuffer& buffer : _commandBuffers) buffer.Clear();
     _physicsWorld.Shutdown();
+    _componentStorage.Shutdown();
+    _handles.Clear();
+    _transforms.Clear();
+    _spatialTree.Clear();
+    _spatialBounds.clear();
     _worldMemory.Reset();
     _actorMemory.Reset();
     _isShutdown = true;
 }
 
+void GameWorld::CloneInto(GameWorld* target) const
+{
+    Assert(!_isShutdown && !target->_isShutdown);
+    Assert(target->_actors.empty());
+
+    // Actors are copied with their stack, only the component lists need a proper copy
+    const std::ptrdiff_t actorOffset = target->_actorMemory.CopyFrom(_actorMemory);
+    target->_handles = _handles;
+    target->_actors.resize(_actors.size());
+    for (u32 i = 0; i < (u32)_actors.size(); ++i)
+    {
+        Actor* actor = (Actor*)((u8*)_actors[i] + actorOffset);
+        new (&actor->_components) std::vector<ComponentHandle>(_actors[i]->_components);
+        actor->_gameWorld = target;
+        target->_handles.Relocate(actor->GetHandle().Index, actor);
+        target->_actors[i] = actor;
+    }
+
+    _componentStorage.CloneInto(&target->_componentStorage, actorOffset);
+    target->_transforms = _transforms;
+    target->_spatialTree = _spatialTree;
+    target->_spatialBounds = _spatialBounds;
+    target->_camera = _camera;
+
+    // Static meshes point at their PhysX actor, swap in the copies
+    std::vector<std::pair<void*, void*>> clones;
+    _physicsWorld.CloneStaticModelsInto(&target->_physicsWorld, &clones);
+    for (auto& clone : clones)
+    {
+        BaseComponent* component =
+            target->Resolve(ComponentHandle::FromU64((u64)(uintptr_t)clone.first));
+        if (component && component->IsTypeOrDerivedType(StaticMeshComponent::GetClassType()))
+            ((StaticMeshComponent*)component)->_physicsData = clone.second;
+    }
+}
+
+s32 GameWorld::GetMemorySize() const { return (s32)_worldMemory.GetReservedSize(); }
+
+bool GameWorld::SaveToFile(const char* path) const
+{
+    Assert(!_isShutdown);
+    WorldFileWriter writer;
+    writer.Allocate(sizeof(WorldFileHeader));
+
+    // The type table grows as types come up, the actor type first
+    std::vector<u32> typeIndices(TypeInfo::MaxTypeCount, ~0u);
+    std::vector<TypeId> types;
+    std::vector<const ComponentTypeInfo*> typeInfos;  // Null for the actor type
+    auto findType = [&](TypeId type, const ComponentTypeInfo* info) {
+        if (typeIndices[type->Index] == ~0u)
+        {
+            typeIndices[type->Index] = (u32)types.size();
+            types.push_back(type);
+            typeInfos.push_back(info);
+        }
+        return typeIndices[type->Index];
+    };
+    const u32 actorType = findType(Actor::GetClassType(), nullptr);
+
+    u32 componentHandleCount = 0;
+    for (const Actor* actor : _actors)
+    {
+        if (!actor->IsType<Actor>())
+        {
+            SDL_LogError(0, "Can't save %s, only plain actors can be restored",
+                         actor->GetInstanceType()->Name);
+            return false;
+        }
+        componentHandleCount += (u32)actor->_components.size();
+    }
+
+    const u32 actorCount = (u32)_actors.size();
+    const u64 actorsOffset = writer.Allocate(actorCount * sizeof(WorldFileActor));
+    const u64 componentHandlesOffset =
+        writer.Allocate(componentHandleCount * sizeof(ComponentHandle));
+    WorldFileActor* actors = writer.Get<WorldFileActor>(actorsOffset);
+    ComponentHandle* componentHandles = writer.Get<ComponentHandle>(componentHandlesOffset);
+    u32 firstComponent = 0;
+    for (u32 i = 0; i < actorCount; ++i)
+    {
+        const Actor* actor = _actors[i];
+        actors[i].Type = actorType;
+        actors[i].FirstComponent = firstComponent;
+        actors[i].ComponentCount = (u32)actor->_components.size();
+        actors[i].ActorHandle = actor->_handle;
+        actors[i].RootComponent = actor->_rootSceneComponent;
+        std::copy(actor->_components.begin(), actor->_components.end(),
+                  componentHandles + firstComponent);
+        firstComponent += actors[i].ComponentCount;
+    }
+
+    const std::vector<Archetype*>& archetypes = _componentStorage.GetArchetypes();
+    const u32 archetypeCount = (u32)std::count_if(
+        archetypes.begin(), archetypes.end(), [](const Archetype* a) { return a->RowCount > 0; });
+    const u64 archetypesOffset = writer.Allocate(archetypeCount * sizeof(WorldFileArchetype));
+    std::vector<u32> stringIds;
+    u32 archetypeIndex = 0;
+    for (const Archetype* archetype : archetypes)
+    {
+        if (archetype->RowCount == 0)
+            continue;
+
+        const u64 actorIndicesOffset = writer.Allocate(archetype->RowCount * sizeof(u32));
+        u64 columnOffsets[Archetype::MaxComponentTypes];
+        for (u32 t = 0; t < archetype->TypeCount; ++t)
+        {
+            columnOffsets[t] =
+                writer.Allocate((u64)archetype->RowCount * archetype->Types[t]->Size, 64);
+        }
+
+        u8* columns[Archetype::MaxComponentTypes];
+        for (u32 t = 0; t < archetype->TypeCount; ++t)
+            columns[t] = writer.Get<u8>(columnOffsets[t]);
+        _componentStorage.SaveRows(archetype, writer.Get<u32>(actorIndicesOffset), columns);
+
+        WorldFileArchetype* to =
+            writer.Get<WorldFileArchetype>(archetypesOffset) + archetypeIndex++;
+        to->TypeCount = archetype->TypeCount;
+        to->RowCount = archetype->RowCount;
+        to->Actors.Offset = actorIndicesOffset;
+        for (u32 t = 0; t < archetype->TypeCount; ++t)
+        {
+            to->Types[t] = findType(archetype->Types[t]->Type, archetype->Types[t]);
+            to->Columns[t].Offset = columnOffsets[t];
+            CollectStringIds(archetype->Types[t], columns[t], archetype->RowCount, &stringIds);
+        }
+    }
+
+    const u32 handleSlotCount = _handles.GetSlotCount();
+    const u64 generationsOffset = writer.Allocate(handleSlotCount * sizeof(u32));
+    u32* generations = writer.Get<u32>(generationsOffset);
+    for (u32 i = 0; i < handleSlotCount; ++i) generations[i] = _handles.GetGeneration(i);
+
+    const u32 typeCount = (u32)types.size();
+    const u64 typesOffset = writer.Allocate(typeCount * sizeof(WorldFileType));
+    for (u32 i = 0; i < typeCount; ++i)
+    {
+        const u64 nameOffset = writer.WriteString(types[i]->Name);
+        WorldFileType* type = writer.Get<WorldFileType>(typesOffset) + i;
+        type->Name.Offset = nameOffset;
+        type->Size = typeInfos[i] ? typeInfos[i]->Size : (u32)sizeof(Actor);
+        type->LayoutHash = typeInfos[i] ? GetWorldFileLayoutHash(typeInfos[i]) : 0;
+    }
+
+    std::sort(stringIds.begin(), stringIds.end());
+    stringIds.erase(std::unique(stringIds.begin(), stringIds.end()), stringIds.end());
+    const u32 stringCount = (u32)stringIds.size();
+    const u64 stringsOffset = writer.Allocate(stringCount * sizeof(WorldFileString));
+    for (u32 i = 0; i < stringCount; ++i)
+    {
+        const char* text = FindStringIdText(stringIds[i]);
+        const u64 textOffset = text ? writer.WriteString(text) : 0;
+        WorldFileString* string = writer.Get<WorldFileString>(stringsOffset) + i;
+        string->Hash = stringIds[i];
+        string->Length = text ? (u32)SDL_strlen(text) : 0;
+        string->Text.Offset = textOffset;
+    }
+
+    WorldFileHeader* header = writer.Get<WorldFileHeader>(0);
+    header->Magic = WorldFileMagic;
+    header->Version = WorldFileVersion;
+    header->FileSize = writer.GetSize();
+    header->TypeCount = typeCount;
+    header->ArchetypeCount = archetypeCount;
+    header->ActorCount = actorCount;
+    header->ComponentHandleCount = componentHandleCount;
+    header->HandleSlotCount = handleSlotCount;
+    header->StringCount = stringCount;
+    header->Types.Offset = typesOffset;
+    header->Archetypes.Offset = archetypesOffset;
+    header->Actors.Offset = actorsOffset;
+    header->ComponentHandles.Offset = componentHandlesOffset;
+    header->HandleGenerations.Offset = generationsOffset;
+    header->Strings.Offset = stringsOffset;
+    return writer.WriteToFile(path);
+}
+
+// Parent per handle slot of the loaded scene components. Parents that are no current handle of
+// a loaded scene component and the last link of every cycle are cleared, false if there were any.
+static bool CheckLoadedParents(const char* path, const std::vector<bool>& isScene,
+                               const u32* generations, std::vector<Handle<SceneComponent>>* parents)
+{
+    bool isValid = true;
+    const u32 count = (u32)parents->size();
+    for (u32 i = 0; i < count; ++i)
+    {
+        const Handle<SceneComponent> parent = (*parents)[i];
+        if (!parent || (parent.Index < count && isScene[parent.Index] &&
+                        generations[parent.Index] == parent.Generation))
+            continue;
+        SDL_LogError(0, "%s: parent %llu of component %u is no scene component", path,
+                     (unsigned long long)parent.ToU64(), i);
+        (*parents)[i] = Handle<SceneComponent>();
+        isValid = false;
+    }
+
+    enum : u8
+    {
+        Unvisited,
+        Visiting,
+        Visited
+    };
+    std::vector<u8> states(count, Unvisited);
+    std::vector<u32> chain;
+    for (u32 i = 1; i < count; ++i)
+    {
+        u32 index = i;
+        while (index && states[index] == Unvisited)
+        {
+            states[index] = Visiting;
+            chain.push_back(index);
+            index = (*parents)[index].Index;
+        }
+        if (index && states[index] == Visiting)
+        {
+            SDL_LogError(0, "%s: parents of component %u form a cycle", path, index);
+            (*parents)[chain.back()] = Handle<SceneComponent>();
+            isValid = false;
+        }
+        for (u32 visited : chain) states[visited] = Visited;
+        chain.clear();
+    }
+    return isValid;
+}
+
+bool GameWorld::LoadFromFile(const char* path)
+{
+    Assert(!_isShutdown);
+    Assert(_actors.empty());
+
+    u64 size = 0;
+    u8* file = MapFile(path, &size);
+    if (!file)
+    {
+        SDL_LogError(0, "Couldn't map world file %s", path);
+        return false;
+    }
+    const WorldFileHeader* header = FixupWorldFile(file, size);
+    if (!header)
+    {
+        SDL_LogError(0, "%s is damaged or no world file of version %u", path,
+                     (u32)WorldFileVersion);
+        UnmapFile(file, size);
+        return false;
+    }
+
+    // Check every type before anything is created, the world stays empty on failure
+    const char* actorTypeName = Actor::GetClassType()->Name;
+    std::vector<const ComponentTypeInfo*> types(header->TypeCount);
+    bool isMatching = true;
+    for (u32 i = 0; i < header->TypeCount; ++i)
+    {
+        const WorldFileType& type = header->Types.Pointer[i];
+        if (SDL_strcmp(type.Name.Pointer, actorTypeName) == 0)
+        {
+            isMatching &= type.Size == sizeof(Actor);
+            continue;
+        }
+        types[i] = FindComponentType(type.Name.Pointer);
+        if (!types[i] || !types[i]->VTable || types[i]->Size != type.Size ||
+            GetWorldFileLayoutHash(types[i]) != type.LayoutHash)
+        {
+            SDL_LogError(0, "%s: %s doesn't match this build", path, type.Name.Pointer);
+            isMatching = false;
+        }
+    }
+    for (u32 i = 0; i < header->ActorCount; ++i)
+        isMatching &= types[header->Actors.Pointer[i].Type] == nullptr;
+    for (u32 i = 0; i < header->ArchetypeCount; ++i)
+    {
+        const WorldFileArchetype& archetype = header->Archetypes.Pointer[i];
+        for (u32 t = 0; t < archetype.TypeCount; ++t)
+            isMatching &= types[archetype.Types[t]] != nullptr;
+    }
+    // Roots and parents are used as SceneComponent and static meshes need their model, checked
+    // here as FixupWorldFile only knows handles
+    std::vector<bool> isScene(isMatching ? header->HandleSlotCount : 0, false);
+    std::vector<Handle<SceneComponent>> parents(isScene.size());
+    for (u32 i = 0; isMatching && i < header->ArchetypeCount; ++i)
+    {
+        const WorldFileArchetype& archetype = header->Archetypes.Pointer[i];
+        for (u32 t = 0; t < archetype.TypeCount; ++t)
+        {
+            const ComponentTypeInfo* type = types[archetype.Types[t]];
+            const bool isSceneType = type->Type->Ancestry & SceneComponent::GetClassType()->Mask;
+            const bool isStaticMeshType =
+                type->Type->Ancestry & StaticMeshComponent::GetClassType()->Mask;
+            for (u32 row = 0; row < archetype.RowCount; ++row)
+            {
+                const BaseComponent* component =
+                    (const BaseComponent*)(archetype.Columns[t].Pointer + (u64)row * type->Size);
+                const u32 index = component->GetHandle().Index;
+                if (isSceneType)
+                {
+                    isScene[index] = true;
+                    parents[index] = ((const SceneComponent*)component)->_parent;
+                    if (isStaticMeshType && !((const StaticMeshComponent*)component)->HasModel())
+                    {
+                        SDL_LogError(0, "%s: model of component %u isn't loaded", path, index);
+                        isMatching = false;
+                    }
+                    continue;
+                }
+                const Handle<SceneComponent> root =
+                    header->Actors.Pointer[archetype.Actors.Pointer[row]].RootComponent;
+                if (index == root.Index)
+                {
+                    SDL_LogError(0, "%s: Root of actor %u is no SceneComponent", path,
+                                 archetype.Actors.Pointer[row]);
+                    isMatching = false;
+                }
+            }
+        }
+    }
+    if (isMatching)
+        isMatching = CheckLoadedParents(path, isScene, header->HandleGenerations.Pointer, &parents);
+    if (!isMatching)
+    {
+        SDL_LogError(0, "Couldn't load %s, save it again from a matching build", path);
+        UnmapFile(file, size);
+        return false;
+    }
+
+    std::vector<void*> handleObjects(header->HandleSlotCount, nullptr);
+    _actors.resize(header->ActorCount);
+    for (u32 i = 0; i < header->ActorCount; ++i)
+    {
+        const WorldFileActor& from = header->Actors.Pointer[i];
+        Actor* actor = _actorMemory.PushAndConstruct<Actor>(this, RestoreTag());
+        actor->_handle = from.ActorHandle;
+        actor->_rootSceneComponent = from.RootComponent;
+        actor->_components.assign(header->ComponentHandles.Pointer + from.FirstComponent,
+                                  header->ComponentHandles.Pointer + from.FirstComponent +
+                                      from.ComponentCount);
+        actor->_worldIndex = i;
+        _actors[i] = actor;
+        handleObjects[from.ActorHandle.Index] = actor;
+    }
+
+    std::vector<Actor*> rowActors;
+    for (u32 i = 0; i < header->ArchetypeCount; ++i)
+    {
+        const WorldFileArchetype& archetype = header->Archetypes.Pointer[i];
+        const ComponentTypeInfo* rowTypes[Archetype::MaxComponentTypes];
+        const u8* columns[Archetype::MaxComponentTypes];
+        for (u32 t = 0; t < archetype.TypeCount; ++t)
+        {
+            rowTypes[t] = types[archetype.Types[t]];
+            columns[t] = archetype.Columns[t].Pointer;
+        }
+        rowActors.resize(archetype.RowCount);
+        for (u32 row = 0; row < archetype.RowCount; ++row)
+            rowActors[row] = _actors[archetype.Actors.Pointer[row]];
+        _componentStorage.LoadRows(rowTypes, archetype.TypeCount, archetype.RowCount,
+                                   rowActors.data(), columns, handleObjects.data(),
+                                   header->HandleSlotCount);
+    }
+    _handles.Restore(header->HandleGenerations.Pointer, handleObjects.data(),
+                     header->HandleSlotCount);
+
+    for (u32 i = 0; i < header->StringCount; ++i)
+    {
+        const WorldFileString& string = header->Strings.Pointer[i];
+        if (string.Text.Pointer)
+            AddStringIdText(string.Hash, string.Text.Pointer);
+    }
+    UnmapFile(file, size);
+
+    RegisterLoadedComponents();
+    return true;
+}
+
+bool GameWorld::LoadFromJson(const char* path)
+{
+    Assert(!_isShutdown);
+    Assert(_actors.empty());
+
+    JsonReader reader;
+    if (!reader.Open(path))
+    {
+        SDL_LogError(0, "%s", reader.GetError());
+        return false;
+    }
+
+    // Slot 0 is the null handle, free slots keep the generation of a new table
+    std::vector<u32> generations(1, 0);
+    std::vector<void*> handleObjects(1, nullptr);
+    bool isValid = reader.BeginArray();
+    while (isValid)
+    {
+        const JsonNode* json = reader.ReadElement();
+        if (!json)
+            break;
+        isValid = LoadActorFromJson(path, *json, &reader, &generations, &handleObjects);
+    }
+    if (reader.HasError())
+    {
+        SDL_LogError(0, "Couldn't parse %s: %s", path, reader.GetError());
+        isValid = false;
+    }
+
+    _handles.Restore(generations.data(), handleObjects.data(), (u32)generations.size());
+
+    // Parents may name later actors, broken ones are cleared so the rest still loads
+    std::vector<bool> isScene(generations.size(), false);
+    std::vector<Handle<SceneComponent>> parents(generations.size());
+    std::vector<SceneComponent*> sceneComponents;
+    for (const Archetype* archetype : _componentStorage.GetArchetypes())
+    {
+        for (u32 column = 0; column < archetype->TypeCount; ++column)
+        {
+            if (!(archetype->Types[column]->Type->Ancestry & SceneComponent::GetClassType()->Mask))
+                continue;
+            for (u32 row = 0; row < archetype->RowCount; ++row)
+            {
+                SceneComponent* component = (SceneComponent*)archetype->GetComponent(column, row);
+                isScene[component->GetHandle().Index] = true;
+                parents[component->GetHandle().Index] = component->_parent;
+                sceneComponents.push_back(component);
+            }
+        }
+    }
+    if (!CheckLoadedParents(path, isScene, generations.data(), &parents))
+    {
+        for (SceneComponent* component : sceneComponents)
+            component->_parent = parents[component->GetHandle().Index];
+        isValid = false;
+    }
+
+    RegisterLoadedComponents();
+    return isValid;
+}
+
+bool GameWorld::LoadActorFromJson(const char* path, const JsonNode& json, JsonReader* reader,
+                                  std::vector<u32>* generations,
+                                  std::vector<void*>* handleObjects)
+{
+    // Way beyond any level, only there so a typo can't grow the handle table to gigabytes
+    const u32 maxHandleIndex = 1 << 26;
+    const u32 actorNumber = (u32)_actors.size();
+
+    const JsonNode* type = json.Find("type");
+    const JsonNode* handle = json.Find("handle");
+    const JsonNode* root = json.Find("RootComponent");
+    const JsonNode* components = json.Find("components");
+    if (!type || type->Type != JsonType::String ||
+        SDL_strcmp(type->Text, Actor::GetClassType()->Name) != 0)
+    {
+        SDL_LogError(0, "%s: actor %u is no %s", path, actorNumber, Actor::GetClassType()->Name);
+        return false;
+    }
+    if (!handle || handle->Type != JsonType::Number ||
+        (root && root->Type != JsonType::Number) ||
+        (components && components->Type != JsonType::Array && components->Type != JsonType::Null))
+    {
+        SDL_LogError(0, "%s: actor %u has no handle, root component or components", path,
+                     actorNumber);
+        return false;
+    }
+
+    // The actor handle goes first
+    Handle<TypeBase> handles[Archetype::MaxComponentTypes + 1];
+    const ComponentTypeInfo* types[Archetype::MaxComponentTypes];
+    const u8* columns[Archetype::MaxComponentTypes];
+    u32 count = 0;
+    handles[0] = Handle<TypeBase>::FromU64(handle->AsU64());
+    for (const JsonNode* component = components ? components->FirstChild : nullptr; component;
+         component = component->Next)
+    {
+        const JsonNode* componentType = component->Find("type");
+        const JsonNode* componentHandle = component->Find("handle");
+        if (!componentType || componentType->Type != JsonType::String || !componentHandle ||
+            componentHandle->Type != JsonType::Number || count == Archetype::MaxComponentTypes)
+        {
+            SDL_LogError(0, "%s: component %u of actor %u has no type or handle", path, count,
+                         actorNumber);
+            return false;
+        }
+
+        const ComponentTypeInfo* info = FindComponentType(componentType->Text);
+        if (!info || !info->Construct || std::find(types, types + count, info) != types + count)
+        {
+            SDL_LogError(0, "%s: actor %u can't have a %s", path, actorNumber,
+                         componentType->Text);
+            return false;
+        }
+
+        // Columns are cache line aligned as well
+        u8* memory = (u8*)reader->Allocate(info->Size, 64);
+        info->Construct(memory);
+        handles[count + 1] = Handle<TypeBase>::FromU64(componentHandle->AsU64());
+        ((BaseComponent*)memory)->_handle = StaticHandleCast<BaseComponent>(handles[count + 1]);
+        if (!DeserializeReflectedFields(info->Type, memory, *component))
+        {
+            SDL_LogError(0, "%s: a field of the %s of actor %u has the wrong type", path,
+                         componentType->Text, actorNumber);
+            return false;
+        }
+        if ((info->Type->Ancestry & StaticMeshComponent::GetClassType()->Mask) &&
+            !((const StaticMeshComponent*)memory)->HasModel())
+        {
+            SDL_LogError(0, "%s: the model of the %s of actor %u isn't loaded", path,
+                         componentType->Text, actorNumber);
+            return false;
+        }
+        types[count] = info;
+        columns[count] = memory;
+        count++;
+    }
+
+    for (u32 i = 0; i <= count; ++i)
+    {
+        const u32 index = handles[i].Index;
+        bool isTaken = index < handleObjects->size() && (*handleObjects)[index];
+        for (u32 j = 0; j < i; ++j) isTaken |= handles[j].Index == index;
+        if (index == 0 || index >= maxHandleIndex || isTaken)
+        {
+            SDL_LogError(0, "%s: handle %llu of actor %u is invalid or taken", path,
+                         (unsigned long long)handles[i].ToU64(), actorNumber);
+            return false;
+        }
+    }
+
+    Handle<SceneComponent> rootComponent;
+    if (root && root->AsU64())
+    {
+        rootComponent = Handle<SceneComponent>::FromU64(root->AsU64());
+        const Handle<TypeBase>* found =
+            std::find(handles + 1, handles + count + 1, Handle<TypeBase>(rootComponent));
+        if (found == handles + count + 1 ||
+            !(types[found - handles - 1]->Type->Ancestry & SceneComponent::GetClassType()->Mask))
+        {
+            SDL_LogError(0, "%s: the root of actor %u is none of its scene components", path,
+                         actorNumber);
+            return false;
+        }
+    }
+
+    Actor* actor = _actorMemory.PushAndConstruct<Actor>(this, RestoreTag());
+    actor->_handle = StaticHandleCast<Actor>(handles[0]);
+    actor->_rootSceneComponent = rootComponent;
+    actor->_worldIndex = actorNumber;
+    _actors.push_back(actor);
+
+    for (u32 i = 0; i <= count; ++i)
+    {
+        if (handles[i].Index >= handleObjects->size())
+        {
+            generations->resize(handles[i].Index + 1, 1);
+            handleObjects->resize(handles[i].Index + 1, nullptr);
+        }
+        (*generations)[handles[i].Index] = handles[i].Generation;
+        if (i > 0)
+            actor->_components.push_back(StaticHandleCast<BaseComponent>(handles[i]));
+    }
+    (*handleObjects)[handles[0].Index] = actor;
+    if (count > 0)
+    {
+        _componentStorage.LoadRows(types, count, 1, &actor, columns, handleObjects->data(),
+                                   (u32)handleObjects->size());
+    }
+    return true;
+}
+
+void GameWorld::RegisterLoadedComponents()
+{
+    // Boxes of a world file would be indexed by stale transform ids
+    _spatialTree.Clear();
+    _spatialBounds.clear();
+
+    const TypeId sceneType = SceneComponent::GetClassType();
+    const TypeId staticMeshType = StaticMeshComponent::GetClassType();
+    for (const Archetype* archetype : _componentStorage.GetArchetypes())
+    {
+        for (u32 column = 0; column < archetype->TypeCount; ++column)
+        {
+            if (!(archetype->Types[column]->Type->Ancestry & sceneType->Mask))
+                continue;
+            for (u32 row = 0; row < archetype->RowCount; ++row)
+                ((SceneComponent*)archetype->GetComponent(column, row))->_transformId =
+                    InvalidTransformId;
+        }
+    }
+    std::vector<SceneComponent*> chain;
+    for (const Archetype* archetype : _componentStorage.GetArchetypes())
+    {
+        for (u32 column = 0; column < archetype->TypeCount; ++column)
+        {
+            const TypeId type = archetype->Types[column]->Type;
+            if (!(type->Ancestry & sceneType->Mask))
+                continue;
+            for (u32 row = 0; row < archetype->RowCount; ++row)
+            {
+                SceneComponent* component = (SceneComponent*)archetype->GetComponent(column, row);
+                AddLoadedTransformNode(component, &chain);
+                if (type->Ancestry & staticMeshType->Mask)
+                    ((StaticMeshComponent*)component)->AddToWorld();
+            }
+        }
+    }
+}
+
 PhysicsWorld* GameWorld::GetPhysicsWorld() { return &_physicsWorld; }
 
+TransformHierarchy* GameWorld::GetTransformHierarchy() { return &_transforms; }
+
 void GameWorld::DestroyActor(Actor* actor)
 {
     Assert(!_isShutdown);
-    actor->~Actor();
+    Assert(_actors[actor->_worldIndex] == actor);
+    _handles.Destroy(actor->GetHandle().Index);
 
-    auto it = std::find(_actors.begin(), _actors.end(), actor);
-    if (it != _actors.end())
-        _actors.erase(it);
+    // Swap remove, the last actor takes over the slot
+    Actor* last = _actors.back();
+    _actors[actor->_worldIndex] = last;
+    last->_worldIndex = actor->_worldIndex;
+    _actors.pop_back();
 
+    actor->~Actor();
     _actorMemory.Pop(actor);
 }
 
 const std::vector<Actor*>& GameWorld::GetAllActors() const { return _actors; }
 
+WorldCommandBuffer* GameWorld::GetCommandBuffer()
+{
+    return &_commandBuffers[WorldCommandBuffer::GetThreadIndex()];
+}
+
+void GameWorld::PlaybackCommandBuffers()
+{
+    Assert(!_isShutdown);
+    typedef WorldCommandBuffer::Command Command;
+    typedef WorldCommandBuffer::CommandType CommandType;
+
+    // Grow everything once up front, spawning then only appends
+    u32 commandCount = 0;
+    u32 spawnCount = 0;
+    u32 componentCount = 0;
+    for (const WorldCommandBuffer& buffer : _commandBuffers)
+    {
+        commandCount += buffer._commandCount;
+        spawnCount += buffer._spawnCount;
+        componentCount += buffer._componentCount;
+    }
+    if (commandCount == 0)
+        return;
+
+    _actors.reserve(_actors.size() + spawnCount);
+    // Every actor brings its root scene component along
+    _handles.Reserve(2 * spawnCount + componentCount);
+
+    if (spawnCount)
+        PlaybackSpawns(spawnCount);
+
+    for (WorldCommandBuffer& buffer : _commandBuffers)
+    {
+        if (buffer._commandCount == 0)
+            continue;
+
+        buffer.ForEachCommand([this](const Command& command, void* payload) {
+            switch (command.Type)
+            {
+                case CommandType::SpawnActor:
+                    break;
+                case CommandType::DestroyActor:
+                    if (Actor* actor = Resolve(Handle<Actor>::FromU64(command.Target)))
+                        DestroyActor(actor);
+                    break;
+                case CommandType::AddComponent:
+                    if (command.IsPending)
+                        break;
+                    if (Actor* actor = Resolve(Handle<Actor>::FromU64(command.Target)))
+                        command.Add(actor, payload);
+                    break;
+                case CommandType::RemoveComponent:
+                    if (BaseComponent* component =
+                            Resolve(ComponentHandle::FromU64(command.Target)))
+                        component->GetOwningActor()->DeRegisterComponent(component);
+                    break;
+            }
+        });
+        buffer.Clear();
+    }
+}
+
+void GameWorld::PlaybackSpawns(u32 spawnCount)
+{
+    typedef WorldCommandBuffer::Command Command;
+    typedef WorldCommandBuffer::CommandType CommandType;
+
+    // Every actor brings its root scene component along
+    const ComponentTypeInfo* rootInfo = GetComponentTypeInfo<SceneComponent>();
+    _pendingSpawns.clear();
+    _pendingSpawns.reserve(spawnCount);
+    u32 firstSpawn = 0;
+    for (const WorldCommandBuffer& buffer : _commandBuffers)
+    {
+        if (buffer._spawnCount == 0)
+            continue;
+        buffer.ForEachCommand([&](const Command& command, void* payload) {
+            if (command.Type == CommandType::SpawnActor)
+            {
+                _pendingSpawns.push_back({&command, payload, rootInfo->Type->Mask, 0, 0, 0});
+            }
+            else if (command.Type == CommandType::AddComponent && command.IsPending)
+            {
+                PendingSpawn& spawn = _pendingSpawns[firstSpawn + (u32)command.Target];
+                spawn.Mask |= command.Info->Type->Mask;
+                spawn.AddCount++;
+            }
+        });
+        firstSpawn += buffer._spawnCount;
+    }
+
+    // Counting sorts keep this linear: adds by spawn, spawns by mask. A batch only has a few
+    // different masks, consecutive spawns mostly share theirs.
+    _spawnGroups.clear();
+    u32 addCount = 0;
+    u32 group = 0;
+    for (PendingSpawn& spawn : _pendingSpawns)
+    {
+        spawn.FirstAdd = addCount;
+        addCount += spawn.AddCount;
+        spawn.AddCount = 0;
+
+        if (_spawnGroups.empty() || _spawnGroups[group].Mask != spawn.Mask)
+        {
+            group = 0;
+            while (group < (u32)_spawnGroups.size() && _spawnGroups[group].Mask != spawn.Mask)
+                group++;
+            if (group == (u32)_spawnGroups.size())
+                _spawnGroups.push_back({spawn.Mask, 0, 0});
+        }
+        _spawnGroups[group].Count++;
+        spawn.Group = group;
+    }
+
+    u32 first = 0;
+    for (SpawnGroup& spawnGroup : _spawnGroups)
+    {
+        spawnGroup.First = first;
+        first += spawnGroup.Count;
+        spawnGroup.Count = 0;
+    }
+    _spawnOrder.resize(_pendingSpawns.size());
+    for (u32 i = 0; i < (u32)_pendingSpawns.size(); ++i)
+    {
+        SpawnGroup& spawnGroup = _spawnGroups[_pendingSpawns[i].Group];
+        _spawnOrder[spawnGroup.First + spawnGroup.Count++] = i;
+    }
+
+    _pendingAdds.resize(addCount);
+    firstSpawn = 0;
+    for (const WorldCommandBuffer& buffer : _commandBuffers)
+    {
+        if (buffer._spawnCount == 0)
+            continue;
+        buffer.ForEachCommand([&](const Command& command, void* payload) {
+            if (command.Type != CommandType::AddComponent || !command.IsPending)
+                return;
+            PendingSpawn& spawn = _pendingSpawns[firstSpawn + (u32)command.Target];
+            _pendingAdds[spawn.FirstAdd + spawn.AddCount++] = {&command, payload};
+        });
+        firstSpawn += buffer._spawnCount;
+    }
+
+    for (const SpawnGroup& spawnGroup : _spawnGroups)
+    {
+        // All spawns of the group have the same types, one component per type
+        const PendingSpawn& firstOfGroup = _pendingSpawns[_spawnOrder[spawnGroup.First]];
+        const ComponentTypeInfo* types[Archetype::MaxComponentTypes];
+        u32 typeCount = 1;
+        types[0] = rootInfo;
+        TypeMask typeMask = rootInfo->Type->Mask;
+        for (u32 i = 0; i < firstOfGroup.AddCount; ++i)
+        {
+            const ComponentTypeInfo* info = _pendingAdds[firstOfGroup.FirstAdd + i].Command->Info;
+            if ((typeMask & info->Type->Mask) || typeCount == Archetype::MaxComponentTypes)
+                continue;
+            types[typeCount++] = info;
+            typeMask |= info->Type->Mask;
+        }
+
+        for (u32 i = 0; i < spawnGroup.Count; ++i)
+        {
+            const PendingSpawn& spawn = _pendingSpawns[_spawnOrder[spawnGroup.First + i]];
+            _componentStorage.BeginSpawn(types, typeCount);
+            Actor* actor = spawn.Command->Spawn(this, spawn.Payload);
+            actor->_components.reserve(actor->_components.size() + spawn.AddCount);
+            for (u32 j = 0; j < spawn.AddCount; ++j)
+            {
+                const PendingAdd& add = _pendingAdds[spawn.FirstAdd + j];
+                add.Command->Add(actor, add.Payload);
+            }
+            _componentStorage.EndSpawn(actor);
+        }
+    }
+}
+
+void GameWorld::DefragmentComponents()
+{
+    Assert(!_isShutdown);
+    _componentStorage.Defragment();
+}
+
 Camera* GameWorld::GetActiveCamera() { return &_camera; }
 
 vec3 GameWorld::GetMouseRay() const
@@ -70,8 +875,11 @@ void GameWorld::Update(float dtSeconds)
         graphics::AddDebugXZGrid(vec2(0), -5, 5, 0);
     graphics::AddDebugAxes(Transform(vec3(0, 0.01f, 0), vec3(), vec3(1)), 5.f, 2.5f);
 
+    PlaybackCommandBuffers();
     _worldClock.Update(dtSeconds);
     _physicsWorld.Update();
+    _transforms.Update();
+    UpdateSpatialTree();
 
     // Update Camera
     // ToDo(Faaux)(Default): Move to component
@@ -123,7 +931,72 @@ void GameWorld::SetInput(Input input)
 void GameWorld::DestroyComponent(BaseComponent* component)
 {
     Assert(!_isShutdown);
-    Assert(_componentStorages[component->GetInstanceType()]);
-    _componentStorages[component->GetInstanceType()]->DestroyComponent(component);
+    _componentStorage.RemoveComponent(component);
+}
+
+void GameWorld::DestroyAllComponents(Actor* actor)
+{
+    Assert(!_isShutdown);
+    _componentStorage.RemoveAllComponents(actor);
+}
+
+void GameWorld::AddLoadedTransformNode(SceneComponent* component,
+                                       std::vector<SceneComponent*>* chain)
+{
+    // Iterates, levels can nest deeper than the stack
+    for (; component && component->_transformId == InvalidTransformId;
+         component = Resolve(component->_parent))
+        chain->push_back(component);
+
+    for (auto it = chain->rbegin(); it != chain->rend(); ++it)
+    {
+        SceneComponent* parent = Resolve((*it)->_parent);
+        (*it)->_transformId =
+            _transforms.AddNode(parent ? parent->_transformId : InvalidTransformId,
+                                (*it)->_transform.GetModelMatrix());
+    }
+    chain->clear();
+}
+
+void GameWorld::SetSpatialBounds(SceneComponent* component, const AABB& local)
+{
+    const TransformId id = component->_transformId;
+    if (id >= _spatialBounds.size())
+        _spatialBounds.resize(id + 1);
+
+    SpatialBounds& bounds = _spatialBounds[id];
+    bounds.Local = local;
+    const AABB world = TransformAABB(local, _transforms.GetWorldMatrix(id));
+    if (bounds.Proxy == AABBTree::InvalidProxy)
+        bounds.Proxy = _spatialTree.CreateProxy(world, component->GetHandle().ToU64());
+    else
+        _spatialTree.MoveProxy(bounds.Proxy, world);
+}
+
+void GameWorld::RemoveSpatialBounds(TransformId id)
+{
+    if (id >= _spatialBounds.size() || _spatialBounds[id].Proxy == AABBTree::InvalidProxy)
+        return;
+    _spatialTree.DestroyProxy(_spatialBounds[id].Proxy);
+    _spatialBounds[id].Proxy = AABBTree::InvalidProxy;
+}
+
+void GameWorld::UpdateSpatialTree()
+{
+    const u32 count = (u32)_spatialBounds.size();
+    _transforms.ForEachChanged([this, count](TransformId id, const mat4& world) {
+        if (id < count && _spatialBounds[id].Proxy != AABBTree::InvalidProxy)
+            _spatialTree.MoveProxy(_spatialBounds[id].Proxy,
+                                   TransformAABB(_spatialBounds[id].Local, world));
+    });
+    _spatialTree.Update();
+}
+
+ComponentHandle GameWorld::TakeConstructingComponentHandle()
+{
+    const ComponentHandle result = _constructingComponent;
+    Assert(result.IsValid());
+    _constructingComponent = ComponentHandle();
+    return result;
 }
 }  // namespace DG
@@ -5,18 +5,26 @@
  */
 
 #pragma once
-#include <unordered_map>
 #include "Camera.h"
 #include "components/BaseComponent.h"
 #include "components/ComponentStorage.h"
+#include "engine/AABBTree.h"
+#include "engine/Handle.h"
+#include "engine/TransformHierarchy.h"
+#include "engine/WorldCommandBuffer.h"
 #include "gameobjects/Actor.h"
 #include "physics/Physics.h"
 
 namespace DG
 {
+struct JsonNode;
+class JsonReader;
+
 class GameWorld
 {
     friend class Actor;
+    friend class BaseComponent;
+    friend class SceneComponent;
 
    public:
     struct Input
@@ -45,13 +53,62 @@ class GameWorld
     void Startup(u8* worldMemory, s32 worldMemorySize);
     void Shutdown();
 
+    // Copies actors, components, transforms and static physics into target. target has to be
+    // started with GetMemorySize() bytes and still be empty, handles stay valid in the copy.
+    // Recorded commands are not copied.
+    void CloneInto(GameWorld* target) const;
+    s32 GetMemorySize() const;
+
+    // Binary level files, see engine/WorldFile.h. Loading needs a started and empty world with
+    // enough memory and leaves it empty if the file doesn't fit this build.
+    bool SaveToFile(const char* path) const;
+    bool LoadFromFile(const char* path);
+    // Levels as written by SerializeActor, a top level array of actors. Reads one actor at a time
+    // and keeps the handles of the file. Needs a started and empty world, on errors the actors in
+    // front of the broken one stay loaded. Parents that aren't scene components or form a cycle
+    // are cleared and fail the load as well.
+    bool LoadFromJson(const char* path);
+
     PhysicsWorld* GetPhysicsWorld();
+    TransformHierarchy* GetTransformHierarchy();
 
     template <typename T, typename... Args>
     T* CreateActor(Args&&... args);
     void DestroyActor(Actor* actor);
+    // Not in creation order, destroying swaps the last actor into the hole
     const std::vector<Actor*>& GetAllActors() const;
 
+    // The buffer of the calling thread, record into it instead of changing the world from jobs
+    WorldCommandBuffer* GetCommandBuffer();
+    // Applies every recorded command, Update does this first. Nothing may record meanwhile.
+    void PlaybackCommandBuffers();
+
+    // Null once the actor or component is destroyed
+    template <typename T>
+    T* Resolve(Handle<T> handle) const;
+
+    // Packs component rows by actor again, handles stay valid
+    void DefragmentComponents();
+
+    // Scene components with bounds, as of the last Update. Call function(Handle<SceneComponent>)
+    // for every component whose world box passes the test.
+    template <typename Function>
+    void QueryAABB(const AABB& aabb, Function&& function) const;
+    template <typename Function>
+    void QuerySphere(vec3 center, f32 radius, Function&& function) const;
+    template <typename Function>
+    void QueryFrustum(const Frustum& frustum, Function&& function) const;
+    // Calls f32 function(Handle<SceneComponent>, f32 distance) for every box the ray enters, see
+    // AABBTree::RayCast for the result
+    template <typename Function>
+    void RayCast(vec3 origin, vec3 direction, f32 maxDistance, Function&& function) const;
+    const AABBTree& GetSpatialTree() const { return _spatialTree; }
+
+    // Calls function(T0&, T1&, ...) for every actor with all of the exact component types.
+    // Walks packed component memory, do not create or destroy components while iterating.
+    template <typename... Ts, typename Function>
+    void Each(Function&& function) const;
+
     Camera* GetActiveCamera();
     vec3 GetMouseRay() const;
     const Input& GetLastInput() const;
@@ -63,6 +120,27 @@ class GameWorld
     template <typename T, typename... Args>
     T* CreateComponent(Actor* actor, Args&&... args);
     void DestroyComponent(BaseComponent* component);
+    void DestroyAllComponents(Actor* actor);
+    ComponentHandle TakeConstructingComponentHandle();
+    // Checks the whole actor before anything is created. Components are built in scratch memory
+    // of the reader and copied into their archetype, handleObjects receives them like in
+    // LoadFromFile.
+    bool LoadActorFromJson(const char* path, const JsonNode& json, JsonReader* reader,
+                           std::vector<u32>* generations, std::vector<void*>* handleObjects);
+    // Transform nodes and PhysX actors are not part of level files, build them for every scene
+    // component once the handles are restored
+    void RegisterLoadedComponents();
+    // Parents first, the transform ids stored in a file mean nothing. Loading checked that the
+    // parents are scene components without cycles, chain is scratch space for the walk up.
+    void AddLoadedTransformNode(SceneComponent* component, std::vector<SceneComponent*>* chain);
+    // Bounds are in the space of the component and follow its world matrix
+    void SetSpatialBounds(SceneComponent* component, const AABB& local);
+    void RemoveSpatialBounds(TransformId id);
+    // Moves the boxes of every transform the last hierarchy update changed
+    void UpdateSpatialTree();
+    // Spawns of every buffer with the components recorded for them. Spawns ending up with the same
+    // components are played back together, each allocated in its final archetype right away.
+    void PlaybackSpawns(u32 spawnCount);
 
     Camera _camera;  // ToDo(Faaux)(Default): Remove and put into component
     bool _isNewInput;
@@ -74,7 +152,45 @@ class GameWorld
     bool _isShutdown = false;
 
     std::vector<Actor*> _actors;
-    std::unordered_map<TypeId, BaseComponentStorage*> _componentStorages;
+    HandleTable _handles;
+    TransformHierarchy _transforms;
+    ComponentHandle _constructingComponent;
+    ComponentStorage _componentStorage;
+
+    struct SpatialBounds
+    {
+        AABB Local;
+        u32 Proxy = AABBTree::InvalidProxy;
+    };
+    AABBTree _spatialTree;
+    std::vector<SpatialBounds> _spatialBounds;  // By transform id
+
+    WorldCommandBuffer _commandBuffers[WorldCommandBuffer::MaxThreads];
+    // Scratch space of PlaybackSpawns, kept to not allocate every frame
+    struct PendingSpawn
+    {
+        const WorldCommandBuffer::Command* Command;
+        void* Payload;
+        TypeMask Mask;  // Of every component the actor ends up with
+        u32 FirstAdd;   // Into _pendingAdds
+        u32 AddCount;
+        u32 Group;  // Into _spawnGroups
+    };
+    struct PendingAdd
+    {
+        const WorldCommandBuffer::Command* Command;
+        void* Payload;
+    };
+    struct SpawnGroup
+    {
+        TypeMask Mask;
+        u32 First;  // Into _spawnOrder
+        u32 Count;
+    };
+    std::vector<PendingSpawn> _pendingSpawns;  // Across all buffers in recording order
+    std::vector<PendingAdd> _pendingAdds;      // Grouped by spawn
+    std::vector<SpawnGroup> _spawnGroups;
+    std::vector<u32> _spawnOrder;  // Into _pendingSpawns, grouped by mask
 };
 
 template <typename T, typename... Args>
@@ -84,6 +200,8 @@ T* GameWorld::CreateActor(Args&&... args)
 
     Assert(!_isShutdown);
     auto result = _actorMemory.PushAndConstruct<T>(this, std::forward<Args>(args)...);
+    result->_handle = _handles.Create<Actor>(result);
+    result->_worldIndex = (u32)_actors.size();
     _actors.push_back(result);
     return result;
 }
@@ -94,20 +212,116 @@ T* GameWorld::CreateComponent(Actor* actor, Args&&... args)
     static_assert(std::is_base_of<BaseComponent, T>::value, "T not derived from BaseComponent");
 
     Assert(!_isShutdown);
-    if (!_componentStorages[T::GetClassType()])
-    {
-        // Create Component Storage
+    void* memory = _componentStorage.AddComponent(actor, GetComponentTypeInfo<T>());
 
-        _componentStorages[T::GetClassType()] =
-            _worldMemory.PushAndConstruct<ComponentStorage<T>>(&_worldMemory);
-    }
+    // Picked up by the BaseComponent constructor
+    Assert(!_constructingComponent.IsValid());
+    _constructingComponent = _handles.Create((BaseComponent*)memory);
+    T* component = new (memory) T(actor, std::forward<Args>(args)...);
+    Assert(!_constructingComponent.IsValid());
+    return component;
+}
 
-    ComponentStorage<T>* storage = (ComponentStorage<T>*)(_componentStorages[T::GetClassType()]);
+template <typename T>
+T* GameWorld::Resolve(Handle<T> handle) const
+{
+    return _handles.Resolve(handle);
+}
 
-    // Create component
-    T* component = storage->CreateComponent();
+template <typename... Ts, typename Function>
+void GameWorld::Each(Function&& function) const
+{
+    _componentStorage.Each<Ts...>(std::forward<Function>(function));
+}
+
+template <typename Function>
+void GameWorld::QueryAABB(const AABB& aabb, Function&& function) const
+{
+    _spatialTree.QueryAABB(aabb, [&function](u32, u64 userData) {
+        function(Handle<SceneComponent>::FromU64(userData));
+    });
+}
+
+template <typename Function>
+void GameWorld::QuerySphere(vec3 center, f32 radius, Function&& function) const
+{
+    _spatialTree.QuerySphere(center, radius, [&function](u32, u64 userData) {
+        function(Handle<SceneComponent>::FromU64(userData));
+    });
+}
 
-    new (component) T(actor, std::forward<Args>(args)...);
+template <typename Function>
+void GameWorld::QueryFrustum(const Frustum& frustum, Function&& function) const
+{
+    _spatialTree.QueryFrustum(frustum, [&function](u32, u64 userData) {
+        function(Handle<SceneComponent>::FromU64(userData));
+    });
+}
+
+template <typename Function>
+void GameWorld::RayCast(vec3 origin, vec3 direction, f32 maxDistance, Function&& function) const
+{
+    _spatialTree.RayCast(origin, direction, maxDistance,
+                         [&function](u32, u64 userData, f32 distance) {
+                             return function(Handle<SceneComponent>::FromU64(userData), distance);
+                         });
+}
+
+template <typename T, typename... Args>
+T* Actor::RegisterComponent(Args&&... args)
+{
+    T* component = _gameWorld->CreateComponent<T>(this, std::forward<Args>(args)...);
+    _components.push_back(component->GetHandle());
     return component;
 }
+
+template <typename T, typename... Args>
+PendingActor WorldCommandBuffer::SpawnActor(Args&&... args)
+{
+    static_assert(std::is_base_of<Actor, T>::value, "T not derived from Actor");
+    typedef std::tuple<typename std::decay<Args>::type...> Payload;
+    const PendingActor result = {_spawnCount};
+    Command* command = RecordWithPayload<Payload>(CommandType::SpawnActor, 0, false,
+                                                  std::forward<Args>(args)...);
+    command->Spawn = &SpawnActorCommand<T, Payload>;
+    return result;
+}
+
+template <typename T, typename... Args>
+void WorldCommandBuffer::AddComponent(Handle<Actor> actor, Args&&... args)
+{
+    static_assert(std::is_base_of<BaseComponent, T>::value, "T not derived from BaseComponent");
+    typedef std::tuple<typename std::decay<Args>::type...> Payload;
+    Command* command = RecordWithPayload<Payload>(CommandType::AddComponent, actor.ToU64(), false,
+                                                  std::forward<Args>(args)...);
+    command->Add = &AddComponentCommand<T, Payload>;
+    command->Info = GetComponentTypeInfo<T>();
+}
+
+template <typename T, typename... Args>
+void WorldCommandBuffer::AddComponent(PendingActor actor, Args&&... args)
+{
+    static_assert(std::is_base_of<BaseComponent, T>::value, "T not derived from BaseComponent");
+    Assert(actor.Index < _spawnCount);
+    typedef std::tuple<typename std::decay<Args>::type...> Payload;
+    Command* command = RecordWithPayload<Payload>(CommandType::AddComponent, actor.Index, true,
+                                                  std::forward<Args>(args)...);
+    command->Add = &AddComponentCommand<T, Payload>;
+    command->Info = GetComponentTypeInfo<T>();
+}
+
+template <class T, class Payload>
+Actor* WorldCommandBuffer::SpawnActorCommand(GameWorld* world, void* payload)
+{
+    return std::apply(
+        [world](auto&&... args) { return world->CreateActor<T>(std::move(args)...); },
+        std::move(*(Payload*)payload));
+}
+
+template <class T, class Payload>
+void WorldCommandBuffer::AddComponentCommand(Actor* actor, void* payload)
+{
+    std::apply([actor](auto&&... args) { actor->RegisterComponent<T>(std::move(args)...); },
+               std::move(*(Payload*)payload));
+}
 }  // namespace DG
@@ -0,0 +1,87 @@
+/**
+ *  @file    Handle.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "Handle.h"
+
+namespace DG
+{
+HandleTable::HandleTable() { Clear(); }
+
+u32 HandleTable::CreateSlot(void* object)
+{
+    Assert(object);
+    _liveCount++;
+    if (_firstFree)
+    {
+        const u32 index = _firstFree;
+        Slot& slot = _slots[index];
+        _firstFree = slot.NextFree;
+        slot.Object = object;
+        slot.NextFree = 0;
+        return index;
+    }
+
+    _slots.push_back({object, 1, 0});
+    return (u32)_slots.size() - 1;
+}
+
+void HandleTable::Relocate(u32 index, void* object)
+{
+    Assert(index && index < _slots.size() && _slots[index].Object);
+    _slots[index].Object = object;
+}
+
+void HandleTable::Destroy(u32 index)
+{
+    Assert(index && index < _slots.size() && _slots[index].Object);
+    Slot& slot = _slots[index];
+    slot.Object = nullptr;
+    slot.Generation++;
+    slot.NextFree = _firstFree;
+    _firstFree = index;
+    _liveCount--;
+}
+
+void HandleTable::Reserve(u32 count)
+{
+    const u32 freeCount = (u32)(_slots.size() - 1) - _liveCount;
+    if (count > freeCount)
+        _slots.reserve(_slots.size() + count - freeCount);
+}
+
+void HandleTable::Restore(const u32* generations, void* const* objects, u32 count)
+{
+    Assert(count > 0 && !objects[0]);
+    Clear();
+    _slots.resize(count);
+    // Walk backwards so the free list hands out low indices first
+    for (u32 index = count - 1; index > 0; --index)
+    {
+        Slot& slot = _slots[index];
+        slot.Object = objects[index];
+        slot.Generation = generations[index];
+        slot.NextFree = 0;
+        if (slot.Object)
+        {
+            _liveCount++;
+        }
+        else
+        {
+            slot.NextFree = _firstFree;
+            _firstFree = index;
+        }
+    }
+}
+
+void HandleTable::Clear()
+{
+    // Slot 0 backs the null handle
+    _slots.clear();
+    _slots.push_back({nullptr, 0, 0});
+    _firstFree = 0;
+    _liveCount = 0;
+}
+}  // namespace DG
@@ -0,0 +1,107 @@
+/**
+ *  @file    Handle.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <type_traits>
+#include <vector>
+#include "engine/Types.h"
+
+namespace DG
+{
+// Index into the handle table of a GameWorld plus the generation of the slot when the handle was
+// made. Once the object is destroyed the slot generation moves on and the handle resolves to null.
+template <class T>
+struct Handle
+{
+    Handle() = default;
+    Handle(u32 index, u32 generation) : Index(index), Generation(generation) {}
+
+    // Handle<Derived> converts to Handle<Base>
+    template <class U, class = typename std::enable_if<std::is_base_of<T, U>::value>::type>
+    Handle(Handle<U> other) : Index(other.Index), Generation(other.Generation)
+    {
+    }
+
+    bool IsValid() const { return Index != 0; }
+    explicit operator bool() const { return IsValid(); }
+    bool operator==(Handle other) const
+    {
+        return Index == other.Index && Generation == other.Generation;
+    }
+    bool operator!=(Handle other) const { return !(*this == other); }
+
+    // Fits into PhysX userData and serialized files
+    u64 ToU64() const { return ((u64)Generation << 32) | Index; }
+    static Handle FromU64(u64 value) { return Handle((u32)value, (u32)(value >> 32)); }
+
+    u32 Index = 0;  // 0 is never handed out
+    u32 Generation = 0;
+};
+
+// Handle<Base> to Handle<Derived>, like static_cast the caller has to know the type
+template <class T, class U>
+Handle<T> StaticHandleCast(Handle<U> handle)
+{
+    static_assert(std::is_base_of<U, T>::value, "T not derived from U");
+    return Handle<T>(handle.Index, handle.Generation);
+}
+
+// Slots are reused through a free list, resolving is a bounds check and a generation compare
+class HandleTable
+{
+   public:
+    HandleTable();
+
+    template <class T>
+    Handle<T> Create(T* object)
+    {
+        const u32 index = CreateSlot(object);
+        return Handle<T>(index, _slots[index].Generation);
+    }
+
+    template <class T>
+    T* Resolve(Handle<T> handle) const
+    {
+        return (T*)Resolve(handle.Index, handle.Generation);
+    }
+
+    // The object moved in memory, handles to it stay valid
+    void Relocate(u32 index, void* object);
+    void Destroy(u32 index);
+    void Clear();
+    // Room for count more handles without growing, e.g. before a bulk spawn
+    void Reserve(u32 count);
+
+    u32 GetLiveCount() const { return _liveCount; }
+
+    // World files store the generation of every slot and rebuild the table from it, objects[i]
+    // is null for free slots. Slot 0 is the null handle and stays empty.
+    u32 GetSlotCount() const { return (u32)_slots.size(); }
+    u32 GetGeneration(u32 index) const { return _slots[index].Generation; }
+    void Restore(const u32* generations, void* const* objects, u32 count);
+
+   private:
+    struct Slot
+    {
+        void* Object;
+        u32 Generation;
+        u32 NextFree;
+    };
+
+    u32 CreateSlot(void* object);
+    void* Resolve(u32 index, u32 generation) const
+    {
+        if (index >= _slots.size())
+            return nullptr;
+        const Slot& slot = _slots[index];
+        return slot.Generation == generation ? slot.Object : nullptr;
+    }
+
+    std::vector<Slot> _slots;
+    u32 _firstFree = 0;  // 0 = free list is empty
+    u32 _liveCount = 0;
+};
+}  // namespace DG
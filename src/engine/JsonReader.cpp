@@ -0,0 +1,461 @@
+/**
+ *  @file    JsonReader.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "JsonReader.h"
+#include <cstdlib>
+#include "memory/MemoryTracker.h"
+
+namespace DG
+{
+#if DG_MEMORY_TRACKING
+static MemoryTag GetJsonReaderTag()
+{
+    static const MemoryTag tag = RegisterMemoryTag("JsonReader");
+    return tag;
+}
+#endif
+
+const JsonNode* JsonNode::Find(const char* key) const
+{
+    if (Type != JsonType::Object)
+        return nullptr;
+    for (const JsonNode* child = FirstChild; child; child = child->Next)
+    {
+        if (SDL_strcmp(child->Key, key) == 0)
+            return child;
+    }
+    return nullptr;
+}
+
+u64 JsonNode::AsU64() const
+{
+    Assert(Type == JsonType::Number);
+    return std::strtoull(Text, nullptr, 10);
+}
+
+s64 JsonNode::AsS64() const
+{
+    Assert(Type == JsonType::Number);
+    return std::strtoll(Text, nullptr, 10);
+}
+
+f64 JsonNode::AsF64() const
+{
+    Assert(Type == JsonType::Number);
+    return std::strtod(Text, nullptr);
+}
+
+JsonReader::~JsonReader()
+{
+    Close();
+    Block* block = _first;
+    while (block)
+    {
+        Block* next = block->Next;
+        DG_TRACK_FREE(GetJsonReaderTag(), block->Size);
+        SDL_free(block);
+        block = next;
+    }
+}
+
+bool JsonReader::Open(const char* path)
+{
+    Assert(!_file);
+    _file = fopen(path, "rb");
+    _position = _end = 0;
+    _line = 1;
+    _isInArray = false;
+    _elementCount = 0;
+    _error[0] = 0;
+    if (!_file)
+        SDL_snprintf(_error, sizeof(_error), "Couldn't open %s", path);
+    return _file != nullptr;
+}
+
+void JsonReader::Close()
+{
+    if (_file)
+        fclose(_file);
+    _file = nullptr;
+    ResetArena();
+}
+
+bool JsonReader::BeginArray()
+{
+    SkipWhitespace();
+    if (!Expect('['))
+        return false;
+    _isInArray = true;
+    _elementCount = 0;
+    return true;
+}
+
+const JsonNode* JsonReader::ReadElement()
+{
+    ResetArena();
+    if (!_isInArray || HasError())
+        return nullptr;
+
+    SkipWhitespace();
+    if (Peek() == ']')
+    {
+        Next();
+        _isInArray = false;
+        SkipWhitespace();
+        if (Peek() >= 0)
+            SetError("Unexpected data after the top level array");
+        return nullptr;
+    }
+    if (_elementCount > 0 && !Expect(','))
+        return nullptr;
+
+    _elementCount++;
+    return ParseValue(0);
+}
+
+// Offset of the next free byte in block with the given alignment
+static u32 GetAlignedOffset(const u8* block, u32 used, u32 alignment)
+{
+    const uintptr_t address = (uintptr_t)(block + used);
+    return used + (u32)(((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+}
+
+void* JsonReader::Allocate(u32 size, u32 alignment)
+{
+    Assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    u32 offset = _current ? GetAlignedOffset((u8*)_current, _current->Used, alignment) : 0;
+    if (!_current || offset + size > _current->Size)
+    {
+        // Blocks stay allocated for the next element, big requests get a block of their own
+        Block* next = _current ? _current->Next : _first;
+        if (!next || sizeof(Block) + alignment + size > next->Size)
+        {
+            u32 blockSize = (u32)sizeof(Block) + alignment + size;
+            if (blockSize < BlockSize)
+                blockSize = BlockSize;
+            Block* block = (Block*)SDL_malloc(blockSize);
+            DG_TRACK_ALLOCATION(GetJsonReaderTag(), blockSize);
+            block->Size = blockSize;
+            block->Next = next;
+            if (_current)
+                _current->Next = block;
+            else
+                _first = block;
+            next = block;
+        }
+        next->Used = sizeof(Block);
+        _current = next;
+        offset = GetAlignedOffset((u8*)_current, _current->Used, alignment);
+    }
+
+    _used += offset + size - _current->Used;
+    _current->Used = offset + size;
+    return (u8*)_current + offset;
+}
+
+void JsonReader::ResetArena()
+{
+    if (_used > _hwm)
+        _hwm = _used;
+    _used = 0;
+    _current = nullptr;
+}
+
+bool JsonReader::Refill()
+{
+    if (!_file)
+        return false;
+    _position = 0;
+    _end = (u32)fread(_buffer, 1, BufferSize, _file);
+    return _end > 0;
+}
+
+void JsonReader::SkipWhitespace()
+{
+    for (int c = Peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = Peek()) Next();
+}
+
+bool JsonReader::Expect(char c)
+{
+    if (Next() == c)
+        return true;
+
+    char message[32];
+    SDL_snprintf(message, sizeof(message), "Expected '%c'", c);
+    SetError(message);
+    return false;
+}
+
+bool JsonReader::ExpectLiteral(const char* literal)
+{
+    for (const char* c = literal; *c; ++c)
+    {
+        if (Next() != *c)
+        {
+            SetError("Invalid literal");
+            return false;
+        }
+    }
+    return true;
+}
+
+void JsonReader::SetError(const char* message)
+{
+    // The first error is the interesting one
+    if (!HasError())
+        SDL_snprintf(_error, sizeof(_error), "Line %u: %s", _line, message);
+}
+
+JsonNode* JsonReader::ParseValue(u32 depth)
+{
+    if (depth >= MaxDepth)
+    {
+        SetError("Nested too deep");
+        return nullptr;
+    }
+
+    SkipWhitespace();
+    const int c = Peek();
+    if (c == '-' || (c >= '0' && c <= '9'))
+        return ParseNumber();
+
+    JsonNode* node = (JsonNode*)Allocate(sizeof(JsonNode), alignof(JsonNode));
+    SDL_memset(node, 0, sizeof(JsonNode));
+    switch (c)
+    {
+        case '"':
+            node->Type = JsonType::String;
+            node->Text = ParseString(&node->Length);
+            return node->Text ? node : nullptr;
+        case 't':
+            node->Type = JsonType::Bool;
+            node->Bool = true;
+            return ExpectLiteral("true") ? node : nullptr;
+        case 'f':
+            node->Type = JsonType::Bool;
+            return ExpectLiteral("false") ? node : nullptr;
+        case 'n':
+            node->Type = JsonType::Null;
+            return ExpectLiteral("null") ? node : nullptr;
+        case '[':
+        case '{':
+            break;
+        default:
+            SetError(c < 0 ? "Unexpected end of file" : "Unexpected character");
+            return nullptr;
+    }
+
+    const bool isObject = c == '{';
+    const char close = isObject ? '}' : ']';
+    node->Type = isObject ? JsonType::Object : JsonType::Array;
+    Next();
+    SkipWhitespace();
+    if (Peek() == close)
+    {
+        Next();
+        return node;
+    }
+
+    JsonNode* last = nullptr;
+    for (;;)
+    {
+        const char* key = nullptr;
+        if (isObject)
+        {
+            SkipWhitespace();
+            u32 keyLength;
+            if (Peek() != '"')
+            {
+                SetError(Peek() < 0 ? "Unexpected end of file" : "Expected a key");
+                return nullptr;
+            }
+            key = ParseString(&keyLength);
+            SkipWhitespace();
+            if (!key || !Expect(':'))
+                return nullptr;
+        }
+
+        JsonNode* child = ParseValue(depth + 1);
+        if (!child)
+            return nullptr;
+        child->Key = key;
+        if (last)
+            last->Next = child;
+        else
+            node->FirstChild = child;
+        last = child;
+        node->Length++;
+
+        SkipWhitespace();
+        const int separator = Next();
+        if (separator == close)
+            return node;
+        if (separator != ',')
+        {
+            SetError(isObject ? "Expected ',' or '}'" : "Expected ',' or ']'");
+            return nullptr;
+        }
+    }
+}
+
+JsonNode* JsonReader::ParseNumber()
+{
+    _text.clear();
+    for (int c = Peek(); c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' ||
+                         (c >= '0' && c <= '9');
+         c = Peek())
+    {
+        _text.push_back((char)Next());
+    }
+    _text.push_back(0);
+
+    char* end;
+    std::strtod(_text.data(), &end);
+    if (end != _text.data() + _text.size() - 1)
+    {
+        SetError("Invalid number");
+        return nullptr;
+    }
+
+    JsonNode* node = (JsonNode*)Allocate(sizeof(JsonNode), alignof(JsonNode));
+    SDL_memset(node, 0, sizeof(JsonNode));
+    node->Type = JsonType::Number;
+    node->Length = (u32)_text.size() - 1;
+    char* text = (char*)Allocate((u32)_text.size(), 1);
+    SDL_memcpy(text, _text.data(), _text.size());
+    node->Text = text;
+    return node;
+}
+
+const char* JsonReader::ParseString(u32* length)
+{
+    Next();  // Opening quote
+    _text.clear();
+    for (;;)
+    {
+        const int c = Next();
+        if (c == '"')
+            break;
+        if (c < 0)
+        {
+            SetError("Unterminated string");
+            return nullptr;
+        }
+        if (c < 0x20)
+        {
+            SetError("Control character in string");
+            return nullptr;
+        }
+        if (c == '\\')
+        {
+            if (!ParseEscape())
+                return nullptr;
+            continue;
+        }
+        _text.push_back((char)c);
+    }
+
+    *length = (u32)_text.size();
+    char* text = (char*)Allocate(*length + 1, 1);
+    SDL_memcpy(text, _text.data(), *length);
+    text[*length] = 0;
+    return text;
+}
+
+static s32 ParseHexDigit(int c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool JsonReader::ParseEscape()
+{
+    const int c = Next();
+    switch (c)
+    {
+        case '"': _text.push_back('"'); return true;
+        case '\\': _text.push_back('\\'); return true;
+        case '/': _text.push_back('/'); return true;
+        case 'b': _text.push_back('\b'); return true;
+        case 'f': _text.push_back('\f'); return true;
+        case 'n': _text.push_back('\n'); return true;
+        case 'r': _text.push_back('\r'); return true;
+        case 't': _text.push_back('\t'); return true;
+        case 'u': break;
+        default: SetError("Invalid escape sequence"); return false;
+    }
+
+    u32 codepoints[2] = {};
+    for (u32 i = 0; i < 2; ++i)
+    {
+        for (u32 digit = 0; digit < 4; ++digit)
+        {
+            const s32 value = ParseHexDigit(Next());
+            if (value < 0)
+            {
+                SetError("Invalid \\u escape");
+                return false;
+            }
+            codepoints[i] = codepoints[i] << 4 | (u32)value;
+        }
+
+        // A high surrogate needs the low one from the next escape
+        if (i == 0 && (codepoints[0] < 0xD800 || codepoints[0] > 0xDBFF))
+            break;
+        if (i == 0 && (Next() != '\\' || Next() != 'u'))
+        {
+            SetError("Unpaired surrogate");
+            return false;
+        }
+    }
+
+    if (codepoints[1])
+    {
+        if (codepoints[1] < 0xDC00 || codepoints[1] > 0xDFFF)
+        {
+            SetError("Unpaired surrogate");
+            return false;
+        }
+        AppendUtf8(0x10000 + ((codepoints[0] - 0xD800) << 10) + (codepoints[1] - 0xDC00));
+    }
+    else
+    {
+        AppendUtf8(codepoints[0]);
+    }
+    return true;
+}
+
+void JsonReader::AppendUtf8(u32 codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        _text.push_back((char)codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        _text.push_back((char)(0xC0 | codepoint >> 6));
+        _text.push_back((char)(0x80 | (codepoint & 0x3F)));
+    }
+    else if (codepoint < 0x10000)
+    {
+        _text.push_back((char)(0xE0 | codepoint >> 12));
+        _text.push_back((char)(0x80 | (codepoint >> 6 & 0x3F)));
+        _text.push_back((char)(0x80 | (codepoint & 0x3F)));
+    }
+    else
+    {
+        _text.push_back((char)(0xF0 | codepoint >> 18));
+        _text.push_back((char)(0x80 | (codepoint >> 12 & 0x3F)));
+        _text.push_back((char)(0x80 | (codepoint >> 6 & 0x3F)));
+        _text.push_back((char)(0x80 | (codepoint & 0x3F)));
+    }
+}
+}  // namespace DG
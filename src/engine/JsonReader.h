@@ -0,0 +1,134 @@
+/**
+ *  @file    JsonReader.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <cstdio>
+#include <vector>
+#include "engine/Types.h"
+
+namespace DG
+{
+enum class JsonType : u8
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+// One parsed value, children are a linked list in document order
+struct JsonNode
+{
+    JsonType Type;
+    bool Bool;
+    u32 Length;        // Of Text, or the child count of arrays and objects
+    const char* Key;   // Null unless the parent is an object
+    const char* Text;  // Strings unescaped and terminated, numbers as written
+    JsonNode* FirstChild;
+    JsonNode* Next;
+
+    // Null if there is no such member, linear in the member count
+    const JsonNode* Find(const char* key) const;
+
+    // Numbers only
+    u64 AsU64() const;
+    s64 AsS64() const;
+    f64 AsF64() const;
+};
+
+// Reads a document whose top level is one big array, e.g. the actors of a level, one element at a
+// time. The file goes through a fixed buffer and every element is parsed into an arena that is
+// reset for the next one, so memory is bounded by the largest element instead of the file.
+class JsonReader
+{
+   public:
+    enum
+    {
+        BufferSize = 16 * 1024,
+        BlockSize = 64 * 1024,
+        MaxDepth = 64
+    };
+
+    JsonReader() = default;
+    ~JsonReader();
+    JsonReader(const JsonReader&) = delete;
+    JsonReader& operator=(const JsonReader&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    // Consumes the opening bracket of the top level array
+    bool BeginArray();
+    // Next element of the top level array, null after the last one or on errors. Everything the
+    // previous element used is freed.
+    const JsonNode* ReadElement();
+
+    // Scratch memory that lives as long as the current element
+    void* Allocate(u32 size, u32 alignment);
+
+    bool HasError() const { return _error[0] != 0; }
+    const char* GetError() const { return _error; }
+    // Most arena memory a single element needed so far
+    u32 GetHighWaterMark() const { return _used > _hwm ? _used : _hwm; }
+
+   private:
+    struct Block
+    {
+        Block* Next;
+        u32 Size;  // Including this header
+        u32 Used;
+    };
+
+    int Peek()
+    {
+        if (_position == _end && !Refill())
+            return -1;
+        return _buffer[_position];
+    }
+    int Next()
+    {
+        const int c = Peek();
+        if (c >= 0)
+        {
+            _position++;
+            if (c == '\n')
+                _line++;
+        }
+        return c;
+    }
+    bool Refill();
+    void SkipWhitespace();
+    bool Expect(char c);
+    bool ExpectLiteral(const char* literal);
+    void SetError(const char* message);
+
+    JsonNode* ParseValue(u32 depth);
+    JsonNode* ParseNumber();
+    // Unescaped into _text, then copied into the arena
+    const char* ParseString(u32* length);
+    bool ParseEscape();
+    void AppendUtf8(u32 codepoint);
+
+    void ResetArena();
+
+    FILE* _file = nullptr;
+    u8 _buffer[BufferSize];
+    u32 _position = 0;
+    u32 _end = 0;
+    u32 _line = 1;
+    bool _isInArray = false;
+    u32 _elementCount = 0;
+    char _error[256] = {};
+    std::vector<char> _text;
+
+    Block* _first = nullptr;
+    Block* _current = nullptr;
+    u32 _used = 0;
+    u32 _hwm = 0;
+};
+}  // namespace DG
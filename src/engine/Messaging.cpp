@@ -13,6 +13,7 @@ void MessagingSystem::Initialize(StackAllocator* allocator, const Clock* clock)
 {
     _allocator = allocator;
     _messagePool.Initialize(allocator);
+    _messagePool.SetMemoryTag(RegisterMemoryTag("Messages"));
     _clock = clock;
     _isInitialized = true;
 }
@@ -75,6 +76,7 @@ MessageHandle MessagingSystem::RegisterCallback(MessageType type,
     if (_callbackMap.find(type) == _callbackMap.end())
     {
         _callbackMap[type].Initialize(_allocator);
+        _callbackMap[type].SetMemoryTag(RegisterMemoryTag("MessageCallbacks"));
     }
 
     auto& pool = _callbackMap[type];
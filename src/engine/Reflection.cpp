@@ -0,0 +1,29 @@
+/**
+ *  @file    Reflection.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "Reflection.h"
+
+namespace DG
+{
+// Zero initialized before the generated files register
+static const ClassReflection* Reflections[TypeInfo::MaxTypeCount];
+
+bool RegisterClassReflection(const ClassReflection* reflection)
+{
+    Assert(!Reflections[reflection->Type->Index]);
+    u32 fieldsEnd = 0;
+    for (u32 i = 0; i < reflection->FieldCount; ++i)
+    {
+        const FieldReflection& field = reflection->Fields[i];
+        Assert(field.Offset >= fieldsEnd && field.Offset + field.Size <= reflection->Size);
+        fieldsEnd = field.Offset + field.Size;
+    }
+    Reflections[reflection->Type->Index] = reflection;
+    return true;
+}
+
+const ClassReflection* GetClassReflection(TypeId type) { return Reflections[type->Index]; }
+}  // namespace DG
@@ -0,0 +1,119 @@
+/**
+ *  @file    Reflection.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include "engine/Handle.h"
+#include "engine/Type.h"
+#include "math/Transform.h"
+#include "platform/StringIdCRC32.h"
+
+namespace DG
+{
+enum class FieldType : u8
+{
+    Unknown,
+    Bool,
+    S32,
+    U32,
+    F32,
+    Vec3,
+    Quat,
+    Transform,
+    StringId,
+    Handle
+};
+
+template <class T>
+struct FieldTypeOf
+{
+    static const FieldType Value = FieldType::Unknown;
+};
+#define DG_FIELD_TYPE(Type, Tag)                       \
+    template <>                                        \
+    struct FieldTypeOf<Type>                           \
+    {                                                  \
+        static const FieldType Value = FieldType::Tag; \
+    };
+DG_FIELD_TYPE(bool, Bool)
+DG_FIELD_TYPE(s32, S32)
+DG_FIELD_TYPE(u32, U32)
+DG_FIELD_TYPE(f32, F32)
+DG_FIELD_TYPE(vec3, Vec3)
+DG_FIELD_TYPE(quat, Quat)
+DG_FIELD_TYPE(Transform, Transform)
+DG_FIELD_TYPE(StringId, StringId)
+#undef DG_FIELD_TYPE
+template <class T>
+struct FieldTypeOf<Handle<T>>
+{
+    static const FieldType Value = FieldType::Handle;
+};
+
+struct FieldReflection
+{
+    const char* Name;
+    u32 Offset;
+    u32 Size;
+    FieldType Type;
+    bool IsTriviallyCopyable;
+};
+
+// Emitted by the DingoGenerator for every DPROPERTY of a class, fields of the bases are in the
+// reflection of the base. Type->Index doubles as the storage index of the class.
+struct ClassReflection
+{
+    TypeId Type;
+    u32 Size;
+    const FieldReflection* Fields;
+    u32 FieldCount;
+};
+
+// offsetof is only conditionally supported on classes with virtual functions, the address of the
+// member in storage of the class is what it would return
+template <class Class, class Field>
+u32 GetFieldOffset(Field Class::*field)
+{
+    alignas(Class) u8 storage[sizeof(Class)];
+    return (u32)((const u8*)&(reinterpret_cast<const Class*>(storage)->*field) - storage);
+}
+
+// Used by the generated Reflect##Class functions, which are friends and can see private fields
+#define DG_REFLECT_FIELD(Class, Field, Name)                                             \
+    {                                                                                    \
+        Name, GetFieldOffset(&Class::Field), (u32)sizeof(decltype(Class::Field)),        \
+            FieldTypeOf<decltype(Class::Field)>::Value,                                  \
+            std::is_trivially_copyable<decltype(Class::Field)>::value                    \
+    }
+
+// Generated files register during static initialization, always returns true. Asserts that the
+// fields are in declaration order, don't overlap and lie inside the class.
+bool RegisterClassReflection(const ClassReflection* reflection);
+// Null for types without DPROPERTY fields
+const ClassReflection* GetClassReflection(TypeId type);
+
+// Calls function(const FieldReflection&) for the fields of type and all of its bases, bases first
+template <class Function>
+void ForEachReflectedField(TypeId type, const Function& function);
+
+template <class Function>
+void ForEachReflectedField(TypeId type, const Function& function)
+{
+    if (!type)
+        return;
+
+    ForEachReflectedField(type->Base, function);
+    const ClassReflection* reflection = GetClassReflection(type);
+    if (!reflection)
+        return;
+
+    for (u32 i = 0; i < reflection->FieldCount; ++i)
+    {
+        function(reflection->Fields[i]);
+    }
+}
+}  // namespace DG
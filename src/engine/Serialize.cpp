@@ -6,6 +6,8 @@
 
 #include "Serialize.h"
 #include "components/SceneComponent.h"
+#include "engine/JsonReader.h"
+#include "engine/Reflection.h"
 #include "json.hpp"
 
 namespace DG
@@ -19,14 +21,6 @@ nlohmann::json Serialize(const vec3& v3)
     return result;
 }
 
-nlohmann::json Serialize(const BaseComponent* ptr)
-{
-    nlohmann::json json;
-    if (ptr)
-        json["id"] = ptr->GetUniqueId();
-    return json;
-}
-
 nlohmann::json Serialize(const Transform& transform)
 {
     nlohmann::json json;
@@ -48,15 +42,130 @@ nlohmann::json Serialize(const StringId& id)
 
 void SerializeActor(const Actor* actor, nlohmann::json& a)
 {
-    a["type"] = *actor->GetInstanceType();
+    a["type"] = actor->GetInstanceType()->Name;
+    a["handle"] = Serialize(actor->GetHandle());
     nlohmann::json components;
-    for (auto& component : actor->_components)
+    for (auto& handle : actor->GetComponentHandles())
     {
         nlohmann::json c;
-        component->Serialize(c);
+        c["handle"] = Serialize(handle);
+        actor->GetGameWorld()->Resolve(handle)->Serialize(c);
         components.push_back(c);
     }
     a["components"] = components;
-    a["RootComponent"] = actor->GetRootSceneComponent()->GetUniqueId();
+    a["RootComponent"] = Serialize(actor->GetRootSceneComponentHandle());
+}
+
+static bool DeserializeFloats(const JsonNode& json, f32* values, u32 count)
+{
+    if (json.Type != JsonType::Array || json.Length != count)
+        return false;
+    const JsonNode* element = json.FirstChild;
+    for (u32 i = 0; i < count; ++i, element = element->Next)
+    {
+        if (element->Type != JsonType::Number)
+            return false;
+        values[i] = (f32)element->AsF64();
+    }
+    return true;
+}
+
+bool Deserialize(const JsonNode& json, vec3* v3)
+{
+    f32 values[3];
+    if (!DeserializeFloats(json, values, 3))
+        return false;
+    *v3 = vec3(values[0], values[1], values[2]);
+    return true;
+}
+
+bool Deserialize(const JsonNode& json, Transform* transform)
+{
+    const JsonNode* euler = json.Find("euler");
+    const JsonNode* pos = json.Find("pos");
+    const JsonNode* scale = json.Find("scale");
+    vec3 values[3];
+    if (!euler || !pos || !scale || !Deserialize(*euler, &values[0]) ||
+        !Deserialize(*pos, &values[1]) || !Deserialize(*scale, &values[2]))
+        return false;
+    *transform = Transform(values[1], values[0], values[2]);
+    return true;
+}
+
+bool Deserialize(const JsonNode& json, StringId* id)
+{
+    // {"stringid": hash} as written above, ExportWorldFileToJson writes the text or a bare hash
+    const JsonNode* hash = json.Type == JsonType::Object ? json.Find("stringid") : &json;
+    if (hash && hash->Type == JsonType::Number)
+        *id = StringId::FromHash((u32)hash->AsU64());
+    else if (json.Type == JsonType::String)
+        *id = StringId::FromString(json.Text);
+    else
+        return false;
+    return true;
+}
+
+static bool DeserializeField(const FieldReflection& field, u8* value, const JsonNode& json)
+{
+    const bool isNumber = json.Type == JsonType::Number;
+    switch (field.Type)
+    {
+        case FieldType::Bool:
+            if (json.Type != JsonType::Bool)
+                return false;
+            *(bool*)value = json.Bool;
+            return true;
+        case FieldType::S32:
+            if (!isNumber)
+                return false;
+            *(s32*)value = (s32)json.AsS64();
+            return true;
+        case FieldType::U32:
+            if (!isNumber)
+                return false;
+            *(u32*)value = (u32)json.AsU64();
+            return true;
+        case FieldType::F32:
+            if (!isNumber)
+                return false;
+            *(f32*)value = (f32)json.AsF64();
+            return true;
+        case FieldType::Vec3: return Deserialize(json, (vec3*)value);
+        case FieldType::Quat:
+        {
+            f32 values[4];
+            if (!DeserializeFloats(json, values, 4))
+                return false;
+            quat& q = *(quat*)value;
+            q.x = values[0];
+            q.y = values[1];
+            q.z = values[2];
+            q.w = values[3];
+            return true;
+        }
+        case FieldType::Transform: return Deserialize(json, (Transform*)value);
+        case FieldType::StringId: return Deserialize(json, (StringId*)value);
+        case FieldType::Handle:
+            if (!isNumber)
+                return false;
+            *(Handle<TypeBase>*)value = Handle<TypeBase>::FromU64(json.AsU64());
+            return true;
+        case FieldType::Unknown: return true;
+    }
+    return false;
+}
+
+bool DeserializeReflectedFields(TypeId type, void* object, const JsonNode& json)
+{
+    if (json.Type != JsonType::Object)
+        return false;
+
+    bool isValid = true;
+    ForEachReflectedField(type, [&](const FieldReflection& field) {
+        const JsonNode* member = json.Find(field.Name);
+        if (member && isValid)
+            isValid = DeserializeField(field, (u8*)object + field.Offset, *member);
+    });
+    return isValid;
 }
 }  // namespace DG
@@ -9,10 +9,27 @@
 
 namespace DG
 {
+struct JsonNode;
+
 nlohmann::json Serialize(const vec3& v3);
-nlohmann::json Serialize(const BaseComponent* ptr);
 nlohmann::json Serialize(const Transform& transform);
 nlohmann::json Serialize(const StringId& id);
 
+// Handles are stable for the lifetime of the world, they serialize as is
+template <class T>
+nlohmann::json Serialize(Handle<T> handle)
+{
+    return handle.ToU64();
+}
+
 void SerializeActor(const Actor* actor, nlohmann::json& a);
+
+// Counterparts of Serialize for engine/JsonReader.h, false if json has another shape
+bool Deserialize(const JsonNode& json, vec3* v3);
+bool Deserialize(const JsonNode& json, Transform* transform);
+bool Deserialize(const JsonNode& json, StringId* id);
+
+// Sets the reflected fields of type and its bases from the members of the same name, missing
+// members keep their value. False if a member has the wrong shape.
+bool DeserializeReflectedFields(TypeId type, void* object, const JsonNode& json);
 }  // namespace DG
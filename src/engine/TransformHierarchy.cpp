@@ -0,0 +1,277 @@
+/**
+ *  @file    TransformHierarchy.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <atomic>
+#include "platform/Job.h"
+
+namespace DG
+{
+TransformId TransformHierarchy::AddNode(TransformId parent, const mat4& local)
+{
+    TransformId id;
+    if (!_freeIds.empty())
+    {
+        id = _freeIds.back();
+        _freeIds.pop_back();
+    }
+    else
+    {
+        id = (TransformId)_sortedIndex.size();
+        _sortedIndex.push_back(InvalidTransformId);
+    }
+
+    // Appended for now, the next Update sorts it into its level
+    const u32 parentIndex =
+        parent == InvalidTransformId ? InvalidTransformId : _sortedIndex[parent];
+    _sortedIndex[id] = (u32)_ids.size();
+    _local.push_back(local);
+    _world.push_back(parentIndex == InvalidTransformId ? local : _world[parentIndex] * local);
+    _parent.push_back(parentIndex);
+    _changed.push_back(_stamp);
+    _ids.push_back(id);
+    _isStructureDirty = true;
+    return id;
+}
+
+void TransformHierarchy::RemoveNode(TransformId id)
+{
+    const u32 index = _sortedIndex[id];
+    Assert(index != InvalidTransformId && _ids[index] == id);
+
+    // Children left behind become roots on the next Update
+    _ids[index] = InvalidTransformId;
+    _sortedIndex[id] = InvalidTransformId;
+    _freeIds.push_back(id);
+    _isStructureDirty = true;
+}
+
+void TransformHierarchy::SetLocalMatrix(TransformId id, const mat4& local)
+{
+    const u32 index = _sortedIndex[id];
+    _local[index] = local;
+    _changed[index] = _stamp;
+    if (_isStructureDirty)
+        return;  // Rebuild picks up the flag
+
+    const u32 level = FindLevel(index);
+    _levelDirtyBegins[level] = std::min(_levelDirtyBegins[level], index);
+    _levelDirtyEnds[level] = std::max(_levelDirtyEnds[level], index + 1);
+}
+
+const mat4& TransformHierarchy::GetWorldMatrix(TransformId id) const
+{
+    return _world[_sortedIndex[id]];
+}
+
+bool TransformHierarchy::WasChanged(TransformId id) const
+{
+    return _changed[_sortedIndex[id]] == _stamp - 1;
+}
+
+void TransformHierarchy::Update()
+{
+    if (_isStructureDirty)
+        Rebuild();
+
+    const u32 stamp = _stamp++;
+    u32 updatedCount = 0;
+    _lastUpdatedRanges.clear();
+    u32 levelBegin = 0;
+    u32 parentsBegin = 0;
+    u32 parentsEnd = 0;
+    for (u32 level = 0; level < (u32)_levelEnds.size(); ++level)
+    {
+        const u32 levelEnd = _levelEnds[level];
+        u32 begin = _levelDirtyBegins[level];
+        u32 end = _levelDirtyEnds[level];
+        _levelDirtyBegins[level] = InvalidTransformId;
+        _levelDirtyEnds[level] = 0;
+
+        // Children are sorted by parent, the ones below the changed parents are one range
+        if (parentsBegin < parentsEnd)
+        {
+            const auto first = _parent.begin() + levelBegin;
+            const auto last = _parent.begin() + levelEnd;
+            const u32 childrenBegin =
+                (u32)(std::lower_bound(first, last, parentsBegin) - _parent.begin());
+            const u32 childrenEnd =
+                (u32)(std::lower_bound(first, last, parentsEnd) - _parent.begin());
+            if (childrenBegin < childrenEnd)
+            {
+                begin = std::min(begin, childrenBegin);
+                end = std::max(end, childrenEnd);
+            }
+        }
+
+        if (begin < end)
+        {
+            _lastUpdatedRanges.emplace_back(begin, end);
+            if (end - begin >= ParallelThreshold)
+            {
+                std::atomic<u32> rangeUpdatedCount{0};
+                JobSystem::ParallelForRange(end - begin, 0, [&](u32 rangeBegin, u32 rangeEnd) {
+                    rangeUpdatedCount.fetch_add(
+                        UpdateRange(begin + rangeBegin, begin + rangeEnd, stamp),
+                        std::memory_order_relaxed);
+                });
+                updatedCount += rangeUpdatedCount.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                updatedCount += UpdateRange(begin, end, stamp);
+            }
+        }
+
+        parentsBegin = begin;
+        parentsEnd = end;
+        levelBegin = levelEnd;
+    }
+    _lastUpdatedCount = updatedCount;
+}
+
+u32 TransformHierarchy::UpdateRange(u32 begin, u32 end, u32 stamp)
+{
+    u32 updatedCount = 0;
+    for (u32 i = begin; i < end; ++i)
+    {
+        const u32 parent = _parent[i];
+        if (parent == InvalidTransformId)
+        {
+            if (_changed[i] != stamp)
+                continue;
+            _world[i] = _local[i];
+        }
+        else
+        {
+            if (_changed[i] != stamp && _changed[parent] != stamp)
+                continue;
+            _changed[i] = stamp;
+            _world[i] = _world[parent] * _local[i];
+        }
+        updatedCount++;
+    }
+    return updatedCount;
+}
+
+u32 TransformHierarchy::FindLevel(u32 index) const
+{
+    return (u32)(std::upper_bound(_levelEnds.begin(), _levelEnds.end(), index) -
+                 _levelEnds.begin());
+}
+
+void TransformHierarchy::Rebuild()
+{
+    // Parents come before children (appending keeps that up), so depths resolve in one pass
+    const u32 count = (u32)_ids.size();
+    std::vector<u32> depths(count);
+    std::vector<u32> levelSizes;
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (_ids[i] == InvalidTransformId)
+            continue;
+
+        u32 parent = _parent[i];
+        if (parent != InvalidTransformId && _ids[parent] == InvalidTransformId)
+        {
+            _parent[i] = parent = InvalidTransformId;
+            _changed[i] = _stamp;
+        }
+        depths[i] = parent == InvalidTransformId ? 0 : depths[parent] + 1;
+        if (depths[i] == levelSizes.size())
+            levelSizes.push_back(0);
+        levelSizes[depths[i]]++;
+    }
+
+    _levelEnds.resize(levelSizes.size());
+    u32 levelEnd = 0;
+    for (u32 level = 0; level < (u32)levelSizes.size(); ++level)
+    {
+        levelEnd += levelSizes[level];
+        _levelEnds[level] = levelEnd;
+    }
+
+    // Bucket by depth, then order every level by the new index of the parent
+    std::vector<u32> order(levelEnd);
+    std::vector<u32> fill(levelSizes.size(), 0);
+    for (u32 level = 1; level < (u32)fill.size(); ++level) fill[level] = _levelEnds[level - 1];
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (_ids[i] != InvalidTransformId)
+            order[fill[depths[i]]++] = i;
+    }
+
+    std::vector<u32> newIndex(count, InvalidTransformId);
+    u32 levelBegin = 0;
+    for (u32 level = 0; level < (u32)_levelEnds.size(); ++level)
+    {
+        if (level > 0)
+        {
+            std::stable_sort(
+                order.begin() + levelBegin, order.begin() + _levelEnds[level],
+                [&](u32 a, u32 b) { return newIndex[_parent[a]] < newIndex[_parent[b]]; });
+        }
+        for (u32 i = levelBegin; i < _levelEnds[level]; ++i) newIndex[order[i]] = i;
+        levelBegin = _levelEnds[level];
+    }
+
+    std::vector<mat4> local(levelEnd);
+    std::vector<mat4> world(levelEnd);
+    std::vector<u32> parents(levelEnd);
+    std::vector<u32> changed(levelEnd);
+    std::vector<TransformId> ids(levelEnd);
+    for (u32 i = 0; i < levelEnd; ++i)
+    {
+        const u32 from = order[i];
+        local[i] = _local[from];
+        world[i] = _world[from];
+        parents[i] =
+            _parent[from] == InvalidTransformId ? InvalidTransformId : newIndex[_parent[from]];
+        changed[i] = _changed[from];
+        ids[i] = _ids[from];
+        _sortedIndex[ids[i]] = i;
+    }
+    _local.swap(local);
+    _world.swap(world);
+    _parent.swap(parents);
+    _changed.swap(changed);
+    _ids.swap(ids);
+
+    _levelDirtyBegins.assign(_levelEnds.size(), InvalidTransformId);
+    _levelDirtyEnds.assign(_levelEnds.size(), 0);
+    levelBegin = 0;
+    for (u32 level = 0; level < (u32)_levelEnds.size(); ++level)
+    {
+        for (u32 i = levelBegin; i < _levelEnds[level]; ++i)
+        {
+            if (_changed[i] != _stamp)
+                continue;
+            _levelDirtyBegins[level] = std::min(_levelDirtyBegins[level], i);
+            _levelDirtyEnds[level] = i + 1;
+        }
+        levelBegin = _levelEnds[level];
+    }
+    _isStructureDirty = false;
+}
+
+void TransformHierarchy::Clear()
+{
+    _local.clear();
+    _world.clear();
+    _parent.clear();
+    _changed.clear();
+    _ids.clear();
+    _sortedIndex.clear();
+    _freeIds.clear();
+    _levelEnds.clear();
+    _levelDirtyBegins.clear();
+    _levelDirtyEnds.clear();
+    _lastUpdatedRanges.clear();
+    _lastUpdatedCount = 0;
+    _isStructureDirty = false;
+}
+}  // namespace DG
@@ -0,0 +1,91 @@
+/**
+ *  @file    TransformHierarchy.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <utility>
+#include <vector>
+#include "engine/Types.h"
+#include "math/GLMInclude.h"
+
+namespace DG
+{
+typedef u32 TransformId;
+const TransformId InvalidTransformId = 0xFFFFFFFF;
+
+// World matrices of every scene node in flat arrays sorted by depth and then by parent. Parents
+// come before their children, each level is one contiguous range and the children of a range of
+// parents are a range again. Ids stay stable, the arrays get re-sorted when nodes come and go.
+// Setting a local matrix only flags the node. Update walks the levels once and only visits the
+// flagged range of each level plus the children of what changed one level up.
+class TransformHierarchy
+{
+   public:
+    enum
+    {
+        // Levels with fewer nodes are not worth splitting into jobs
+        ParallelThreshold = 4096
+    };
+
+    TransformId AddNode(TransformId parent, const mat4& local);
+    void RemoveNode(TransformId id);
+    void SetLocalMatrix(TransformId id, const mat4& local);
+
+    // Up to date as of the last Update, nodes added since then have their parent applied already
+    const mat4& GetWorldMatrix(TransformId id) const;
+    // The world matrix changed during the last Update
+    bool WasChanged(TransformId id) const;
+    // Calls function(TransformId, const mat4& world) for every node the last Update changed, only
+    // walks the ranges it visited
+    template <class Function>
+    void ForEachChanged(const Function& function) const;
+
+    void Update();
+    void Clear();
+
+    u32 GetNodeCount() const { return (u32)_ids.size(); }
+    u32 GetLastUpdatedCount() const { return _lastUpdatedCount; }
+
+   private:
+    void Rebuild();
+    u32 UpdateRange(u32 begin, u32 end, u32 stamp);
+    u32 FindLevel(u32 index) const;
+
+    // Indexed by position in the sorted arrays
+    std::vector<mat4> _local;
+    std::vector<mat4> _world;
+    std::vector<u32> _parent;   // Sorted index or InvalidTransformId
+    std::vector<u32> _changed;  // Stamp of the last Update that touched the node
+    std::vector<TransformId> _ids;
+
+    // Indexed by id
+    std::vector<u32> _sortedIndex;
+    std::vector<TransformId> _freeIds;
+
+    // Indexed by depth, the dirty range is empty when begin >= end
+    std::vector<u32> _levelEnds;
+    std::vector<u32> _levelDirtyBegins;
+    std::vector<u32> _levelDirtyEnds;
+    std::vector<std::pair<u32, u32>> _lastUpdatedRanges;
+
+    u32 _stamp = 1;  // Stamp of the next Update
+    u32 _lastUpdatedCount = 0;
+    bool _isStructureDirty = false;
+};
+
+template <class Function>
+void TransformHierarchy::ForEachChanged(const Function& function) const
+{
+    const u32 stamp = _stamp - 1;
+    for (const std::pair<u32, u32>& range : _lastUpdatedRanges)
+    {
+        for (u32 i = range.first; i < range.second; ++i)
+        {
+            if (_changed[i] == stamp && _ids[i] != InvalidTransformId)
+                function(_ids[i], _world[i]);
+        }
+    }
+}
+}  // namespace DG
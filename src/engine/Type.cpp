@@ -8,6 +8,18 @@
 
 namespace DG
 {
+// Zero before any dynamic initialization runs
+static u32 TypeCount = 0;
+
+TypeInfo::TypeInfo(const char* name, const TypeInfo* base)
+    : Name(name), Base(base), Index(TypeCount++), Mask((TypeMask)1 << Index)
+{
+    Assert(Index < MaxTypeCount);
+    Ancestry = Mask | (base ? base->Ancestry : 0);
+}
+
+u32 TypeInfo::GetTypeCount() { return TypeCount; }
+
 // void Test()
 //{
 //    A* a = new A();
@@ -10,8 +10,32 @@
 
 namespace DG
 {
-typedef const char* TypeLoc;
-typedef TypeLoc* TypeId;
+typedef u64 TypeMask;
+
+// Every class with DECLARE_CLASS_TYPE gets one of these. Indices are dense and handed out during
+// static initialization, bases always get theirs first. Ancestry has the bit of the type itself
+// and of all of its bases, so "is T or derived from T" is a single AND.
+struct TypeInfo
+{
+    enum
+    {
+        MaxTypeCount = 64
+    };
+
+    TypeInfo(const char* name, const TypeInfo* base);
+
+    const char* Name;
+    const TypeInfo* Base;
+    u32 Index;
+    TypeMask Mask;  // 1 << Index
+    TypeMask Ancestry;
+
+    static u32 GetTypeCount();
+};
+typedef const TypeInfo* TypeId;
+
+// Generated by the DingoGenerator, see engine/Reflection.h
+struct ClassReflection;
 
 #ifdef __CODE_GENERATOR__
 #define DPROPERTY __attribute__((annotate("DPROPERTY")))
@@ -20,40 +44,22 @@ typedef TypeLoc* TypeId;
 #endif
 
 #define STRFY(a) #a
-#define DECLARE_CLASS_TYPE(Class, BaseClass)                                         \
-    friend void Serialize##Class(const Class* component, nlohmann::json& json);      \
-                                                                                     \
-   public:                                                                           \
-    template <class T>                                                               \
-    SDL_FORCE_INLINE bool IsTypeOrDerivedType() const                                \
-    {                                                                                \
-        const TypeId type = T::GetClassType();                                       \
-        return IsTypeOrDerivedType(type);                                            \
-    }                                                                                \
-    SDL_FORCE_INLINE bool IsTypeOrDerivedType(TypeId type) const override            \
-    {                                                                                \
-        return Class::IsTypeInternal(type) || BaseClass::IsTypeOrDerivedType(type);  \
-    }                                                                                \
-    SDL_FORCE_INLINE void Serialize(nlohmann::json& json) const override             \
-    {                                                                                \
-        BaseClass::Serialize(json);                                                  \
-        Serialize##Class(this, json);                                                \
-    }                                                                                \
-                                                                                     \
-   private:                                                                          \
-    SDL_FORCE_INLINE bool IsTypeInternal(TypeId type) const override                 \
-    {                                                                                \
-        auto myType = Class::GetInstanceType();                                      \
-        return type == myType;                                                       \
-    }                                                                                \
-                                                                                     \
-   public:                                                                           \
-    SDL_FORCE_INLINE TypeId GetInstanceType() const override { return &s_myTypeId; } \
-    SDL_FORCE_INLINE static TypeId GetClassType() { return &s_myTypeId; }            \
-    operator TypeId() const { return GetInstanceType(); }                            \
-                                                                                     \
-   private:                                                                          \
-    inline static TypeLoc s_myTypeId = STRFY(Class);
+#define DECLARE_CLASS_TYPE(Class, BaseClass)                                           \
+    friend void Serialize##Class(const Class* component, nlohmann::json& json);        \
+    friend const ClassReflection* Reflect##Class();                                    \
+                                                                                       \
+   public:                                                                             \
+    SDL_FORCE_INLINE void Serialize(nlohmann::json& json) const override               \
+    {                                                                                  \
+        BaseClass::Serialize(json);                                                    \
+        Serialize##Class(this, json);                                                  \
+    }                                                                                  \
+    SDL_FORCE_INLINE TypeId GetInstanceType() const override { return &s_typeInfo; }   \
+    SDL_FORCE_INLINE static TypeId GetClassType() { return &s_typeInfo; }              \
+    operator TypeId() const { return GetInstanceType(); }                              \
+                                                                                       \
+   private:                                                                            \
+    inline static const TypeInfo s_typeInfo{STRFY(Class), BaseClass::GetClassType()};
 
 class TypeBase
 {
@@ -63,39 +69,27 @@ class TypeBase
     template <typename T>
     SDL_FORCE_INLINE bool IsTypeOrDerivedType() const
     {
-        const TypeId type = T::GetClassType();
-        return IsTypeOrDerivedType(type);
+        return IsTypeOrDerivedType(T::GetClassType());
     }
-    SDL_FORCE_INLINE virtual bool IsTypeOrDerivedType(TypeId type) const
+    SDL_FORCE_INLINE bool IsTypeOrDerivedType(TypeId type) const
     {
-        return TypeBase::IsTypeInternal(type);
-    };
+        return (GetInstanceType()->Ancestry & type->Mask) != 0;
+    }
     template <class T>
     SDL_FORCE_INLINE bool IsType() const
     {
         return T::GetClassType() == GetInstanceType();
     }
-    SDL_FORCE_INLINE virtual bool IsType(TypeId type) const { return type == GetInstanceType(); }
-    SDL_FORCE_INLINE virtual TypeId GetInstanceType() const { return &s_myTypeId; };
-    SDL_FORCE_INLINE static TypeId GetClassType() { return &s_myTypeId; }
+    SDL_FORCE_INLINE bool IsType(TypeId type) const { return type == GetInstanceType(); }
+    SDL_FORCE_INLINE virtual TypeId GetInstanceType() const { return &s_typeInfo; };
+    SDL_FORCE_INLINE static TypeId GetClassType() { return &s_typeInfo; }
 
     SDL_FORCE_INLINE virtual void Serialize(nlohmann::json& json) const
     {
-        json["id"] = _uniqueId;
-        json["type"] = *GetInstanceType();
+        json["type"] = GetInstanceType()->Name;
     }
 
-    SDL_FORCE_INLINE u32 GetUniqueId() const { return _uniqueId; }
-
    private:
-    SDL_FORCE_INLINE virtual bool IsTypeInternal(TypeId type) const
-    {
-        return type == TypeBase::GetInstanceType();
-    }
-
-    u32 _uniqueId = uniqueCounter++;
-
-    inline static TypeLoc s_myTypeId = STRFY(TypeBase);
-    inline static u32 uniqueCounter = 0;
+    inline static const TypeInfo s_typeInfo{STRFY(TypeBase), nullptr};
 };
 }  // namespace DG
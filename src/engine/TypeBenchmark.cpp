@@ -0,0 +1,172 @@
+/**
+ *  @file    TypeBenchmark.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "TypeBenchmark.h"
+
+// The benchmark classes take type indices and ancestry bits, only builds that run it get them
+#if DG_TYPE_BENCHMARK
+#include <random>
+#include <vector>
+#include "engine/Type.h"
+
+namespace DG
+{
+static const u32 OBJECT_COUNT = 1000 * 1000;
+static const u32 ITERATIONS = 10;
+
+class BenchmarkA : public TypeBase
+{
+    DECLARE_CLASS_TYPE(BenchmarkA, TypeBase)
+};
+class BenchmarkB : public BenchmarkA
+{
+    DECLARE_CLASS_TYPE(BenchmarkB, BenchmarkA)
+};
+class BenchmarkC : public BenchmarkB
+{
+    DECLARE_CLASS_TYPE(BenchmarkC, BenchmarkB)
+};
+class BenchmarkD : public BenchmarkC
+{
+    DECLARE_CLASS_TYPE(BenchmarkD, BenchmarkC)
+};
+void SerializeBenchmarkA(const BenchmarkA*, nlohmann::json&) {}
+void SerializeBenchmarkB(const BenchmarkB*, nlohmann::json&) {}
+void SerializeBenchmarkC(const BenchmarkC*, nlohmann::json&) {}
+void SerializeBenchmarkD(const BenchmarkD*, nlohmann::json&) {}
+
+// What DECLARE_CLASS_TYPE used to generate, every level asks its base through a virtual call
+typedef const char* const* LegacyTypeId;
+#define LEGACY_CLASS_TYPE(Class, BaseClass)                                                   \
+   public:                                                                                    \
+    bool IsTypeOrDerivedType(LegacyTypeId type) const override                                \
+    {                                                                                         \
+        return Class::IsTypeInternal(type) || BaseClass::IsTypeOrDerivedType(type);           \
+    }                                                                                         \
+    LegacyTypeId GetInstanceType() const override { return &s_myTypeId; }                     \
+    static LegacyTypeId GetClassType() { return &s_myTypeId; }                                \
+                                                                                              \
+   private:                                                                                   \
+    bool IsTypeInternal(LegacyTypeId type) const override { return type == &s_myTypeId; }    \
+    inline static const char* s_myTypeId = STRFY(Class);
+
+class LegacyBase
+{
+   public:
+    virtual ~LegacyBase() = default;
+    virtual bool IsTypeOrDerivedType(LegacyTypeId type) const
+    {
+        return LegacyBase::IsTypeInternal(type);
+    }
+    virtual LegacyTypeId GetInstanceType() const { return &s_myTypeId; }
+    static LegacyTypeId GetClassType() { return &s_myTypeId; }
+
+   private:
+    virtual bool IsTypeInternal(LegacyTypeId type) const { return type == &s_myTypeId; }
+    inline static const char* s_myTypeId = "LegacyBase";
+};
+class LegacyA : public LegacyBase
+{
+    LEGACY_CLASS_TYPE(LegacyA, LegacyBase)
+};
+class LegacyB : public LegacyA
+{
+    LEGACY_CLASS_TYPE(LegacyB, LegacyA)
+};
+class LegacyC : public LegacyB
+{
+    LEGACY_CLASS_TYPE(LegacyC, LegacyB)
+};
+class LegacyD : public LegacyC
+{
+    LEGACY_CLASS_TYPE(LegacyD, LegacyC)
+};
+
+static f64 ElapsedMs(u64 start)
+{
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           (f64)SDL_GetPerformanceFrequency();
+}
+
+template <class Object, class Function>
+static f64 Measure(const std::vector<Object*>& objects, u32* hits, const Function& check)
+{
+    const u64 start = SDL_GetPerformanceCounter();
+    u32 count = 0;
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (const Object* object : objects)
+        {
+            count += check(object) ? 1 : 0;
+        }
+    }
+    *hits = count;
+    return ElapsedMs(start) / ITERATIONS;
+}
+
+// Packed back to back like components in their chunks, so the check dominates and not cache misses
+template <class A, class B, class C, class D, class Base>
+static void CreateObjects(std::vector<u8>* storage, std::vector<Base*>* objects)
+{
+    static_assert(sizeof(D) >= sizeof(A) && sizeof(D) >= sizeof(B) && sizeof(D) >= sizeof(C),
+                  "D has to be the biggest");
+    storage->resize(OBJECT_COUNT * sizeof(D));
+
+    // Same seed for both hierarchies, the types come in the same random order
+    std::mt19937 random(42);
+    for (u32 i = 0; i < OBJECT_COUNT; ++i)
+    {
+        u8* memory = storage->data() + i * sizeof(D);
+        switch (random() % 4)
+        {
+            case 0: objects->push_back(new (memory) A()); break;
+            case 1: objects->push_back(new (memory) B()); break;
+            case 2: objects->push_back(new (memory) C()); break;
+            default: objects->push_back(new (memory) D()); break;
+        }
+    }
+}
+
+void RunTypeCheckBenchmark()
+{
+    // Nothing in either hierarchy needs its destructor to run
+    std::vector<u8> storage;
+    std::vector<TypeBase*> objects;
+    CreateObjects<BenchmarkA, BenchmarkB, BenchmarkC, BenchmarkD>(&storage, &objects);
+    std::vector<u8> legacyStorage;
+    std::vector<LegacyBase*> legacyObjects;
+    CreateObjects<LegacyA, LegacyB, LegacyC, LegacyD>(&legacyStorage, &legacyObjects);
+
+    SDL_Log("Type check benchmark, %u objects, %u iterations", OBJECT_COUNT, ITERATIONS);
+
+    // Derived from B hits C and D after two and three levels of the old chain
+    u32 hits, legacyHits;
+    f64 ms = Measure(objects, &hits,
+                     [](const TypeBase* o) { return o->IsTypeOrDerivedType<BenchmarkB>(); });
+    f64 legacyMs = Measure(legacyObjects, &legacyHits, [](const LegacyBase* o) {
+        return o->IsTypeOrDerivedType(LegacyB::GetClassType());
+    });
+    SDL_Log("  IsTypeOrDerivedType<B>: ancestry %8.3fms, virtual chain %8.3fms, %.1fx (%u/%u)", ms,
+            legacyMs, ms > 0.0 ? legacyMs / ms : 0.0, hits, legacyHits);
+
+    // TypeBase is the worst case for the chain, it has to walk all the way up
+    ms = Measure(objects, &hits,
+                 [](const TypeBase* o) { return o->IsTypeOrDerivedType<TypeBase>(); });
+    legacyMs = Measure(legacyObjects, &legacyHits, [](const LegacyBase* o) {
+        return o->IsTypeOrDerivedType(LegacyBase::GetClassType());
+    });
+    SDL_Log("  IsTypeOrDerivedType<Base>: ancestry %8.3fms, virtual chain %8.3fms, %.1fx (%u/%u)",
+            ms, legacyMs, ms > 0.0 ? legacyMs / ms : 0.0, hits, legacyHits);
+
+    ms = Measure(objects, &hits, [](const TypeBase* o) { return o->IsType<BenchmarkD>(); });
+    legacyMs = Measure(legacyObjects, &legacyHits, [](const LegacyBase* o) {
+        return o->GetInstanceType() == LegacyD::GetClassType();
+    });
+    SDL_Log("  IsType<D>: ancestry %8.3fms, virtual chain %8.3fms, %.1fx (%u/%u)", ms, legacyMs,
+            ms > 0.0 ? legacyMs / ms : 0.0, hits, legacyHits);
+}
+}  // namespace DG
+#endif
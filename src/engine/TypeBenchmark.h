@@ -0,0 +1,14 @@
+/**
+ *  @file    TypeBenchmark.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+
+namespace DG
+{
+// Runs IsType and IsTypeOrDerivedType over a million objects of a four level hierarchy against a
+// copy of the old chain of virtual calls and logs the results. Only built with DG_TYPE_BENCHMARK.
+void RunTypeCheckBenchmark();
+}  // namespace DG
@@ -0,0 +1,538 @@
+/**
+ *  @file    WorldBenchmark.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "WorldBenchmark.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include "components/SceneComponent.h"
+#include "components/StaticMeshComponent.h"
+#include "engine/AABBTree.h"
+#include "engine/JsonReader.h"
+#include "engine/Serialize.h"
+#include "engine/TransformHierarchy.h"
+#include "json.hpp"
+#include "memory/VirtualMemory.h"
+#include "platform/Job.h"
+
+namespace DG
+{
+// Enough for an actor, its component vector and its row, actor memory is a tenth of the world
+static const u32 WORLD_BYTES_PER_ACTOR = 1536;
+static const u32 ITERATIONS = 10;
+static const u32 HIERARCHY_DEPTH = 8;
+static const u32 COMMAND_BUFFER_ACTORS = 100 * 1000;
+static const u32 CLONE_ACTORS = 100 * 1000;
+static const u32 FILE_ACTORS = 1000 * 1000;  // One scene component each
+static const u32 SPATIAL_OBJECTS = 1000 * 1000;
+static const u32 SPATIAL_QUERIES = 10 * 1000;
+static const f32 SPATIAL_EXTENT = 2000.f;  // Objects lie in a slab this wide and a tenth as high
+static const char* const BENCHMARK_WORLD_FILE = "WorldBenchmark.dgworld";
+static const char* const BENCHMARK_JSON_FILE = "WorldBenchmark.json";
+
+static f64 ElapsedMs(u64 start)
+{
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           (f64)SDL_GetPerformanceFrequency();
+}
+
+static void MeasureWorld(u32 actorCount)
+{
+    const u32 worldSize = actorCount * WORLD_BYTES_PER_ACTOR;
+    u8* memory = ReserveVirtualMemory(worldSize, false);
+    if (!memory || !CommitVirtualMemory(memory, worldSize))
+    {
+        SDL_LogError(0, "Couldn't reserve %u bytes for the world benchmark", worldSize);
+        return;
+    }
+
+    GameWorld* world = new GameWorld();
+    world->Startup(memory, (s32)worldSize);
+    for (u32 i = 0; i < actorCount; ++i)
+    {
+        world->CreateActor<Actor>();
+    }
+
+    // Both read the same transforms, the sum keeps the loops from being optimized away
+    vec3 eachSum(0);
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        world->Each<SceneComponent>([&](const SceneComponent& sceneComponent) {
+            eachSum += sceneComponent.GetLocalTransform().GetPosition();
+        });
+    }
+    const f64 eachMs = ElapsedMs(start) / ITERATIONS;
+
+    vec3 walkSum(0);
+    start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (Actor* actor : world->GetAllActors())
+        {
+            auto sceneComponents = actor->GetComponentsOfType(SceneComponent::GetClassType());
+            for (auto& component : sceneComponents)
+            {
+                walkSum += ((SceneComponent*)component)->GetLocalTransform().GetPosition();
+            }
+        }
+    }
+    const f64 walkMs = ElapsedMs(start) / ITERATIONS;
+
+    SDL_Log("  %7u actors: Each %8.3fms, actor walk %8.3fms, %.1fx (%f)", actorCount, eachMs,
+            walkMs, eachMs > 0.0 ? walkMs / eachMs : 0.0, eachSum.x + walkSum.x);
+
+    // Components live in world memory, only the actors own heap memory
+    for (Actor* actor : world->GetAllActors())
+    {
+        actor->~Actor();
+    }
+    world->Shutdown();
+    delete world;
+    ReleaseVirtualMemory(memory, worldSize);
+}
+
+void RunWorldIterationBenchmark()
+{
+    SDL_Log("World iteration benchmark, one SceneComponent per actor, %u iterations", ITERATIONS);
+    MeasureWorld(10 * 1000);
+    MeasureWorld(100 * 1000);
+    MeasureWorld(1000 * 1000);
+}
+
+static void MeasureHierarchy(u32 treeCount)
+{
+    const u32 nodeCount = treeCount * HIERARCHY_DEPTH;
+    std::vector<Transform> transforms(nodeCount);
+    std::vector<u32> parents(nodeCount);
+    std::vector<TransformId> ids(nodeCount);
+    TransformHierarchy hierarchy;
+    for (u32 i = 0; i < nodeCount; ++i)
+    {
+        const bool isRoot = i % HIERARCHY_DEPTH == 0;
+        transforms[i].SetPos(vec3(0, 1, 0));
+        parents[i] = isRoot ? InvalidTransformId : i - 1;
+        ids[i] = hierarchy.AddNode(isRoot ? InvalidTransformId : ids[i - 1],
+                                   transforms[i].GetModelMatrix());
+    }
+    hierarchy.Update();
+
+    std::mt19937 random(nodeCount);
+    const u32 changesPerFrame = nodeCount / 100;
+
+    // What every query did before, walk the chain up to the root
+    mat4 chainSum(0);
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (u32 i = 0; i < changesPerFrame; ++i)
+        {
+            transforms[random() % nodeCount].SetPos(vec3(0, 1, (f32)iteration));
+        }
+        for (u32 i = 0; i < nodeCount; ++i)
+        {
+            mat4 model = transforms[i].GetModelMatrix();
+            for (u32 parent = parents[i]; parent != InvalidTransformId; parent = parents[parent])
+            {
+                model = transforms[parent].GetModelMatrix() * model;
+            }
+            chainSum += model;
+        }
+    }
+    const f64 chainMs = ElapsedMs(start) / ITERATIONS;
+
+    mat4 hierarchySum(0);
+    start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (u32 i = 0; i < changesPerFrame; ++i)
+        {
+            const u32 node = random() % nodeCount;
+            transforms[node].SetPos(vec3(0, 1, (f32)iteration));
+            hierarchy.SetLocalMatrix(ids[node], transforms[node].GetModelMatrix());
+        }
+        hierarchy.Update();
+        for (u32 i = 0; i < nodeCount; ++i)
+        {
+            hierarchySum += hierarchy.GetWorldMatrix(ids[i]);
+        }
+    }
+    const f64 hierarchyMs = ElapsedMs(start) / ITERATIONS;
+
+    SDL_Log("  %7u nodes: chain walk %8.3fms, hierarchy %8.3fms (%u updated), %.1fx (%f)",
+            nodeCount, chainMs, hierarchyMs, hierarchy.GetLastUpdatedCount(),
+            hierarchyMs > 0.0 ? chainMs / hierarchyMs : 0.0, chainSum[3].y + hierarchySum[3].y);
+}
+
+void RunTransformHierarchyBenchmark()
+{
+    SDL_Log("Transform hierarchy benchmark, %u deep, 1%% changed per frame, %u iterations",
+            HIERARCHY_DEPTH, ITERATIONS);
+    MeasureHierarchy(1000);
+    MeasureHierarchy(10 * 1000);
+    MeasureHierarchy(100 * 1000);
+}
+
+void RunCommandBufferBenchmark()
+{
+    const u32 worldSize = COMMAND_BUFFER_ACTORS * WORLD_BYTES_PER_ACTOR;
+    u8* memory = ReserveVirtualMemory(worldSize, false);
+    if (!memory || !CommitVirtualMemory(memory, worldSize))
+    {
+        SDL_LogError(0, "Couldn't reserve %u bytes for the command buffer benchmark", worldSize);
+        return;
+    }
+
+    GameWorld* world = new GameWorld();
+    world->Startup(memory, (s32)worldSize);
+
+    // A duck each, the renderer loaded the model before the benchmarks run
+    u64 start = SDL_GetPerformanceCounter();
+    JobSystem::ParallelForRange(COMMAND_BUFFER_ACTORS, 0, [world](u32 begin, u32 end) {
+        WorldCommandBuffer* commands = world->GetCommandBuffer();
+        for (u32 i = begin; i < end; ++i)
+        {
+            Transform transform;
+            transform.SetPos(vec3((f32)(i % 300), 0, (f32)(i / 300)));
+            const PendingActor actor = commands->SpawnActor<Actor>();
+            commands->AddComponent<StaticMeshComponent>(actor, StringId("DuckModel"), transform);
+        }
+    });
+    const f64 recordSpawnMs = ElapsedMs(start);
+
+    start = SDL_GetPerformanceCounter();
+    world->PlaybackCommandBuffers();
+    const f64 playbackSpawnMs = ElapsedMs(start);
+    Assert(world->GetAllActors().size() == COMMAND_BUFFER_ACTORS);
+    u32 duckCount = 0;
+    world->Each<SceneComponent, StaticMeshComponent>(
+        [&duckCount](const SceneComponent&, const StaticMeshComponent&) { duckCount++; });
+    Assert(duckCount == COMMAND_BUFFER_ACTORS);
+
+    // Every other actor, destroying swaps actors around so go through the handles
+    std::vector<Handle<Actor>> handles;
+    for (Actor* actor : world->GetAllActors()) handles.push_back(actor->GetHandle());
+    start = SDL_GetPerformanceCounter();
+    JobSystem::ParallelForRange((u32)handles.size() / 2, 0, [&](u32 begin, u32 end) {
+        WorldCommandBuffer* commands = world->GetCommandBuffer();
+        for (u32 i = begin; i < end; ++i) commands->DestroyActor(handles[2 * i]);
+    });
+    const f64 recordDestroyMs = ElapsedMs(start);
+
+    start = SDL_GetPerformanceCounter();
+    world->PlaybackCommandBuffers();
+    const f64 playbackDestroyMs = ElapsedMs(start);
+
+    SDL_Log("Command buffer benchmark, %u duck actors spawned and %u destroyed",
+            COMMAND_BUFFER_ACTORS, COMMAND_BUFFER_ACTORS / 2);
+    SDL_Log("  spawn: record %8.3fms, playback %8.3fms", recordSpawnMs, playbackSpawnMs);
+    SDL_Log("  destroy: record %8.3fms, playback %8.3fms", recordDestroyMs, playbackDestroyMs);
+
+    for (Actor* actor : world->GetAllActors())
+    {
+        actor->~Actor();
+    }
+    world->Shutdown();
+    delete world;
+    ReleaseVirtualMemory(memory, worldSize);
+}
+
+static GameWorld* StartWorld(u8* memory, u32 worldSize)
+{
+    GameWorld* world = new GameWorld();
+    world->Startup(memory, (s32)worldSize);
+    return world;
+}
+
+static void StopWorld(GameWorld* world)
+{
+    for (Actor* actor : world->GetAllActors())
+    {
+        actor->~Actor();
+    }
+    world->Shutdown();
+    delete world;
+}
+
+static vec3 SumPositions(const GameWorld* world)
+{
+    vec3 sum(0);
+    world->Each<SceneComponent>([&](const SceneComponent& sceneComponent) {
+        sum += sceneComponent.GetLocalTransform().GetPosition();
+    });
+    return sum;
+}
+
+void RunWorldCloneBenchmark()
+{
+    // Three worlds of the same size: the edit world and one copy per method
+    const u32 worldSize = CLONE_ACTORS * WORLD_BYTES_PER_ACTOR;
+    u8* memory = ReserveVirtualMemory(3 * worldSize, false);
+    if (!memory || !CommitVirtualMemory(memory, 3 * worldSize))
+    {
+        SDL_LogError(0, "Couldn't reserve %u bytes for the world clone benchmark", 3 * worldSize);
+        return;
+    }
+
+    GameWorld* source = StartWorld(memory, worldSize);
+    for (u32 i = 0; i < CLONE_ACTORS; ++i)
+    {
+        Transform transform;
+        transform.SetPos(vec3((f32)(i % 100), 0, (f32)(i / 100)));
+        source->CreateActor<Actor>()->GetRootSceneComponent()->SetLocalTransform(transform);
+    }
+    source->GetTransformHierarchy()->Update();
+
+    GameWorld* clone = StartWorld(memory + worldSize, worldSize);
+    u64 start = SDL_GetPerformanceCounter();
+    source->CloneInto(clone);
+    const f64 cloneMs = ElapsedMs(start);
+
+    GameWorld* rebuilt = StartWorld(memory + 2 * worldSize, worldSize);
+    start = SDL_GetPerformanceCounter();
+    for (Actor* actor : source->GetAllActors())
+    {
+        rebuilt->CreateActor<Actor>()->GetRootSceneComponent()->SetLocalTransform(
+            actor->GetRootSceneComponent()->GetLocalTransform());
+    }
+    rebuilt->GetTransformHierarchy()->Update();
+    const f64 rebuildMs = ElapsedMs(start);
+
+    const vec3 sourceSum = SumPositions(source);
+    Assert(SumPositions(clone) == sourceSum && SumPositions(rebuilt) == sourceSum);
+    SDL_Log("World clone benchmark, %u actors: CloneInto %8.3fms, recreating %8.3fms, %.1fx",
+            CLONE_ACTORS, cloneMs, rebuildMs, cloneMs > 0.0 ? rebuildMs / cloneMs : 0.0);
+
+    StopWorld(rebuilt);
+    StopWorld(clone);
+    StopWorld(source);
+    ReleaseVirtualMemory(memory, 3 * worldSize);
+}
+
+static f64 GetFileSizeMB(const char* path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return (f64)file.tellg() / (1024.0 * 1024.0);
+}
+
+void RunWorldFileBenchmark()
+{
+    // The saved world and the one loading the file
+    const u64 worldSize = (u64)FILE_ACTORS * WORLD_BYTES_PER_ACTOR;
+    u8* memory = ReserveVirtualMemory(2 * worldSize, false);
+    if (!memory || !CommitVirtualMemory(memory, 2 * worldSize))
+    {
+        SDL_LogError(0, "Couldn't reserve %llu bytes for the world file benchmark",
+                     (unsigned long long)(2 * worldSize));
+        return;
+    }
+
+    GameWorld* source = StartWorld(memory, (u32)worldSize);
+    for (u32 i = 0; i < FILE_ACTORS; ++i)
+    {
+        Transform transform;
+        transform.SetPos(vec3((f32)(i % 1000), 0, (f32)(i / 1000)));
+        source->CreateActor<Actor>()->GetRootSceneComponent()->SetLocalTransform(transform);
+    }
+    source->GetTransformHierarchy()->Update();
+
+    u64 start = SDL_GetPerformanceCounter();
+    bool isSaved = source->SaveToFile(BENCHMARK_WORLD_FILE);
+    const f64 binarySaveMs = ElapsedMs(start);
+
+    GameWorld* loaded = StartWorld(memory + worldSize, (u32)worldSize);
+    start = SDL_GetPerformanceCounter();
+    const bool isLoaded = isSaved && loaded->LoadFromFile(BENCHMARK_WORLD_FILE);
+    const f64 binaryLoadMs = ElapsedMs(start);
+    Assert(isLoaded && SumPositions(loaded) == SumPositions(source));
+    StopWorld(loaded);
+
+    start = SDL_GetPerformanceCounter();
+    {
+        nlohmann::json json = nlohmann::json::array();
+        for (const Actor* actor : source->GetAllActors())
+        {
+            nlohmann::json a;
+            SerializeActor(actor, a);
+            json.push_back(std::move(a));
+        }
+        std::ofstream o(BENCHMARK_JSON_FILE);
+        o << json;
+        isSaved &= (bool)o;
+    }
+    const f64 jsonSaveMs = ElapsedMs(start);
+
+    start = SDL_GetPerformanceCounter();
+    f64 jsonParseMs;
+    {
+        std::ifstream in(BENCHMARK_JSON_FILE);
+        const nlohmann::json json = nlohmann::json::parse(in);
+        Assert(json.size() == FILE_ACTORS);
+        jsonParseMs = ElapsedMs(start);
+    }
+
+    // Only one actor at a time is in memory, the high water mark shows how much
+    start = SDL_GetPerformanceCounter();
+    JsonReader reader;
+    u32 streamedCount = 0;
+    if (reader.Open(BENCHMARK_JSON_FILE) && reader.BeginArray())
+    {
+        while (reader.ReadElement()) streamedCount++;
+    }
+    const f64 jsonStreamMs = ElapsedMs(start);
+    Assert(!reader.HasError() && streamedCount == FILE_ACTORS);
+
+    loaded = StartWorld(memory + worldSize, (u32)worldSize);
+    start = SDL_GetPerformanceCounter();
+    const bool isJsonLoaded = loaded->LoadFromJson(BENCHMARK_JSON_FILE);
+    const f64 jsonLoadMs = ElapsedMs(start);
+    Assert(isJsonLoaded && SumPositions(loaded) == SumPositions(source));
+    StopWorld(loaded);
+
+    if (isSaved)
+    {
+        SDL_Log(
+            "World file benchmark, %u components: binary save %8.3fms load %8.3fms (%.1fMB), "
+            "JSON save %8.3fms parse %8.3fms (%.1fMB)",
+            FILE_ACTORS, binarySaveMs, binaryLoadMs, GetFileSizeMB(BENCHMARK_WORLD_FILE),
+            jsonSaveMs, jsonParseMs, GetFileSizeMB(BENCHMARK_JSON_FILE));
+        SDL_Log("JSON streaming: parse %8.3fms (%u bytes per actor at most), load %8.3fms",
+                jsonStreamMs, reader.GetHighWaterMark(), jsonLoadMs);
+    }
+    std::remove(BENCHMARK_WORLD_FILE);
+    std::remove(BENCHMARK_JSON_FILE);
+
+    StopWorld(source);
+    ReleaseVirtualMemory(memory, 2 * worldSize);
+}
+
+static AABB RandomBox(std::mt19937& random, f32 maxSize)
+{
+    std::uniform_real_distribution<f32> position(0.f, SPATIAL_EXTENT);
+    std::uniform_real_distribution<f32> size(0.1f * maxSize, maxSize);
+    const vec3 min(position(random), position(random) * 0.1f, position(random));
+    return {min, min + vec3(size(random), size(random), size(random))};
+}
+
+static void LogQueries(const char* name, u32 count, f64 ms, u64 hits)
+{
+    SDL_Log("  %-8s %6u queries %8.3fms, %10.0f queries/s, %8.1f hits per query", name, count,
+            ms, ms > 0.0 ? count * 1000.0 / ms : 0.0, (f64)hits / count);
+}
+
+void RunSpatialTreeBenchmark()
+{
+    std::mt19937 random(SPATIAL_OBJECTS);
+    std::vector<AABB> boxes(SPATIAL_OBJECTS);
+    for (AABB& box : boxes) box = RandomBox(random, 4.f);
+
+    AABBTree tree;
+    u64 start = SDL_GetPerformanceCounter();
+    std::vector<u32> proxies(SPATIAL_OBJECTS);
+    for (u32 i = 0; i < SPATIAL_OBJECTS; ++i) proxies[i] = tree.CreateProxy(boxes[i], i);
+    tree.Update();
+    const f64 buildMs = ElapsedMs(start);
+    SDL_Log("Spatial tree benchmark, %u objects: build %8.3fms, height %u", SPATIAL_OBJECTS,
+            buildMs, tree.GetHeight());
+
+    // 1% of the objects drift per frame, most stay inside their fat box
+    const u32 movesPerFrame = SPATIAL_OBJECTS / 100;
+    start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (u32 i = 0; i < movesPerFrame; ++i)
+        {
+            const u32 index = random() % SPATIAL_OBJECTS;
+            const vec3 offset((f32)(random() % 5) * 0.05f, 0.f, (f32)(random() % 5) * 0.05f);
+            boxes[index].Min += offset;
+            boxes[index].Max += offset;
+            tree.MoveProxy(proxies[index], boxes[index]);
+        }
+        tree.Update();
+    }
+    const f64 driftMs = ElapsedMs(start) / ITERATIONS;
+
+    // Teleports leave the fat box and get reinserted
+    const u32 teleportsPerFrame = SPATIAL_OBJECTS / 1000;
+    start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        for (u32 i = 0; i < teleportsPerFrame; ++i)
+        {
+            const u32 index = random() % SPATIAL_OBJECTS;
+            boxes[index] = RandomBox(random, 4.f);
+            tree.MoveProxy(proxies[index], boxes[index]);
+        }
+        tree.Update();
+    }
+    const f64 teleportMs = ElapsedMs(start) / ITERATIONS;
+    SDL_Log("  %u drifting per frame %8.3fms, %u teleporting per frame %8.3fms, height %u",
+            movesPerFrame, driftMs, teleportsPerFrame, teleportMs, tree.GetHeight());
+
+    std::vector<AABB> queries(SPATIAL_QUERIES);
+    for (AABB& query : queries) query = RandomBox(random, 40.f);
+
+    u64 hits = 0;
+    start = SDL_GetPerformanceCounter();
+    for (const AABB& query : queries) tree.QueryAABB(query, [&hits](u32, u64) { hits++; });
+    LogQueries("AABB", SPATIAL_QUERIES, ElapsedMs(start), hits);
+
+    // The same for a hundred queries against every box, to check the results and for scale
+    const u32 bruteForceQueries = 100;
+    u64 bruteForceHits = 0;
+    u64 treeHits = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < bruteForceQueries; ++i)
+    {
+        for (const AABB& box : boxes) bruteForceHits += OverlapsAABB(box, queries[i]);
+    }
+    const f64 bruteForceMs = ElapsedMs(start);
+    for (u32 i = 0; i < bruteForceQueries; ++i)
+        tree.QueryAABB(queries[i], [&treeHits](u32, u64) { treeHits++; });
+    Assert(treeHits == bruteForceHits);
+    LogQueries("Linear", bruteForceQueries, bruteForceMs, bruteForceHits);
+
+    hits = 0;
+    start = SDL_GetPerformanceCounter();
+    for (const AABB& query : queries)
+    {
+        tree.QuerySphere((query.Min + query.Max) * 0.5f, 20.f, [&hits](u32, u64) { hits++; });
+    }
+    LogQueries("Sphere", SPATIAL_QUERIES, ElapsedMs(start), hits);
+
+    // Cameras above the slab looking along it, 200 units far
+    const u32 frustumQueries = SPATIAL_QUERIES / 100;
+    const mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 200.f);
+    hits = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < frustumQueries; ++i)
+    {
+        const vec3 eye = (queries[i].Min + queries[i].Max) * 0.5f + vec3(0, 20, 0);
+        const f32 angle = (f32)i;
+        const mat4 view = glm::lookAt(eye, eye + vec3(glm::sin(angle), -0.2f, glm::cos(angle)),
+                                      vec3(0, 1, 0));
+        tree.QueryFrustum(ExtractFrustum(projection * view), [&hits](u32, u64) { hits++; });
+    }
+    LogQueries("Frustum", frustumQueries, ElapsedMs(start), hits);
+
+    // Closest hit, every hit shortens the ray
+    hits = 0;
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < SPATIAL_QUERIES; ++i)
+    {
+        const vec3 origin = (queries[i].Min + queries[i].Max) * 0.5f;
+        const f32 angle = (f32)i;
+        const vec3 direction = glm::normalize(vec3(glm::sin(angle), -0.1f, glm::cos(angle)));
+        f32 closest = -1.f;
+        tree.RayCast(origin, direction, 500.f, [&closest](u32, u64, f32 distance) {
+            closest = distance;
+            return distance;
+        });
+        hits += closest >= 0.f;
+    }
+    LogQueries("Ray", SPATIAL_QUERIES, ElapsedMs(start), hits);
+}
+}  // namespace DG
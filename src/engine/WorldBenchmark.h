@@ -0,0 +1,34 @@
+/**
+ *  @file    WorldBenchmark.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+
+namespace DG
+{
+// Sums the transforms of 10k, 100k and 1M actors once through GameWorld::Each and once by
+// walking every actor with GetComponentsOfType, and logs the results. Needs physics to be up.
+void RunWorldIterationBenchmark();
+
+// Node trees 8 deep with 1% of the local transforms changing per frame. Compares walking the
+// parent chain for every node against TransformHierarchy::Update, and logs the results.
+void RunTransformHierarchyBenchmark();
+
+// Jobs record 100k actor spawns into their command buffers, then the world plays them back and
+// the same for destroying them again. Logs recording and playback times.
+void RunCommandBufferBenchmark();
+
+// Copies a world of 100k actors once with GameWorld::CloneInto and once by creating every actor
+// again and copying its transform over, what entering play mode would do otherwise. Logs both.
+void RunWorldCloneBenchmark();
+
+// Saves and loads a world of 1M scene components once as a binary world file and once through
+// SerializeActor and nlohmann::json. There is no JSON loader, its load time is only the parse.
+void RunWorldFileBenchmark();
+
+// Builds an AABBTree over 1M boxes, moves some of them per frame and logs the update times and
+// the throughput of box, sphere, frustum and ray queries, with a linear scan for scale.
+void RunSpatialTreeBenchmark();
+}  // namespace DG
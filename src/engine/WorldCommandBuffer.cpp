@@ -0,0 +1,123 @@
+/**
+ *  @file    WorldCommandBuffer.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "WorldCommandBuffer.h"
+#include <atomic>
+#include <cstdlib>
+#include "memory/MemoryTracker.h"
+
+namespace DG
+{
+static std::atomic<u32> NextThreadIndex{0};
+thread_local u32 LocalThreadIndex = WorldCommandBuffer::MaxThreads;
+
+#if DG_MEMORY_TRACKING
+static MemoryTag GetCommandBufferTag()
+{
+    static const MemoryTag tag = RegisterMemoryTag("WorldCommandBuffers");
+    return tag;
+}
+#endif
+
+WorldCommandBuffer::~WorldCommandBuffer()
+{
+    Clear();
+    Block* block = _first;
+    while (block)
+    {
+        Block* next = block->Next;
+        DG_TRACK_FREE(GetCommandBufferTag(), BlockSize);
+        SDL_free(block);
+        block = next;
+    }
+}
+
+u32 WorldCommandBuffer::GetThreadIndex()
+{
+    if (LocalThreadIndex == MaxThreads)
+    {
+        u32 index = NextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= MaxThreads)
+        {
+            // Release builds drop the Assert, indexing past the buffers would corrupt the world
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION,
+                            "WorldCommandBuffer: thread %u exceeds the %u buffer limit", index,
+                            (u32)MaxThreads);
+            Assert(false);
+            std::abort();
+        }
+        LocalThreadIndex = index;
+    }
+    return LocalThreadIndex;
+}
+
+void WorldCommandBuffer::DestroyActor(Handle<Actor> actor)
+{
+    Record(CommandType::DestroyActor, actor.ToU64(), false, 0);
+}
+
+void WorldCommandBuffer::RemoveComponent(ComponentHandle component)
+{
+    Record(CommandType::RemoveComponent, component.ToU64(), false, 0);
+}
+
+WorldCommandBuffer::Command* WorldCommandBuffer::Record(CommandType type, u64 target,
+                                                        bool isPending, u32 payloadSize)
+{
+    // Every command starts 16 byte aligned, payloads go right behind it
+    const u32 size = (sizeof(Command) + payloadSize + alignof(Command) - 1) &
+                     ~(u32)(alignof(Command) - 1);
+    Assert(sizeof(Block) + size <= BlockSize);
+
+    if (!_current || _current->Used + size > BlockSize)
+    {
+        Block* next = _current ? _current->Next : _first;
+        if (!next)
+        {
+            next = (Block*)SDL_malloc(BlockSize);
+            DG_TRACK_ALLOCATION(GetCommandBufferTag(), BlockSize);
+            next->Next = nullptr;
+            if (_current)
+                _current->Next = next;
+            else
+                _first = next;
+        }
+        next->Used = sizeof(Block);
+        _current = next;
+    }
+
+    Command* command = (Command*)((u8*)_current + _current->Used);
+    _current->Used += size;
+    command->Type = type;
+    command->IsPending = isPending;
+    command->Size = size;
+    command->Target = target;
+    command->Spawn = nullptr;
+    command->DestroyPayload = nullptr;
+    command->Info = nullptr;
+
+    _commandCount++;
+    if (type == CommandType::SpawnActor)
+        _spawnCount++;
+    else if (type == CommandType::AddComponent)
+        _componentCount++;
+    return command;
+}
+
+void WorldCommandBuffer::Clear()
+{
+    ForEachCommand([](const Command& command, void* payload) {
+        if (command.DestroyPayload)
+            command.DestroyPayload(payload);
+    });
+    if (_first)
+        _first->Used = sizeof(Block);
+    _current = _first;
+    _commandCount = 0;
+    _spawnCount = 0;
+    _componentCount = 0;
+}
+}  // namespace DG
@@ -0,0 +1,163 @@
+/**
+ *  @file    WorldCommandBuffer.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "components/BaseComponent.h"
+#include "engine/Handle.h"
+#include "engine/Types.h"
+
+namespace DG
+{
+class Actor;
+class GameWorld;
+struct ComponentTypeInfo;
+
+// Actors spawned through a command buffer have no handle before playback, later commands of the
+// same buffer refer to them with this
+struct PendingActor
+{
+    u32 Index;
+};
+
+// Records spawns, destroys and component adds/removes so jobs can ask for them while the world is
+// iterated. GameWorld::GetCommandBuffer hands every thread its own buffer and GameWorld plays all
+// of them back at once: spawns with their components first, then the rest in recording order.
+// Arguments are stored by value until then, commands on actors or components that are gone by
+// playback are dropped.
+class WorldCommandBuffer
+{
+    friend class GameWorld;
+
+   public:
+    enum
+    {
+        MaxThreads = 64,
+        BlockSize = 64 * 1024
+    };
+
+    WorldCommandBuffer() = default;
+    ~WorldCommandBuffer();
+    WorldCommandBuffer(const WorldCommandBuffer&) = delete;
+    WorldCommandBuffer& operator=(const WorldCommandBuffer&) = delete;
+
+    // These are defined in GameWorld.h, playing them back needs the world and the actor
+    template <typename T, typename... Args>
+    PendingActor SpawnActor(Args&&... args);
+    template <typename T, typename... Args>
+    void AddComponent(Handle<Actor> actor, Args&&... args);
+    template <typename T, typename... Args>
+    void AddComponent(PendingActor actor, Args&&... args);
+
+    void DestroyActor(Handle<Actor> actor);
+    void RemoveComponent(ComponentHandle component);
+
+    u32 GetCommandCount() const { return _commandCount; }
+
+    // Stable for the lifetime of the thread, the first call claims the next index. Aborts once
+    // more than MaxThreads threads have claimed one.
+    static u32 GetThreadIndex();
+
+   private:
+    enum class CommandType : u8
+    {
+        SpawnActor,
+        DestroyActor,
+        AddComponent,
+        RemoveComponent
+    };
+
+    typedef Actor* (*SpawnFunction)(GameWorld* world, void* payload);
+    typedef void (*AddFunction)(Actor* actor, void* payload);
+    typedef void (*DestroyFunction)(void* payload);
+
+    // The payload follows the command, Size covers both
+    struct alignas(16) Command
+    {
+        CommandType Type;
+        bool IsPending;  // Target is a PendingActor index instead of a handle
+        u32 Size;
+        u64 Target;
+        union
+        {
+            SpawnFunction Spawn;
+            AddFunction Add;
+        };
+        DestroyFunction DestroyPayload;  // Null for trivially destructible payloads
+        const ComponentTypeInfo* Info;   // Of the component, AddComponent only
+    };
+
+    struct alignas(16) Block
+    {
+        Block* Next;
+        u32 Used;  // Including this header
+    };
+
+    Command* Record(CommandType type, u64 target, bool isPending, u32 payloadSize);
+
+    // Payloads are tuples of the decayed arguments
+    template <class Payload, class... Args>
+    Command* RecordWithPayload(CommandType type, u64 target, bool isPending, Args&&... args);
+
+    template <class T, class Payload>
+    static Actor* SpawnActorCommand(GameWorld* world, void* payload);
+    template <class T, class Payload>
+    static void AddComponentCommand(Actor* actor, void* payload);
+    template <class Payload>
+    static void DestroyPayloadCommand(void* payload);
+
+    // Calls function(const Command&, void* payload) in recording order
+    template <class Function>
+    void ForEachCommand(const Function& function) const;
+    // Destroys the payloads, the blocks are kept for the next frame
+    void Clear();
+
+    Block* _first = nullptr;
+    Block* _current = nullptr;
+    u32 _commandCount = 0;
+    u32 _spawnCount = 0;
+    u32 _componentCount = 0;
+};
+
+template <class Payload, class... Args>
+WorldCommandBuffer::Command* WorldCommandBuffer::RecordWithPayload(CommandType type, u64 target,
+                                                                   bool isPending, Args&&... args)
+{
+    static_assert(alignof(Payload) <= alignof(Command), "Payload alignment not supported");
+    Command* command = Record(type, target, isPending, (u32)sizeof(Payload));
+    new (command + 1) Payload(std::forward<Args>(args)...);
+    command->DestroyPayload = std::is_trivially_destructible<Payload>::value
+                                  ? nullptr
+                                  : &DestroyPayloadCommand<Payload>;
+    return command;
+}
+
+template <class Payload>
+void WorldCommandBuffer::DestroyPayloadCommand(void* payload)
+{
+    ((Payload*)payload)->~Payload();
+}
+
+template <class Function>
+void WorldCommandBuffer::ForEachCommand(const Function& function) const
+{
+    for (const Block* block = _first; block; block = block->Next)
+    {
+        u32 offset = sizeof(Block);
+        while (offset < block->Used)
+        {
+            Command* command = (Command*)((u8*)block + offset);
+            function(*command, (void*)(command + 1));
+            offset += command->Size;
+        }
+        if (block == _current)
+            break;
+    }
+}
+}  // namespace DG
@@ -8,6 +8,7 @@
 #include <ImGuizmo.h>
 #include <imgui.h>
 #include "Messaging.h"
+#include "components/SceneComponent.h"
 #include "imgui/imgui_dock.h"
 #include "imgui/DG_Imgui.h"
 #include <imgui_internal.h>
@@ -72,22 +73,20 @@ void WorldEdit::Update()
 {
     static int SelectedIndex = -1;
 
-    //if (_lastInputMessage.MouseLeftPressed && !_lastInputMessageHandled && !ImGuizmo::IsOver())
-    //{
-    //    /* vec3 ray = GetMouseRayGameClient(_lastInputMessage, _gameWorld.GetPlayerCamera());
-
-    //     void* actor =
-    //         _gameWorld.PhysicsWorld.RayCast(_gameWorld.GetPlayerCamera().GetPosition(), ray);
-    //     for (u32 i = 0; i < _gameWorld.GetGameObjectCount(); ++i)
-    //     {
-    //         auto& gameObject = _gameWorld.GetGameObject(i);
-    //         if (gameObject.Physics->Data == actor)
-    //         {
-    //             SelectedIndex = i;
-    //             break;
-    //         }
-    //     }*/
-    //}
+    const GameWorld::Input& input = _gameWorld.GetLastInput();
+    if (input.MouseLeftPressed && !ImGuizmo::IsOver())
+    {
+        // Each hit shortens the ray, the last one reported is the closest box
+        Camera* camera = _gameWorld.GetActiveCamera();
+        Handle<SceneComponent> picked;
+        _gameWorld.RayCast(camera->GetPosition(), _gameWorld.GetMouseRay(), camera->GetFar(),
+                           [&picked](Handle<SceneComponent> handle, f32 distance) {
+                               picked = handle;
+                               return distance;
+                           });
+        const SceneComponent* component = _gameWorld.Resolve(picked);
+        _selectedActor = component ? component->GetOwningActor() : nullptr;
+    }
     _lastInputMessageHandled = true;
     bool hasSelection = false;
 
@@ -0,0 +1,398 @@
+/**
+ *  @file    WorldFile.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "WorldFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <unordered_map>
+#include "engine/Reflection.h"
+#include "engine/Serialize.h"
+#include "json.hpp"
+#include "memory/VirtualMemory.h"
+
+namespace DG
+{
+u64 WorldFileWriter::Allocate(u64 size, u32 alignment)
+{
+    const u64 offset = (_data.size() + alignment - 1) & ~(u64)(alignment - 1);
+    _data.resize(offset + size);
+    return offset;
+}
+
+u64 WorldFileWriter::WriteString(const char* text)
+{
+    const u64 length = SDL_strlen(text) + 1;
+    const u64 offset = Allocate(length, 1);
+    SDL_memcpy(_data.data() + offset, text, length);
+    return offset;
+}
+
+bool WorldFileWriter::WriteToFile(const char* path) const
+{
+    std::ofstream o(path, std::ios::binary);
+    if (!o.write((const char*)_data.data(), (std::streamsize)_data.size()))
+    {
+        SDL_LogError(0, "Couldn't write world file %s", path);
+        return false;
+    }
+    return true;
+}
+
+template <class T>
+static bool FixupPointer(WorldFilePointer<T>& pointer, u8* file, u64 size, u64 count)
+{
+    if (pointer.Offset > size || pointer.Offset % alignof(T) != 0 ||
+        count > (size - pointer.Offset) / sizeof(T))
+        return false;
+    pointer.Pointer = (T*)(file + pointer.Offset);
+    return true;
+}
+
+static bool FixupString(WorldFilePointer<const char>& pointer, u8* file, u64 size)
+{
+    if (pointer.Offset >= size || !std::memchr(file + pointer.Offset, 0, size - pointer.Offset))
+        return false;
+    pointer.Pointer = (const char*)(file + pointer.Offset);
+    return true;
+}
+
+const WorldFileHeader* FixupWorldFile(u8* file, u64 size)
+{
+    WorldFileHeader* header = (WorldFileHeader*)file;
+    if (size < sizeof(WorldFileHeader) || header->Magic != WorldFileMagic ||
+        header->Version != WorldFileVersion || header->FileSize != size ||
+        header->HandleSlotCount == 0)
+        return nullptr;
+
+    if (!FixupPointer(header->Types, file, size, header->TypeCount) ||
+        !FixupPointer(header->Archetypes, file, size, header->ArchetypeCount) ||
+        !FixupPointer(header->Actors, file, size, header->ActorCount) ||
+        !FixupPointer(header->ComponentHandles, file, size, header->ComponentHandleCount) ||
+        !FixupPointer(header->HandleGenerations, file, size, header->HandleSlotCount) ||
+        !FixupPointer(header->Strings, file, size, header->StringCount))
+        return nullptr;
+
+    for (u32 i = 0; i < header->TypeCount; ++i)
+    {
+        if (!FixupString(header->Types.Pointer[i].Name, file, size))
+            return nullptr;
+    }
+
+    for (u32 i = 0; i < header->StringCount; ++i)
+    {
+        WorldFileString& string = header->Strings.Pointer[i];
+        if (string.Length == 0)
+        {
+            string.Text.Pointer = nullptr;
+            continue;
+        }
+        if (!FixupPointer(string.Text, file, size, (u64)string.Length + 1) ||
+            string.Text.Pointer[string.Length] != 0)
+            return nullptr;
+    }
+
+    // Names are unique, otherwise two columns of an archetype could load into the same type
+    for (u32 i = 0; i < header->TypeCount; ++i)
+    {
+        for (u32 j = 0; j < i; ++j)
+        {
+            if (SDL_strcmp(header->Types.Pointer[i].Name.Pointer,
+                           header->Types.Pointer[j].Name.Pointer) == 0)
+                return nullptr;
+        }
+    }
+
+    // Indices and handles are checked once here, loading trusts them. Every handle slot belongs
+    // to one object at most and the handle has the generation the file stores for its slot.
+    std::vector<bool> isSlotTaken(header->HandleSlotCount, false);
+    auto takeSlot = [&](u32 index, u32 generation) {
+        if (index == 0 || index >= header->HandleSlotCount || isSlotTaken[index] ||
+            header->HandleGenerations.Pointer[index] != generation)
+            return false;
+        isSlotTaken[index] = true;
+        return true;
+    };
+
+    for (u32 i = 0; i < header->ActorCount; ++i)
+    {
+        const WorldFileActor& actor = header->Actors.Pointer[i];
+        if (actor.Type >= header->TypeCount ||
+            actor.FirstComponent > header->ComponentHandleCount ||
+            actor.ComponentCount > header->ComponentHandleCount - actor.FirstComponent ||
+            actor.ComponentCount > Archetype::MaxComponentTypes ||
+            !takeSlot(actor.ActorHandle.Index, actor.ActorHandle.Generation))
+            return nullptr;
+
+        // The root is one of the actors own components, GameWorld checks its type
+        const ComponentHandle* components = header->ComponentHandles.Pointer + actor.FirstComponent;
+        const ComponentHandle root(actor.RootComponent.Index, actor.RootComponent.Generation);
+        if (root && std::find(components, components + actor.ComponentCount, root) ==
+                        components + actor.ComponentCount)
+            return nullptr;
+    }
+
+    // Every actor with components owns exactly one row, the row holds the same handles as the
+    // component list of its actor
+    std::vector<bool> hasRow(header->ActorCount, false);
+    for (u32 i = 0; i < header->ArchetypeCount; ++i)
+    {
+        WorldFileArchetype& archetype = header->Archetypes.Pointer[i];
+        if (archetype.TypeCount == 0 || archetype.TypeCount > Archetype::MaxComponentTypes ||
+            !FixupPointer(archetype.Actors, file, size, archetype.RowCount))
+            return nullptr;
+
+        for (u32 t = 0; t < archetype.TypeCount; ++t)
+        {
+            if (archetype.Types[t] >= header->TypeCount ||
+                std::find(archetype.Types, archetype.Types + t, archetype.Types[t]) !=
+                    archetype.Types + t)
+                return nullptr;
+
+            // Rows are read as components below, the handle has to lie inside and be aligned
+            const u32 typeSize = header->Types.Pointer[archetype.Types[t]].Size;
+            if (typeSize < sizeof(BaseComponent) || typeSize % alignof(BaseComponent) != 0 ||
+                archetype.Columns[t].Offset % alignof(BaseComponent) != 0 ||
+                !FixupPointer(archetype.Columns[t], file, size, (u64)archetype.RowCount * typeSize))
+                return nullptr;
+        }
+
+        for (u32 row = 0; row < archetype.RowCount; ++row)
+        {
+            const u32 actorIndex = archetype.Actors.Pointer[row];
+            if (actorIndex >= header->ActorCount || hasRow[actorIndex])
+                return nullptr;
+            hasRow[actorIndex] = true;
+
+            const WorldFileActor& actor = header->Actors.Pointer[actorIndex];
+            const ComponentHandle* components =
+                header->ComponentHandles.Pointer + actor.FirstComponent;
+            if (actor.ComponentCount != archetype.TypeCount)
+                return nullptr;
+            for (u32 t = 0; t < archetype.TypeCount; ++t)
+            {
+                const u32 typeSize = header->Types.Pointer[archetype.Types[t]].Size;
+                const ComponentHandle handle =
+                    ((const BaseComponent*)(archetype.Columns[t].Pointer + (u64)row * typeSize))
+                        ->GetHandle();
+                if (!takeSlot(handle.Index, handle.Generation) ||
+                    std::find(components, components + actor.ComponentCount, handle) ==
+                        components + actor.ComponentCount)
+                    return nullptr;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < header->ActorCount; ++i)
+    {
+        if (!hasRow[i] && header->Actors.Pointer[i].ComponentCount != 0)
+            return nullptr;
+    }
+    return header;
+}
+
+static u32 HashBytes(u32 hash, const void* data, u64 size)
+{
+    // FNV-1a
+    for (u64 i = 0; i < size; ++i) hash = (hash ^ ((const u8*)data)[i]) * 16777619u;
+    return hash;
+}
+
+u32 GetWorldFileLayoutHash(const ComponentTypeInfo* info)
+{
+    u32 hash = HashBytes(2166136261u, &info->Size, sizeof(info->Size));
+    ForEachReflectedField(info->Type, [&](const FieldReflection& field) {
+        hash = HashBytes(hash, field.Name, SDL_strlen(field.Name));
+        hash = HashBytes(hash, &field.Offset, sizeof(field.Offset));
+        hash = HashBytes(hash, &field.Size, sizeof(field.Size));
+        hash = HashBytes(hash, &field.Type, sizeof(field.Type));
+    });
+    return hash;
+}
+
+void CollectStringIds(const ComponentTypeInfo* info, const u8* rows, u32 count,
+                      std::vector<u32>* hashes)
+{
+    ForEachReflectedField(info->Type, [&](const FieldReflection& field) {
+        if (field.Type != FieldType::StringId)
+            return;
+
+        const u8* value = rows + field.Offset;
+        for (u32 row = 0; row < count; ++row, value += info->Size)
+        {
+            u32 hash;
+            SDL_memcpy(&hash, value, sizeof(hash));
+            // Most rows repeat the one before, the caller sorts the rest out
+            if (hashes->empty() || hashes->back() != hash)
+                hashes->push_back(hash);
+        }
+    });
+}
+
+const char* FindStringIdText(u32 hash)
+{
+#if _DEBUG
+    const char* text = g_StringHashTable.Get(hash);
+    return text && StringId::HashString(text) == hash ? text : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+void AddStringIdText(u32 hash, const char* text)
+{
+#if _DEBUG
+    // A taken slot stays with its string, FindStringIdText sees that it doesn't match
+    if (!g_StringHashTable.Get(hash))
+        g_StringHashTable.Put(hash, text);
+#endif
+}
+
+static nlohmann::json ExportComponent(const ComponentTypeInfo* info, const u8* component,
+                                      const std::unordered_map<u32, const char*>& texts)
+{
+    nlohmann::json json = nlohmann::json::object();
+    if (!info)
+    {
+        // The reflection of this build doesn't describe the bytes
+        json["layoutMismatch"] = true;
+        return json;
+    }
+
+    ForEachReflectedField(info->Type, [&](const FieldReflection& field) {
+        const u8* value = component + field.Offset;
+        switch (field.Type)
+        {
+            case FieldType::Bool: json[field.Name] = *(const bool*)value; break;
+            case FieldType::S32: json[field.Name] = *(const s32*)value; break;
+            case FieldType::U32: json[field.Name] = *(const u32*)value; break;
+            case FieldType::F32: json[field.Name] = *(const f32*)value; break;
+            case FieldType::Vec3: json[field.Name] = Serialize(*(const vec3*)value); break;
+            case FieldType::Quat:
+            {
+                const quat& q = *(const quat*)value;
+                json[field.Name] = {q.x, q.y, q.z, q.w};
+                break;
+            }
+            case FieldType::Transform:
+                json[field.Name] = Serialize(*(const Transform*)value);
+                break;
+            case FieldType::StringId:
+            {
+                const u32 hash = *(const u32*)value;
+                const auto it = texts.find(hash);
+                json[field.Name] = it != texts.end() ? nlohmann::json(it->second)
+                                                     : nlohmann::json(hash);
+                break;
+            }
+            case FieldType::Handle:
+                json[field.Name] = Serialize(*(const Handle<TypeBase>*)value);
+                break;
+            case FieldType::Unknown: break;
+        }
+    });
+    return json;
+}
+
+bool ExportWorldFileToJson(const char* path, const char* jsonPath)
+{
+    u64 size = 0;
+    u8* file = MapFile(path, &size);
+    if (!file)
+    {
+        SDL_LogError(0, "Couldn't map world file %s", path);
+        return false;
+    }
+    const WorldFileHeader* header = FixupWorldFile(file, size);
+    if (!header)
+    {
+        SDL_LogError(0, "%s is damaged or no world file of version %u", path,
+                     (u32)WorldFileVersion);
+        UnmapFile(file, size);
+        return false;
+    }
+
+    nlohmann::json strings = nlohmann::json::array();
+    std::unordered_map<u32, const char*> texts;
+    for (u32 i = 0; i < header->StringCount; ++i)
+    {
+        const WorldFileString& string = header->Strings.Pointer[i];
+        if (string.Text.Pointer)
+            texts[string.Hash] = string.Text.Pointer;
+        strings.push_back({{"hash", string.Hash},
+                           {"text", string.Text.Pointer ? nlohmann::json(string.Text.Pointer)
+                                                        : nlohmann::json()}});
+    }
+
+    std::vector<const ComponentTypeInfo*> infos(header->TypeCount);
+    for (u32 i = 0; i < header->TypeCount; ++i)
+    {
+        const WorldFileType& type = header->Types.Pointer[i];
+        const ComponentTypeInfo* info = FindComponentType(type.Name.Pointer);
+        infos[i] = info && GetWorldFileLayoutHash(info) == type.LayoutHash ? info : nullptr;
+    }
+
+    // Rows end up in any order, export by handle so unchanged actors diff clean
+    std::vector<std::pair<const WorldFileArchetype*, u32>> rows(header->ActorCount);
+    for (u32 i = 0; i < header->ArchetypeCount; ++i)
+    {
+        const WorldFileArchetype& archetype = header->Archetypes.Pointer[i];
+        for (u32 row = 0; row < archetype.RowCount; ++row)
+            rows[archetype.Actors.Pointer[row]] = {&archetype, row};
+    }
+    std::vector<u32> order(header->ActorCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [header](u32 a, u32 b) {
+        return header->Actors.Pointer[a].ActorHandle.Index <
+               header->Actors.Pointer[b].ActorHandle.Index;
+    });
+
+    nlohmann::json actors = nlohmann::json::array();
+    for (u32 index : order)
+    {
+        const WorldFileActor& actor = header->Actors.Pointer[index];
+        nlohmann::json a;
+        a["type"] = header->Types.Pointer[actor.Type].Name.Pointer;
+        a["handle"] = Serialize(actor.ActorHandle);
+        a["RootComponent"] = Serialize(actor.RootComponent);
+        nlohmann::json componentHandles = nlohmann::json::array();
+        for (u32 i = 0; i < actor.ComponentCount; ++i)
+            componentHandles.push_back(
+                Serialize(header->ComponentHandles.Pointer[actor.FirstComponent + i]));
+        a["componentHandles"] = componentHandles;
+
+        nlohmann::json components = nlohmann::json::object();
+        const WorldFileArchetype* archetype = rows[index].first;
+        for (u32 t = 0; archetype && t < archetype->TypeCount; ++t)
+        {
+            const WorldFileType& type = header->Types.Pointer[archetype->Types[t]];
+            const u8* component =
+                archetype->Columns[t].Pointer + (u64)rows[index].second * type.Size;
+            components[type.Name.Pointer] =
+                ExportComponent(infos[archetype->Types[t]], component, texts);
+        }
+        a["components"] = components;
+        actors.push_back(a);
+    }
+
+    nlohmann::json json;
+    json["version"] = header->Version;
+    json["strings"] = strings;
+    json["actors"] = actors;
+    UnmapFile(file, size);
+
+    std::ofstream o(jsonPath);
+    if (!o)
+    {
+        SDL_LogError(0, "Couldn't write %s", jsonPath);
+        return false;
+    }
+    o << std::setw(4) << json << std::endl;
+    return true;
+}
+}  // namespace DG
@@ -0,0 +1,129 @@
+/**
+ *  @file    WorldFile.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <vector>
+#include "components/ComponentStorage.h"
+#include "engine/Handle.h"
+#include "engine/Types.h"
+
+namespace DG
+{
+class SceneComponent;
+
+// Binary level format, written by GameWorld::SaveToFile. Every part refers to the others by file
+// offset, so the file is mapped as is and FixupWorldFile turns the offsets into pointers.
+// Components are stored per archetype as one packed column per type, raw bytes like in memory
+// with the vtable pointer cleared and the owner swapped for the actor index. StringIds stay
+// hashes, the string table has their text where the saving build knew it.
+enum
+{
+    WorldFileMagic = 0x46574744,  // "DGWF"
+    WorldFileVersion = 1
+};
+
+// Offset from the start of the file until FixupWorldFile ran
+template <class T>
+union WorldFilePointer
+{
+    u64 Offset;
+    T* Pointer;
+};
+
+struct WorldFileType
+{
+    WorldFilePointer<const char> Name;
+    u32 Size;
+    u32 LayoutHash;  // See GetWorldFileLayoutHash, 0 for actor types
+};
+
+struct WorldFileArchetype
+{
+    u32 TypeCount;
+    u32 RowCount;
+    u32 Types[Archetype::MaxComponentTypes];  // Into the type table
+    WorldFilePointer<u32> Actors;             // Actor index per row
+    WorldFilePointer<u8> Columns[Archetype::MaxComponentTypes];
+};
+
+struct WorldFileActor
+{
+    u32 Type;
+    u32 FirstComponent;  // Into the component handle table
+    u32 ComponentCount;
+    u32 Padding;
+    Handle<Actor> ActorHandle;
+    Handle<SceneComponent> RootComponent;
+};
+
+struct WorldFileString
+{
+    u32 Hash;
+    u32 Length;  // 0 if the text was unknown, release builds keep no strings
+    WorldFilePointer<const char> Text;
+};
+
+struct WorldFileHeader
+{
+    u32 Magic;
+    u32 Version;
+    u64 FileSize;
+    u32 TypeCount;
+    u32 ArchetypeCount;
+    u32 ActorCount;
+    u32 ComponentHandleCount;
+    u32 HandleSlotCount;
+    u32 StringCount;
+    WorldFilePointer<WorldFileType> Types;
+    WorldFilePointer<WorldFileArchetype> Archetypes;
+    WorldFilePointer<WorldFileActor> Actors;
+    WorldFilePointer<ComponentHandle> ComponentHandles;
+    WorldFilePointer<u32> HandleGenerations;  // Of every slot of the handle table
+    WorldFilePointer<WorldFileString> Strings;
+};
+
+// Lays a world file out in memory. Allocating can move the buffer, Get pointers after allocating.
+class WorldFileWriter
+{
+   public:
+    // Zeroed space at the end of the file, returns its offset
+    u64 Allocate(u64 size, u32 alignment = 16);
+    // Copy of text including the terminator
+    u64 WriteString(const char* text);
+
+    template <class T>
+    T* Get(u64 offset)
+    {
+        return (T*)(_data.data() + offset);
+    }
+    u64 GetSize() const { return _data.size(); }
+
+    bool WriteToFile(const char* path) const;
+
+   private:
+    std::vector<u8> _data;
+};
+
+// Checks magic, version, that everything lies inside the file and that every handle belongs to
+// one object and turns every offset of the mapped file into a pointer. Null if the file is
+// damaged or of another version.
+const WorldFileHeader* FixupWorldFile(u8* file, u64 size);
+
+// Over the size and the reflected fields of the type, a file only loads into builds where it
+// matches. Changing a component means saving its levels again.
+u32 GetWorldFileLayoutHash(const ComponentTypeInfo* info);
+
+// Appends the hashes of every reflected StringId field of count rows
+void CollectStringIds(const ComponentTypeInfo* info, const u8* rows, u32 count,
+                      std::vector<u32>* hashes);
+// Text behind a StringId if this build keeps strings (debug builds), null otherwise
+const char* FindStringIdText(u32 hash);
+// Makes text known to FindStringIdText, does nothing in release builds
+void AddStringIdText(u32 hash, const char* text);
+
+// Writes the file as JSON for diffing, actors ordered by handle with their reflected fields
+bool ExportWorldFileToJson(const char* path, const char* jsonPath);
+}  // namespace DG
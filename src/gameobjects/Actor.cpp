@@ -11,33 +11,41 @@ namespace DG
 {
 Actor::Actor(GameWorld* gameWorld) : _gameWorld(gameWorld)
 {
-    _rootSceneComponent = RegisterComponent<SceneComponent>();
+    _rootSceneComponent =
+        StaticHandleCast<SceneComponent>(RegisterComponent<SceneComponent>()->GetHandle());
 }
 
-Actor::~Actor()
-{
-    for (auto& component : _components)
-    {
-        _gameWorld->DestroyComponent(component);
-    }
-}
+Actor::~Actor() { _gameWorld->DestroyAllComponents(this); }
 
 void Actor::DeRegisterComponent(BaseComponent* component)
 {
-    const auto it = std::find(_components.begin(), _components.end(), component);
+    const auto it = std::find(_components.begin(), _components.end(), component->GetHandle());
     Assert(it != _components.end());
     _gameWorld->DestroyComponent(component);
-    _components.erase(it);
+
+    // Order doesn't matter, there is one component per type
+    *it = _components.back();
+    _components.pop_back();
 }
 
 GameWorld* Actor::GetGameWorld() const { return _gameWorld; }
 
-SceneComponent* Actor::GetRootSceneComponent() const { return _rootSceneComponent; }
+Handle<Actor> Actor::GetHandle() const { return _handle; }
+
+SceneComponent* Actor::GetRootSceneComponent() const
+{
+    return _gameWorld->Resolve(_rootSceneComponent);
+}
+
+Handle<SceneComponent> Actor::GetRootSceneComponentHandle() const { return _rootSceneComponent; }
+
+const std::vector<ComponentHandle>& Actor::GetComponentHandles() const { return _components; }
 
 BaseComponent* Actor::GetFirstComponentOfType(TypeId type, bool orSubtype)
 {
-    for (auto& component : _components)
+    for (auto& handle : _components)
     {
+        BaseComponent* component = _gameWorld->Resolve(handle);
         if (orSubtype)
         {
             if (component->IsType(type))
@@ -55,8 +63,9 @@ BaseComponent* Actor::GetFirstComponentOfType(TypeId type, bool orSubtype)
 std::vector<BaseComponent*> Actor::GetComponentsOfType(TypeId type, bool orSubtype)
 {
     std::vector<BaseComponent*> result;
-    for (auto& component : _components)
+    for (auto& handle : _components)
     {
+        BaseComponent* component = _gameWorld->Resolve(handle);
         if (orSubtype)
         {
             if (component->IsType(type))
@@ -6,18 +6,24 @@
 
 #pragma once
 #include "components/BaseComponent.h"
-#include "engine/GameWorld.h"
+#include "components/ComponentStorage.h"
+#include "engine/Handle.h"
 
 namespace DG
 {
+class GameWorld;
 class SceneComponent;
 
 class Actor : public TypeBase
 {
     DECLARE_CLASS_TYPE(Actor, TypeBase)
+    friend class ComponentStorage;
+    friend class GameWorld;
 
    public:
     Actor(GameWorld* gameWorld);
+    // Without a root scene component, GameWorld fills in the rest when loading
+    Actor(GameWorld* gameWorld, RestoreTag) : _gameWorld(gameWorld) {}
     virtual ~Actor();
 
     template <typename T, typename... Args>
@@ -25,21 +31,23 @@ class Actor : public TypeBase
     void DeRegisterComponent(BaseComponent* component);
 
     GameWorld* GetGameWorld() const;
+    Handle<Actor> GetHandle() const;
     SceneComponent* GetRootSceneComponent() const;
+    Handle<SceneComponent> GetRootSceneComponentHandle() const;
+    const std::vector<ComponentHandle>& GetComponentHandles() const;
+    // Pointers are only good until the next component is created or destroyed
     BaseComponent* GetFirstComponentOfType(TypeId type, bool orSubtype = true);
     std::vector<BaseComponent*> GetComponentsOfType(TypeId type, bool orSubtype = true);
 
    private:
     GameWorld* _gameWorld;
-    SceneComponent* _rootSceneComponent;
-    std::vector<BaseComponent*> _components;
+    Handle<Actor> _handle;
+    Handle<SceneComponent> _rootSceneComponent;
+    std::vector<ComponentHandle> _components;
+    ArchetypeLocation _location;
+    u32 _worldIndex = 0;  // Position in GameWorld::_actors
 };
-
-template <typename T, typename... Args>
-T* Actor::RegisterComponent(Args&&... args)
-{
-    T* component = _gameWorld->CreateComponent<T>(this, std::forward<Args>(args)...);
-    _components.push_back(component);
-    return component;
-}
 }  // namespace DG
+
+// RegisterComponent is defined in there, it needs both classes
+#include "engine/GameWorld.h"
@@ -0,0 +1,154 @@
+/**
+ *  @file    Culling.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "Culling.h"
+#include "memory/Memory.h"
+#include "platform/BitOperations.h"
+#include "platform/Job.h"
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define DG_CULLING_SSE 1
+#else
+#define DG_CULLING_SSE 0
+#endif
+
+namespace DG::graphics
+{
+// Boxes per atomic add to the visible lists
+static const u32 CULLING_BLOCK_SIZE = 64;
+
+CullingBounds AllocateCullingBounds(FrameAllocator* memory, u32 count)
+{
+    const u32 padded = (count + 3) & ~3u;
+    f32* arrays[6];
+    for (f32*& array : arrays)
+    {
+        // Padding is zeroed, it gets tested but never reported
+        array = (f32*)memory->Push(padded * sizeof(f32), 16);
+        for (u32 i = count; i < padded; ++i) array[i] = 0.f;
+    }
+
+    CullingBounds result;
+    result.CenterX = arrays[0];
+    result.CenterY = arrays[1];
+    result.CenterZ = arrays[2];
+    result.ExtentX = arrays[3];
+    result.ExtentY = arrays[4];
+    result.ExtentZ = arrays[5];
+    result.Count = count;
+    return result;
+}
+
+void SetCullingBounds(const CullingBounds& bounds, u32 index, const AABB& aabb)
+{
+    const vec3 center = (aabb.Min + aabb.Max) * 0.5f;
+    const vec3 extent = (aabb.Max - aabb.Min) * 0.5f;
+    bounds.CenterX[index] = center.x;
+    bounds.CenterY[index] = center.y;
+    bounds.CenterZ[index] = center.z;
+    bounds.ExtentX[index] = extent.x;
+    bounds.ExtentY[index] = extent.y;
+    bounds.ExtentZ[index] = extent.z;
+}
+
+CullingView* AllocateCullingView(FrameAllocator* memory, const mat4& viewProjection, u32 count)
+{
+    CullingView* view = memory->PushAndConstruct<CullingView>();
+    view->Frustum = ExtractFrustum(viewProjection);
+    view->Visible = memory->Push<u32>(count);
+    return view;
+}
+
+// Bit i is set if box begin + i is not outside, four boxes per step
+static u64 CullBlock(const CullingBounds& bounds, const Frustum& frustum, u32 begin, u32 end)
+{
+    u64 mask = 0;
+#if DG_CULLING_SSE
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (u32 i = begin; i < end; i += 4)
+    {
+        const __m128 centerX = _mm_load_ps(bounds.CenterX + i);
+        const __m128 centerY = _mm_load_ps(bounds.CenterY + i);
+        const __m128 centerZ = _mm_load_ps(bounds.CenterZ + i);
+        const __m128 extentX = _mm_load_ps(bounds.ExtentX + i);
+        const __m128 extentY = _mm_load_ps(bounds.ExtentY + i);
+        const __m128 extentZ = _mm_load_ps(bounds.ExtentZ + i);
+
+        // Outside as soon as distance < -radius for one plane
+        __m128 outside = _mm_setzero_ps();
+        for (const vec4& plane : frustum.Planes)
+        {
+            const __m128 normalX = _mm_set1_ps(plane.x);
+            const __m128 normalY = _mm_set1_ps(plane.y);
+            const __m128 normalZ = _mm_set1_ps(plane.z);
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)),
+                           _mm_mul_ps(normalZ, centerZ)),
+                _mm_set1_ps(plane.w));
+            const __m128 radius =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(normalX, signMask), extentX),
+                                      _mm_mul_ps(_mm_and_ps(normalY, signMask), extentY)),
+                           _mm_mul_ps(_mm_and_ps(normalZ, signMask), extentZ));
+            outside = _mm_or_ps(outside,
+                                _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+        }
+        mask |= (u64)(~_mm_movemask_ps(outside) & 0xF) << (i - begin);
+    }
+#else
+    for (u32 i = begin; i < end; ++i)
+    {
+        bool isOutside = false;
+        for (const vec4& plane : frustum.Planes)
+        {
+            const f32 distance = plane.x * bounds.CenterX[i] + plane.y * bounds.CenterY[i] +
+                                 plane.z * bounds.CenterZ[i] + plane.w;
+            const f32 radius = glm::abs(plane.x) * bounds.ExtentX[i] +
+                               glm::abs(plane.y) * bounds.ExtentY[i] +
+                               glm::abs(plane.z) * bounds.ExtentZ[i];
+            isOutside |= distance < -radius;
+        }
+        mask |= (u64)!isOutside << (i - begin);
+    }
+#endif
+    return mask;
+}
+
+void CullBounds(const CullingBounds& bounds, CullingView** views, u32 viewCount)
+{
+    const u32 blockCount = (bounds.Count + CULLING_BLOCK_SIZE - 1) / CULLING_BLOCK_SIZE;
+    JobSystem::ParallelForRange(blockCount, 0, [&](u32 beginBlock, u32 endBlock) {
+        u32 visible[CULLING_BLOCK_SIZE];
+        for (u32 block = beginBlock; block < endBlock; ++block)
+        {
+            const u32 begin = block * CULLING_BLOCK_SIZE;
+            u32 end = begin + CULLING_BLOCK_SIZE;
+            if (end > bounds.Count)
+                end = bounds.Count;
+            // Padding is tested along, the mask drops it
+            const u32 paddedEnd = (end + 3) & ~3u;
+            const u64 validMask = end - begin == 64 ? ~0ull : (1ull << (end - begin)) - 1;
+
+            for (u32 v = 0; v < viewCount; ++v)
+            {
+                u64 mask = CullBlock(bounds, views[v]->Frustum, begin, paddedEnd) & validMask;
+                u32 count = 0;
+                u32 bit;
+                while (BitScanForward(mask, &bit))
+                {
+                    visible[count++] = begin + bit;
+                    mask &= mask - 1;
+                }
+                if (count == 0)
+                    continue;
+
+                const u32 offset =
+                    views[v]->VisibleCount.fetch_add(count, std::memory_order_relaxed);
+                SDL_memcpy(views[v]->Visible + offset, visible, count * sizeof(u32));
+            }
+        }
+    });
+}
+}  // namespace DG::graphics
@@ -0,0 +1,47 @@
+/**
+ *  @file    Culling.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <atomic>
+#include "engine/Types.h"
+#include "math/BoundingBox.h"
+
+namespace DG
+{
+class FrameAllocator;
+}
+
+namespace DG::graphics
+{
+// World boxes as center and extent arrays, four boxes per SIMD test. The arrays are padded to a
+// multiple of four.
+struct CullingBounds
+{
+    f32* CenterX;
+    f32* CenterY;
+    f32* CenterZ;
+    f32* ExtentX;
+    f32* ExtentY;
+    f32* ExtentZ;
+    u32 Count;
+};
+
+// One camera or light, Visible receives the indices of the boxes that are not outside
+struct CullingView
+{
+    DG::Frustum Frustum;  // Qualified, the member hides the type
+    u32* Visible;  // Room for every box
+    std::atomic<u32> VisibleCount{0};
+};
+
+CullingBounds AllocateCullingBounds(FrameAllocator* memory, u32 count);
+void SetCullingBounds(const CullingBounds& bounds, u32 index, const AABB& aabb);
+CullingView* AllocateCullingView(FrameAllocator* memory, const mat4& viewProjection, u32 count);
+
+// Tests every box against every view in parallel jobs, same result as TestAABBInFrustum. The
+// visible lists come out in no particular order.
+void CullBounds(const CullingBounds& bounds, CullingView** views, u32 viewCount);
+}  // namespace DG::graphics
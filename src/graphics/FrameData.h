@@ -13,7 +13,7 @@ namespace DG::graphics
 {
 struct FrameData
 {
-    StackAllocator FrameMemory;
+    FrameAllocator FrameMemory;
     ConditionVariable RenderDone;
     ConditionVariable DoubleBufferDone;
     bool IsPreRenderDone = false;
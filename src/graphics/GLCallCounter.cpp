@@ -0,0 +1,132 @@
+/**
+ *  @file    GLCallCounter.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "GLCallCounter.h"
+#include <glad/glad.h>
+#include <type_traits>
+
+namespace DG::graphics
+{
+#if DG_GL_CALL_COUNTER
+static u32 GLCallCount = 0;
+
+// One per glad function pointer, Slot is the pointer glad calls through
+template <auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct CountedGLFunction;
+
+template <auto* Slot, typename Result, typename... Args>
+struct CountedGLFunction<Slot, Result(APIENTRYP)(Args...)>
+{
+    static inline Result(APIENTRYP Original)(Args...) = nullptr;
+
+    static Result APIENTRY Call(Args... args)
+    {
+        ++GLCallCount;
+        return Original(args...);
+    }
+
+    static void Install()
+    {
+        // Not available in this context or already counted
+        if (!*Slot || Original)
+            return;
+        Original = *Slot;
+        *Slot = &Call;
+    }
+};
+
+#define DG_GL_COUNTED_FUNCTIONS(X) \
+    X(glActiveTexture)             \
+    X(glAttachShader)              \
+    X(glBindBuffer)                \
+    X(glBindBufferBase)            \
+    X(glBindFramebuffer)           \
+    X(glBindSampler)               \
+    X(glBindTexture)               \
+    X(glBindVertexArray)           \
+    X(glBlendEquation)             \
+    X(glBlendEquationSeparate)     \
+    X(glBlendFunc)                 \
+    X(glBlendFuncSeparate)         \
+    X(glBufferData)                \
+    X(glBufferSubData)             \
+    X(glClear)                     \
+    X(glClearColor)                \
+    X(glClientWaitSync)            \
+    X(glCompileShader)             \
+    X(glCreateProgram)             \
+    X(glCreateShader)              \
+    X(glDeleteBuffers)             \
+    X(glDeleteFramebuffers)        \
+    X(glDeleteProgram)             \
+    X(glDeleteShader)              \
+    X(glDeleteSync)                \
+    X(glDeleteTextures)            \
+    X(glDeleteVertexArrays)        \
+    X(glDepthFunc)                 \
+    X(glDetachShader)              \
+    X(glDisable)                   \
+    X(glDrawElements)              \
+    X(glDrawElementsInstanced)     \
+    X(glEnable)                    \
+    X(glEnableVertexAttribArray)   \
+    X(glFenceSync)                 \
+    X(glFinish)                    \
+    X(glFramebufferTexture)        \
+    X(glFramebufferTexture2D)      \
+    X(glGenBuffers)                \
+    X(glGenFramebuffers)           \
+    X(glGenTextures)               \
+    X(glGenVertexArrays)           \
+    X(glGenerateMipmap)            \
+    X(glGetActiveUniform)          \
+    X(glGetAttribLocation)         \
+    X(glGetError)                  \
+    X(glGetIntegerv)               \
+    X(glGetProgramInfoLog)         \
+    X(glGetProgramiv)              \
+    X(glGetShaderInfoLog)          \
+    X(glGetShaderiv)               \
+    X(glGetUniformLocation)        \
+    X(glIsEnabled)                 \
+    X(glLinkProgram)               \
+    X(glMapBufferRange)            \
+    X(glPixelStorei)               \
+    X(glPolygonMode)               \
+    X(glScissor)                   \
+    X(glShaderSource)              \
+    X(glTexImage2D)                \
+    X(glTexParameteri)             \
+    X(glUniform1f)                 \
+    X(glUniform1i)                 \
+    X(glUniform2f)                 \
+    X(glUniform2i)                 \
+    X(glUniform3f)                 \
+    X(glUniform3i)                 \
+    X(glUniform4f)                 \
+    X(glUniform4i)                 \
+    X(glUniformMatrix4fv)          \
+    X(glUnmapBuffer)               \
+    X(glUseProgram)                \
+    X(glVertexAttribDivisor)       \
+    X(glVertexAttribPointer)       \
+    X(glViewport)
+
+void InstallGLCallCounter()
+{
+    // The gl names are macros for the glad pointers
+#define DG_INSTALL_GL_COUNTER(function) CountedGLFunction<&function>::Install();
+    DG_GL_COUNTED_FUNCTIONS(DG_INSTALL_GL_COUNTER)
+#undef DG_INSTALL_GL_COUNTER
+}
+
+u32 GetGLCallCount() { return GLCallCount; }
+#else
+void InstallGLCallCounter() {}
+
+u32 GetGLCallCount() { return 0; }
+#endif
+}  // namespace DG::graphics
@@ -0,0 +1,26 @@
+/**
+ *  @file    GLCallCounter.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include "engine/Types.h"
+
+// Counting puts a trampoline in front of every GL call, release builds call the driver directly
+#ifndef DG_GL_CALL_COUNTER
+#if _DEBUG
+#define DG_GL_CALL_COUNTER 1
+#else
+#define DG_GL_CALL_COUNTER 0
+#endif
+#endif
+
+namespace DG::graphics
+{
+// Routes the GL entry points the engine uses through a counter, once glad has loaded them. Only
+// the render thread may call GL, the count is not synchronized. Does nothing when compiled out.
+void InstallGLCallCounter();
+// Driver calls since the counter was installed, always 0 when compiled out
+u32 GetGLCallCount();
+}  // namespace DG::graphics
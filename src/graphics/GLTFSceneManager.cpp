@@ -44,6 +44,7 @@ GLTFScene* LoadGLTF(const char* f)
         SDL_LogError(0, "Failed to parse glTF\n");
 
     GLTFScene* result = new GLTFScene();
+    DG_TRACK_ALLOCATION(RegisterMemoryTag("GLTF scenes"), sizeof(GLTFScene));
 
     // Create Buffers
     result->buffers.reserve(model.buffers.size());
@@ -57,6 +58,8 @@ GLTFScene* LoadGLTF(const char* f)
         size_t offset = 0;
         u8* memory = new u8[neededSize];
         result->bufferMemory = memory;
+        result->bufferMemorySize = neededSize;
+        DG_TRACK_ALLOCATION(RegisterMemoryTag("GLTF buffers"), neededSize);
 
         for (auto& buffer : model.buffers)
         {
@@ -6,11 +6,13 @@
 
 #include "GraphicsSystem.h"
 #include "Font.h"
+#include "GLCallCounter.h"
 #include "Shader.h"
 #include "imgui/DG_Imgui.h"
 #include "imgui/imgui_impl_sdl_gl3.h"
 #include "main.h"
 #include "math/BoundingBox.h"
+#include "platform/Job.h"
 
 namespace DG::graphics
 {
@@ -34,12 +36,46 @@ inline const char* ErrorToString(const GLenum errorCode)
             return "Unknown GL error";
     }  // switch (errorCode)
 }
+// Sorted draws of the same mesh from begin on, they become one instanced draw
+static u32 GetInstanceRunEnd(const RenderCommandBuffer* commands, u32 begin, u32 end)
+{
+    const RenderCommand& first = commands->GetSorted(begin);
+    u32 runEnd = begin + 1;
+    while (runEnd < end)
+    {
+        const RenderCommand& command = commands->GetSorted(runEnd);
+        if (command.Mesh != first.Mesh || command.Shader != first.Shader)
+            break;
+        ++runEnd;
+    }
+    return runEnd;
+}
+
+// Instances are the sorted draws [first, first + count), their matrices sit at the same index
+static void DrawMeshInstanced(const Mesh& mesh, InstanceBuffer* instanceBuffer, u32 first,
+                              u32 count, GLuint* boundVertexArray)
+{
+    if (mesh.vao != *boundVertexArray)
+    {
+        glBindVertexArray(mesh.vao);
+        *boundVertexArray = mesh.vao;
+    }
+    instanceBuffer->BindInstances(first);
+    glDrawElementsInstanced(mesh.drawMode, (s32)mesh.count, mesh.type, (void*)mesh.byteOffset,
+                            (s32)count);
+}
+
 GraphicsSystem::GraphicsSystem()
 {
     // Enable Depthtesting
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glDepthFunc(GL_LESS);
+
+    glGenBuffers(1, &_viewConstantsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, _viewConstantsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewConstants), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void GraphicsSystem::Render(ImDrawData* imOverlayDrawData, WorldRenderData** renderData, s32 count)
@@ -48,25 +84,38 @@ void GraphicsSystem::Render(ImDrawData* imOverlayDrawData, WorldRenderData** ren
 
     TWEAKER_CAT("OpenGL", Color3Small, "Clear Color", &clearColor);
 
+    const u32 glCallsBefore = GetGLCallCount();
     glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+    RenderStats stats = {};
     for (int i = 0; i < count; ++i)
     {
-        RenderWorldInternal(renderData[i]);
+        RenderWorldInternal(renderData[i], &stats);
     }
 
     // Imgui
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     ImGui_ImplSdlGL3_RenderDrawLists(imOverlayDrawData);
+
+    stats.GLCalls = GetGLCallCount() - glCallsBefore;
+    SDL_AtomicLock(&_statsLock);
+    _stats = stats;
+    SDL_AtomicUnlock(&_statsLock);
+}
+
+RenderStats GraphicsSystem::GetStats() const
+{
+    SDL_AtomicLock(&_statsLock);
+    const RenderStats stats = _stats;
+    SDL_AtomicUnlock(&_statsLock);
+    return stats;
 }
 
-void GraphicsSystem::RenderWorldInternal(WorldRenderData* worldData)
+void GraphicsSystem::RenderWorldInternal(WorldRenderData* worldData, RenderStats* stats)
 {
     static vec3 lightColor(1);
-    static vec3 lightDirection(0.1, -1, 0);
     static float bias = 0.001f;
     TWEAKER_CAT("OpenGL", F1, "Shadow Bias", &bias);
     TWEAKER(Color3Small, "Light Color", &lightColor);
-    TWEAKER(F3, "Light Direction", &lightDirection);
 
     glPolygonMode(GL_FRONT_AND_BACK, worldData->RenderCTX->IsWireframe ? GL_LINE : GL_FILL);
     if (worldData->RenderCTX->IsWireframe)
@@ -81,151 +130,147 @@ void GraphicsSystem::RenderWorldInternal(WorldRenderData* worldData)
     }
     glEnable(GL_DEPTH_TEST);
 
-    // Dir Light Shadowmap
+    // Dir Light Shadowmap, the cascades are tiles of a 2x2 atlas. Tiles of cached cascades keep
+    // their depth from an earlier frame.
     static bool wasFBInit = false;
     static Framebuffer shadowFramebuffer;
     static Shader* shadowShader =
         g_Managers->ShaderManager->LoadOrGet(StringId("shadow_map"), "shadow_map");
-    static mat4 lightProjection;
-    static mat4 lightViewMatrix;
     if (!wasFBInit)
     {
         wasFBInit = true;
-        shadowFramebuffer.Initialize(2048, 2048, false, true, true);
+        shadowFramebuffer.Initialize(2 * ShadowTileResolution, 2 * ShadowTileResolution, false,
+                                     true, true);
     }
 
-    AABB aabb;
-    // Shadow Map Orthographic View Calculation
-    {
-        lightViewMatrix = glm::lookAt(-lightDirection, vec3(0.f), vec3(0.f, 1.f, 0.f));
+    RenderCommandBuffer* commands = worldData->RenderCTX->GetCommands();
+    const u32 commandCount = commands->GetCount();
+    const u64 submitStart = SDL_GetPerformanceCounter();
 
-        // Calculate projection for light
-        {
-            auto renderQueues = worldData->RenderCTX->GetRenderQueues();
-            AABB aabb;
-            for (u32 queueIndex = 0; queueIndex < worldData->RenderCTX->GetRenderQueueCount();
-                 ++queueIndex)
+    // Matrices in sorted order, the draws of a mesh are next to each other in both passes
+    if (commandCount > 0)
+    {
+        mat4* instances = _instanceBuffer.Map(commandCount);
+        JobSystem::ParallelForRange(commandCount, 0, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i)
             {
-                // Setup Shader
-                auto renderQueue = renderQueues[queueIndex];
-
-                // Render Models
-                for (u32 renderableIndex = 0; renderableIndex < renderQueue->Count;
-                     ++renderableIndex)
-                {
-                    auto& renderable = renderQueue->Renderables[renderableIndex];
-                    auto& model = renderable.Model;
-                    if (model)
-                    {
-                        AABB modelSpaceAABB = TransformAABB(model->aabb, renderable.ModelMatrix);
-                        if (queueIndex == 0 && renderableIndex == 0)
-                        {
-                            aabb = modelSpaceAABB;
-                        }
-                        aabb = CombineAABB(aabb, modelSpaceAABB);
-                    }
-                }
+                const RenderCommand& command = commands->GetSorted(i);
+                instances[i] = command.ModelMatrix * command.Mesh->localTransform;
             }
+        });
+        _instanceBuffer.Unmap();
+        stats->Instances += commandCount;
+    }
 
-            // We got our AABB transform it to light space
-            AABB lightaabb = TransformAABB(aabb, Transform(lightViewMatrix));
-            lightProjection = glm::ortho(lightaabb.Min.x, lightaabb.Max.x, lightaabb.Min.y,
-                                         lightaabb.Max.y, -10.f, 100.f);
-        }
-
+    // Everything both passes read besides the instances, one upload per view. The cascades are
+    // fitted by the gather stage.
+    const Camera* camera = worldData->Window->GetCamera();
+    auto activeFramebuffer = worldData->Window->GetFramebuffer();
+    const ShadowCascade* cascades = worldData->RenderCTX->Cascades;
+    ViewConstants constants;
+    constants.Projection = camera->GetProjectionMatrix();
+    constants.View = camera->GetViewMatrix();
+    for (u32 cascade = 0; cascade < ShadowCascadeCount; ++cascade)
+    {
+        constants.CascadeViewProjections[cascade] = cascades[cascade].ViewProjection;
+        constants.CascadeSplits[cascade] = cascades[cascade].SplitFar;
+    }
+    constants.LightDirection = worldData->RenderCTX->LightDirection;
+    constants.ShadowBias = bias;
+    constants.LightColor = lightColor;
+    constants.Padding0 = 0.f;
+    constants.ShadowMapSize = shadowFramebuffer.GetSize();
+    constants.Padding1 = vec2(0.f);
+    glBindBuffer(GL_UNIFORM_BUFFER, _viewConstantsBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(constants), &constants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, ViewConstants::Binding, _viewConstantsBuffer);
+
+    u32 shadowBegin, shadowEnd;
+    commands->GetPassRange(RenderPass::Shadow, &shadowBegin, &shadowEnd);
+
+    // Shadow Map
+    {
         shadowFramebuffer.Bind();
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // Render Shadowmap
-        auto renderQueues = worldData->RenderCTX->GetRenderQueues();
-        for (u32 queueIndex = 0; queueIndex < worldData->RenderCTX->GetRenderQueueCount();
-             ++queueIndex)
+        glEnable(GL_SCISSOR_TEST);
+
+        // Render Shadowmap, one shader for every caster and a draw per mesh. The draws of a
+        // cascade follow each other, it sits in the shader bits of the key.
+        shadowShader->Use();
+        GLuint boundVertexArray = 0;
+        u32 cascadeBegin = shadowBegin;
+        for (u32 cascade = 0; cascade < ShadowCascadeCount; ++cascade)
         {
-            // Setup Shader
-            auto renderQueue = renderQueues[queueIndex];
-            shadowShader->Use();
-            shadowShader->SetUniform("vp", lightProjection * lightViewMatrix);
+            u32 cascadeEnd = cascadeBegin;
+            while (cascadeEnd < shadowEnd &&
+                   RenderCommandBuffer::GetShader(commands->GetSortedKey(cascadeEnd)) == cascade)
+                ++cascadeEnd;
+            if (cascades[cascade].IsCached)
+            {
+                Assert(cascadeEnd == cascadeBegin);
+                continue;
+            }
 
-            // Render Models
-            for (u32 renderableIndex = 0; renderableIndex < renderQueue->Count; ++renderableIndex)
+            const s32 x = (s32)(cascade & 1) * ShadowTileResolution;
+            const s32 y = (s32)(cascade >> 1) * ShadowTileResolution;
+            glViewport(x, y, ShadowTileResolution, ShadowTileResolution);
+            glScissor(x, y, ShadowTileResolution, ShadowTileResolution);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            shadowShader->SetUniform("cascade", (s32)cascade);
+            for (u32 i = cascadeBegin; i < cascadeEnd;)
             {
-                auto& renderable = renderQueue->Renderables[renderableIndex];
-                auto& model = renderable.Model;
-                if (model)
-                {
-                    for (auto& mesh : model->meshes)
-                    {
-                        shadowShader->SetUniform("m", renderable.ModelMatrix * mesh.localTransform);
-
-                        glBindVertexArray(mesh.vao);
-                        glDrawElements(mesh.drawMode, (s32)mesh.count, mesh.type,
-                                       (void*)mesh.byteOffset);
-                    }
-                    CheckOpenGLError(__FILE__, __LINE__);
-                }
+                const u32 runEnd = GetInstanceRunEnd(commands, i, cascadeEnd);
+                DrawMeshInstanced(*commands->GetSorted(i).Mesh, &_instanceBuffer, i, runEnd - i,
+                                  &boundVertexArray);
+                stats->DrawCalls++;
+                i = runEnd;
             }
+            stats->ShadowCascades++;
+            cascadeBegin = cascadeEnd;
         }
+        glDisable(GL_SCISSOR_TEST);
+        CheckOpenGLError(__FILE__, __LINE__);
         shadowFramebuffer.UnBind();
         // Unbind after we are done rendering
         glBindVertexArray(0);
     }  // End ShadowMap
 
-    auto activeFramebuffer = worldData->Window->GetFramebuffer();
     activeFramebuffer->Bind();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    const Camera* camera = worldData->Window->GetCamera();
-    auto renderQueues = worldData->RenderCTX->GetRenderQueues();
-    for (u32 queueIndex = 0; queueIndex < worldData->RenderCTX->GetRenderQueueCount(); ++queueIndex)
+    glActiveTexture(GL_TEXTURE0);
+    shadowFramebuffer.DepthTexture.Bind();
+
+    // Draws come sorted by shader and mesh, only switch when they change
+    u32 opaqueBegin, opaqueEnd;
+    commands->GetPassRange(RenderPass::Opaque, &opaqueBegin, &opaqueEnd);
+    Shader* boundShader = nullptr;
+    GLuint boundVertexArray = 0;
+    for (u32 i = opaqueBegin; i < opaqueEnd;)
     {
-        // Setup Shader
-        auto renderQueue = renderQueues[queueIndex];
-        renderQueue->Shader->Use();
-        renderQueue->Shader->SetUniform("proj", camera->GetProjectionMatrix());
-        renderQueue->Shader->SetUniform("view", camera->GetViewMatrix());
-        renderQueue->Shader->SetUniform("lightMVP", lightProjection * lightViewMatrix);
-        renderQueue->Shader->SetUniform("lightDirection", lightDirection);
-        renderQueue->Shader->SetUniform("lightColor", lightColor);
-        renderQueue->Shader->SetUniform("bias", bias);
-        renderQueue->Shader->SetUniform("resolution", activeFramebuffer->GetSize());
-
-        glActiveTexture(GL_TEXTURE0);
-        shadowFramebuffer.DepthTexture.Bind();
-
-        // Render Models
-        for (u32 renderableIndex = 0; renderableIndex < renderQueue->Count; ++renderableIndex)
+        const RenderCommand& command = commands->GetSorted(i);
+        if (command.Shader != boundShader)
         {
-            auto& renderable = renderQueue->Renderables[renderableIndex];
-            auto& model = renderable.Model;
-            if (model)
-            {
-                for (auto& mesh : model->meshes)
-                {
-                    renderQueue->Shader->SetUniform("model",
-                                                    renderable.ModelMatrix * mesh.localTransform);
-
-                    glBindVertexArray(mesh.vao);
-                    glDrawElements(mesh.drawMode, (s32)(mesh.count), mesh.type,
-                                   (void*)(mesh.byteOffset));
-                }
-                CheckOpenGLError(__FILE__, __LINE__);
-            }
+            boundShader = command.Shader;
+            boundShader->Use();
         }
+        const u32 runEnd = GetInstanceRunEnd(commands, i, opaqueEnd);
+        DrawMeshInstanced(*command.Mesh, &_instanceBuffer, i, runEnd - i, &boundVertexArray);
+        stats->DrawCalls++;
+        i = runEnd;
     }
+    CheckOpenGLError(__FILE__, __LINE__);
     // Unbind after we are done rendering
     glBindVertexArray(0);
+    _instanceBuffer.Fence();
+    stats->SubmitMs += (f32)(SDL_GetPerformanceCounter() - submitStart) * 1000.f /
+                       (f32)SDL_GetPerformanceFrequency();
 
     _debugRenderSystem.Render(worldData);
 
     activeFramebuffer->UnBind();
 }
 
-void RenderContext::AddRenderQueue(RenderQueue* queue)
-{
-    Assert(_currentIndexRenderQueue < COUNT_OF(_renderQueues));
-    _renderQueues[_currentIndexRenderQueue++] = queue;
-}
-
 void DebugRenderContext::AddLine(const vec3& vertex0, const vec3& vertex1, const Color& color,
                                  bool depthEnabled)
 {
@@ -8,8 +8,11 @@
 #include <glad/glad.h>
 #include <imgui.h>
 #include <vector>
+#include "InstanceBuffer.h"
 #include "Mesh.h"
+#include "RenderCommandBuffer.h"
 #include "Shader.h"
+#include "ShadowCascades.h"
 #include "engine/Camera.h"
 #include "math/Transform.h"
 
@@ -101,36 +104,23 @@ class DebugRenderContext
     std::vector<DebugLine> _depthDisabledDebugLines;
 };
 
-struct Renderable
-{
-    mat4 ModelMatrix;
-    GraphicsModel *Model;
-};
-
-struct RenderQueue
-{
-    Shader *Shader;
-    Renderable *Renderables;
-    u32 Count;
-};
-
 class RenderContext
 {
    public:
-    RenderContext() = default;
-
-    RenderQueue **GetRenderQueues() { return _renderQueues; }
-    u32 GetRenderQueueCount() const { return _currentIndexRenderQueue; }
+    // Draws are recorded into frame memory
+    explicit RenderContext(FrameAllocator *frameMemory) : _commands(frameMemory) {}
 
-    void AddRenderQueue(RenderQueue *queue);
+    RenderCommandBuffer *GetCommands() { return &_commands; }
 
     bool IsWireframe = false;
+    // Directional light, the cascades split the camera frustum
+    vec3 LightDirection;
+    ShadowCascade Cascades[ShadowCascadeCount];
 
    private:
     mat4 _cameraViewMatrix;
     mat4 _cameraProjMatrix;
-    u32 _currentIndexRenderQueue = 0;
-    RenderQueue *_renderQueues[10] = {};
+    RenderCommandBuffer _commands;
 };
 
 struct WorldRenderData
@@ -164,16 +154,56 @@ class DebugRenderSystem
     GLuint linePointEBO = -1;
 };
 
+// Shadow and opaque passes of the last rendered frame
+struct RenderStats
+{
+    u32 DrawCalls;
+    u32 Instances;
+    f32 SubmitMs;        // CPU time from the instance upload to the last draw
+    u32 GLCalls;         // Every driver call of the frame with ImGui, 0 without the counter
+    u32 ShadowCascades;  // Tiles that were rendered, cached ones are skipped
+};
+
+// The std140 ViewConstants block of base_model and shadow_map, uploaded once per view
+struct ViewConstants
+{
+    enum : u32
+    {
+        Binding = 0
+    };
+
+    mat4 Projection;
+    mat4 View;
+    mat4 CascadeViewProjections[ShadowCascadeCount];
+    vec4 CascadeSplits;  // SplitFar of every cascade
+    vec3 LightDirection;
+    f32 ShadowBias;
+    vec3 LightColor;
+    f32 Padding0;  // vec2 aligns to 8 bytes
+    vec2 ShadowMapSize;
+    vec2 Padding1;  // Blocks round up to 16 bytes
+};
+static_assert(ShadowCascadeCount == 4, "The shaders hold four cascades");
+static_assert(offsetof(ViewConstants, ShadowMapSize) == 432 && sizeof(ViewConstants) == 448,
+              "ViewConstants has to match the std140 layout of the shaders");
+
 class GraphicsSystem
 {
    public:
     GraphicsSystem();
 
     void Render(ImDrawData *imOverlayDrawData, WorldRenderData **renderData, s32 count);
+    // From any thread
+    RenderStats GetStats() const;
 
    private:
-    void RenderWorldInternal(WorldRenderData *worldData);
+    void RenderWorldInternal(WorldRenderData *worldData, RenderStats *stats);
     DebugRenderSystem _debugRenderSystem;
+    InstanceBuffer _instanceBuffer;
+    GLuint _viewConstantsBuffer = 0;
+
+    RenderStats _stats = {};
+    mutable SDL_SpinLock _statsLock = 0;
 };
 
 void AddDebugLine(const vec3 &fromPosition, const vec3 &toPosition, Color color = Color(0.7f),
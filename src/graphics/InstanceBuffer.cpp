@@ -0,0 +1,89 @@
+/**
+ *  @file    InstanceBuffer.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "InstanceBuffer.h"
+#include "GraphicsSystem.h"
+
+namespace DG::graphics
+{
+static void WaitAndDeleteFence(GLsync* fence)
+{
+    if (!*fence)
+        return;
+
+    GLenum result;
+    do
+    {
+        result = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(*fence);
+    *fence = nullptr;
+}
+
+mat4* InstanceBuffer::Map(u32 count)
+{
+    Assert(count > 0);
+    if (count > _regionCapacity)
+        Grow(count);
+
+    _region = (_region + 1) % Regions;
+    WaitAndDeleteFence(&_fences[_region]);
+    _mappedOffset = (size_t)_region * _regionCapacity * sizeof(mat4);
+
+    // The fence already synchronized, the driver doesn't have to
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    void* memory = glMapBufferRange(
+        GL_ARRAY_BUFFER, _mappedOffset, count * sizeof(mat4),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    CheckOpenGLError(__FILE__, __LINE__);
+    return (mat4*)memory;
+}
+
+void InstanceBuffer::Unmap()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::BindInstances(u32 first)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    const size_t offset = _mappedOffset + first * sizeof(mat4);
+    for (u32 column = 0; column < 4; ++column)
+    {
+        const GLuint location = InstanceAttribute + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                              (void*)(offset + column * sizeof(vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::Fence()
+{
+    // Without a map since the last fence the new one covers the same draws and more
+    if (_fences[_region])
+        glDeleteSync(_fences[_region]);
+    _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void InstanceBuffer::Grow(u32 count)
+{
+    // Regions move, nothing may still read the old storage
+    for (GLsync& fence : _fences) WaitAndDeleteFence(&fence);
+
+    if (!_buffer)
+        glGenBuffers(1, &_buffer);
+    _regionCapacity = glm::max(glm::max(count, 2 * _regionCapacity), (u32)MinInstances);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)Regions * _regionCapacity * sizeof(mat4), nullptr,
+                 GL_STREAM_DRAW);
+    CheckOpenGLError(__FILE__, __LINE__);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+}  // namespace DG::graphics
@@ -0,0 +1,46 @@
+/**
+ *  @file    InstanceBuffer.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <glad/glad.h>
+#include "Mesh.h"
+#include "engine/Types.h"
+#include "math/GLMInclude.h"
+
+namespace DG::graphics
+{
+// Model matrices of instanced draws, streamed into one GL buffer split into a region per frame in
+// flight. Every frame maps the next region unsynchronized, a fence per region keeps the CPU from
+// overwriting matrices the GPU still reads.
+class InstanceBuffer
+{
+   public:
+    enum : u32
+    {
+        Regions = 3,
+        MinInstances = 1024,
+        // mat4 takes four locations from here on, after every glTF attribute
+        InstanceAttribute = GLTFPrimitive::Length
+    };
+
+    // Room for count matrices in the next region, write only. Waits if the GPU is still behind.
+    mat4* Map(u32 count);
+    void Unmap();
+    // Points the instance attribute of the bound vertex array at matrix first of the mapped range
+    void BindInstances(u32 first);
+    // After the last draw reading the region
+    void Fence();
+
+   private:
+    void Grow(u32 count);
+
+    GLuint _buffer = 0;
+    u32 _regionCapacity = 0;  // Matrices
+    u32 _region = 0;
+    size_t _mappedOffset = 0;
+    GLsync _fences[Regions] = {};
+};
+}  // namespace DG::graphics
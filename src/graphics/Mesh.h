@@ -12,6 +12,7 @@
 #include "Shader.h"
 #include "engine/Types.h"
 #include "math/BoundingBox.h"
+#include "memory/MemoryTracker.h"
 #include "platform/StringIdCRC32.h"
 
 namespace DG::graphics
@@ -153,12 +154,18 @@ struct GLTFNode
 
 struct GLTFScene
 {
-    ~GLTFScene() { delete bufferMemory; }
+    ~GLTFScene()
+    {
+        DG_TRACK_FREE(RegisterMemoryTag("GLTF buffers"), bufferMemorySize);
+        DG_TRACK_FREE(RegisterMemoryTag("GLTF scenes"), sizeof(GLTFScene));
+        delete[] bufferMemory;
+    }
     bool isAvailableForRendering = false;
     std::vector<GLTFNode*> children;
 
     // Ptr for cleanup
     u8* bufferMemory;
+    size_t bufferMemorySize;
     std::vector<GLTFBuffer> buffers;
     std::vector<GLTFBufferView> bufferViews;
     std::vector<GLTFAccessor> accessors;
@@ -0,0 +1,244 @@
+/**
+ *  @file    RenderBenchmark.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "RenderBenchmark.h"
+#include <SDL.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Culling.h"
+#include "RenderCommandBuffer.h"
+#include "memory/Memory.h"
+
+namespace DG
+{
+static const u32 BENCHMARK_DRAWS = 100 * 1000;
+static const u32 BENCHMARK_SHADERS = 16;
+static const u32 BENCHMARK_MATERIALS = 256;
+static const u32 BENCHMARK_VERTEX_ARRAYS = 2048;
+static const u32 BENCHMARK_ITERATIONS = 10;
+static const u32 BENCHMARK_FRAME_SIZE = 64 * 1024 * 1024;
+static const u32 BENCHMARK_CULLING_BOXES = 1000 * 1000;
+static const f32 BENCHMARK_CULLING_EXTENT = 1000.f;
+
+struct BenchmarkDraw
+{
+    u32 Shader;
+    u32 Material;
+    u32 VertexArray;
+    f32 Depth;
+};
+
+static f64 ElapsedMs(u64 start)
+{
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           (f64)SDL_GetPerformanceFrequency();
+}
+
+// Reference for CullBounds, one box after the other on this thread
+static u32 CullScalar(const std::vector<AABB>& boxes, const Frustum& frustum, u32* visible)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < (u32)boxes.size(); ++i)
+    {
+        if (TestAABBInFrustum(boxes[i], frustum) != FrustumTest::Outside)
+            visible[count++] = i;
+    }
+    return count;
+}
+
+// Switches a renderer binding only on change would do in this order
+static void CountSwitches(const std::vector<u64>& keys, u32* shaderSwitches,
+                          u32* vertexArraySwitches)
+{
+    *shaderSwitches = *vertexArraySwitches = 0;
+    u64 lastShader = ~0ull;
+    u64 lastVertexArray = ~0ull;
+    for (u64 key : keys)
+    {
+        // Same layout as RenderCommandBuffer::MakeKey
+        const u64 shader = key >> 52;
+        const u64 vertexArray = key >> 24 & 0x3FFF;
+        *shaderSwitches += shader != lastShader;
+        *vertexArraySwitches += vertexArray != lastVertexArray;
+        lastShader = shader;
+        lastVertexArray = vertexArray;
+    }
+}
+
+void RunRenderCommandBenchmark()
+{
+    using namespace graphics;
+
+    FrameAllocator frameMemory;
+    if (!frameMemory.InitVirtual(BENCHMARK_FRAME_SIZE))
+    {
+        SDL_LogError(0, "Couldn't reserve %u bytes for the render benchmark",
+                     BENCHMARK_FRAME_SIZE);
+        return;
+    }
+
+    // Vertex arrays belong to a material, materials to a shader, like models would
+    std::mt19937 random(BENCHMARK_DRAWS);
+    std::vector<BenchmarkDraw> draws(BENCHMARK_DRAWS);
+    std::vector<u64> unsortedKeys(BENCHMARK_DRAWS);
+    for (u32 i = 0; i < BENCHMARK_DRAWS; ++i)
+    {
+        BenchmarkDraw& draw = draws[i];
+        draw.VertexArray = 1 + random() % BENCHMARK_VERTEX_ARRAYS;
+        draw.Material = draw.VertexArray % BENCHMARK_MATERIALS;
+        draw.Shader = 1 + draw.Material % BENCHMARK_SHADERS;
+        draw.Depth = std::uniform_real_distribution<f32>(0.1f, 1000.f)(random);
+        unsortedKeys[i] = RenderCommandBuffer::MakeKey(RenderPass::Opaque, draw.Shader,
+                                                       draw.Material, draw.VertexArray, draw.Depth);
+    }
+
+    f64 buildMs = 0.0;
+    f64 sortMs = 0.0;
+    u64 checksum = 0;
+    std::vector<u64> sortedKeys(BENCHMARK_DRAWS);
+    for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+    {
+        frameMemory.Reset();
+        RenderCommandBuffer commands(&frameMemory);
+
+        u64 start = SDL_GetPerformanceCounter();
+        const mat4 modelMatrix(1.f);
+        for (const BenchmarkDraw& draw : draws)
+        {
+            RenderCommand* command = commands.Add(RenderCommandBuffer::MakeKey(
+                RenderPass::Opaque, draw.Shader, draw.Material, draw.VertexArray, draw.Depth));
+            command->ModelMatrix = modelMatrix;
+            command->Mesh = nullptr;
+            command->Shader = nullptr;
+        }
+        buildMs += ElapsedMs(start);
+
+        start = SDL_GetPerformanceCounter();
+        commands.Sort();
+        sortMs += ElapsedMs(start);
+
+        for (u32 i = 0; i < BENCHMARK_DRAWS; ++i) sortedKeys[i] = commands.GetSortedKey(i);
+        checksum += sortedKeys[BENCHMARK_DRAWS / 2];
+    }
+
+    // The reference sort works on the bare keys, less data to move than the radix sort
+    std::vector<u64> keys;
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+    {
+        keys = unsortedKeys;
+        std::sort(keys.begin(), keys.end());
+    }
+    const f64 stdSortMs = ElapsedMs(start) / BENCHMARK_ITERATIONS;
+    Assert(keys == sortedKeys);
+
+    u32 unsortedShaders, unsortedVertexArrays, sortedShaders, sortedVertexArrays;
+    CountSwitches(unsortedKeys, &unsortedShaders, &unsortedVertexArrays);
+    CountSwitches(sortedKeys, &sortedShaders, &sortedVertexArrays);
+
+    SDL_Log("Render command benchmark, %u draws: build %8.3fms, radix sort %8.3fms, std::sort "
+            "%8.3fms (%llu)",
+            BENCHMARK_DRAWS, buildMs / BENCHMARK_ITERATIONS, sortMs / BENCHMARK_ITERATIONS,
+            stdSortMs, (unsigned long long)checksum);
+    SDL_Log("  Shader switches %u -> %u, vertex array binds %u -> %u", unsortedShaders,
+            sortedShaders, unsortedVertexArrays, sortedVertexArrays);
+    frameMemory.ReleaseVirtual();
+}
+
+void RunCullingBenchmark()
+{
+    using namespace graphics;
+
+    FrameAllocator frameMemory;
+    if (!frameMemory.InitVirtual(BENCHMARK_FRAME_SIZE))
+    {
+        SDL_LogError(0, "Couldn't reserve %u bytes for the culling benchmark",
+                     BENCHMARK_FRAME_SIZE);
+        return;
+    }
+
+    // Small boxes scattered in a cube around the origin
+    std::mt19937 random(BENCHMARK_CULLING_BOXES);
+    std::uniform_real_distribution<f32> position(-BENCHMARK_CULLING_EXTENT,
+                                                 BENCHMARK_CULLING_EXTENT);
+    std::uniform_real_distribution<f32> size(0.5f, 10.f);
+    std::vector<AABB> boxes(BENCHMARK_CULLING_BOXES);
+    for (AABB& box : boxes)
+    {
+        const vec3 center(position(random), position(random), position(random));
+        const vec3 extent(size(random), size(random), size(random));
+        box.Min = center - extent;
+        box.Max = center + extent;
+    }
+
+    // A camera inside the cube and a light seeing a quarter of it
+    const mat4 cameraViewProjection =
+        glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f) *
+        glm::lookAt(vec3(0.f, 50.f, 0.f), vec3(100.f, 0.f, 100.f), vec3(0.f, 1.f, 0.f));
+    const f32 lightExtent = BENCHMARK_CULLING_EXTENT / 2.f;
+    const mat4 lightViewProjection =
+        glm::ortho(-lightExtent, lightExtent, -lightExtent, lightExtent, -10.f,
+                   2.f * BENCHMARK_CULLING_EXTENT) *
+        glm::lookAt(vec3(0.f, BENCHMARK_CULLING_EXTENT, 0.f), vec3(0.f), vec3(1.f, 0.f, 0.f));
+    const mat4* viewProjections[] = {&cameraViewProjection, &lightViewProjection};
+
+    f64 setupMs = 0.0;
+    f64 cullMs = 0.0;
+    std::vector<u32> visible[COUNT_OF(viewProjections)];
+    for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+    {
+        frameMemory.Reset();
+
+        u64 start = SDL_GetPerformanceCounter();
+        CullingBounds bounds = AllocateCullingBounds(&frameMemory, BENCHMARK_CULLING_BOXES);
+        for (u32 i = 0; i < BENCHMARK_CULLING_BOXES; ++i) SetCullingBounds(bounds, i, boxes[i]);
+        setupMs += ElapsedMs(start);
+
+        CullingView* views[COUNT_OF(viewProjections)];
+        for (u32 v = 0; v < COUNT_OF(views); ++v)
+            views[v] =
+                AllocateCullingView(&frameMemory, *viewProjections[v], BENCHMARK_CULLING_BOXES);
+
+        start = SDL_GetPerformanceCounter();
+        CullBounds(bounds, views, COUNT_OF(views));
+        cullMs += ElapsedMs(start);
+
+        for (u32 v = 0; v < COUNT_OF(views); ++v)
+            visible[v].assign(views[v]->Visible, views[v]->Visible + views[v]->VisibleCount);
+    }
+
+    f64 scalarMs = 0.0;
+    std::vector<u32> scalarVisible[COUNT_OF(viewProjections)];
+    for (u32 v = 0; v < COUNT_OF(viewProjections); ++v)
+    {
+        const Frustum frustum = ExtractFrustum(*viewProjections[v]);
+        scalarVisible[v].resize(BENCHMARK_CULLING_BOXES);
+        u32 count = 0;
+        const u64 start = SDL_GetPerformanceCounter();
+        for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+            count = CullScalar(boxes, frustum, scalarVisible[v].data());
+        scalarMs += ElapsedMs(start);
+        scalarVisible[v].resize(count);
+
+        // The jobs append whole blocks in any order
+        std::sort(visible[v].begin(), visible[v].end());
+        Assert(visible[v] == scalarVisible[v]);
+    }
+
+    // Every box is tested once per view
+    const f64 tests = (f64)BENCHMARK_CULLING_BOXES * COUNT_OF(viewProjections);
+    cullMs /= BENCHMARK_ITERATIONS;
+    scalarMs /= BENCHMARK_ITERATIONS;
+    SDL_Log("Culling benchmark, %u boxes: setup %8.3fms, cull %8.3fms (%.1fM boxes/s), scalar "
+            "%8.3fms (%.1fM boxes/s)",
+            BENCHMARK_CULLING_BOXES, setupMs / BENCHMARK_ITERATIONS, cullMs,
+            tests / (cullMs * 1000.0), scalarMs, tests / (scalarMs * 1000.0));
+    SDL_Log("  Visible to the camera %u, to the light %u", (u32)visible[0].size(),
+            (u32)visible[1].size());
+    frameMemory.ReleaseVirtual();
+}
+}  // namespace DG
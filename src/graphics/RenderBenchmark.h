@@ -0,0 +1,18 @@
+/**
+ *  @file    RenderBenchmark.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+
+namespace DG
+{
+// Records 100k draws over a spread of shaders, materials and vertex arrays into a
+// RenderCommandBuffer and sorts them, without a GL context. Logs build and sort times against
+// std::sort and the shader and vertex array switches the order saves.
+void RunRenderCommandBenchmark();
+// Culls a million synthetic boxes against a camera and a light frustum in jobs and against the
+// scalar test on one thread. Logs both in millions of boxes per second.
+void RunCullingBenchmark();
+}  // namespace DG
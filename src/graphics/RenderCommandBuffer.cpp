@@ -0,0 +1,129 @@
+/**
+ *  @file    RenderCommandBuffer.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "RenderCommandBuffer.h"
+#include "memory/Memory.h"
+
+namespace DG::graphics
+{
+static const u32 PASS_BITS = 2;
+static const u32 SHADER_BITS = 10;
+static const u32 MATERIAL_BITS = 14;
+static const u32 VERTEX_ARRAY_BITS = 14;
+static const u32 DEPTH_BITS = 24;
+static_assert(PASS_BITS + SHADER_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS == 64,
+              "Render keys have to fill 64 bits");
+
+u64 RenderCommandBuffer::MakeKey(RenderPass pass, u32 shader, u32 material, u32 vertexArray,
+                                 f32 depth)
+{
+    // Positive floats sort like their bits, the top ones keep the exponent and most of the
+    // mantissa. Behind the camera counts as 0.
+    u32 depthBits = 0;
+    if (depth > 0.f)
+        SDL_memcpy(&depthBits, &depth, sizeof(depthBits));
+    depthBits >>= 32 - DEPTH_BITS;
+
+    u64 key = (u64)pass;
+    key = key << SHADER_BITS | (shader & ((1u << SHADER_BITS) - 1));
+    key = key << MATERIAL_BITS | (material & ((1u << MATERIAL_BITS) - 1));
+    key = key << VERTEX_ARRAY_BITS | (vertexArray & ((1u << VERTEX_ARRAY_BITS) - 1));
+    key = key << DEPTH_BITS | depthBits;
+    return key;
+}
+
+u32 RenderCommandBuffer::GetShader(u64 key)
+{
+    return (u32)(key >> (MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS)) &
+           ((1u << SHADER_BITS) - 1);
+}
+
+RenderCommand* RenderCommandBuffer::Add(u64 key)
+{
+    const u32 chunkIndex = _count / CommandsPerChunk;
+    if (_count % CommandsPerChunk == 0)
+    {
+        if (chunkIndex == _chunkCapacity)
+        {
+            // The old array stays behind in the frame memory, it is small next to the chunks
+            const u32 capacity = _chunkCapacity ? 2 * _chunkCapacity : 8;
+            Chunk** chunks = _memory->Push<Chunk*>(capacity);
+            if (_chunkCapacity)
+                SDL_memcpy(chunks, _chunks, _chunkCapacity * sizeof(Chunk*));
+            _chunks = chunks;
+            _chunkCapacity = capacity;
+        }
+        _chunks[chunkIndex] = _memory->Push<Chunk>();
+    }
+
+    Chunk* chunk = _chunks[chunkIndex];
+    const u32 index = _count++ % CommandsPerChunk;
+    chunk->Keys[index] = key;
+    _sorted = nullptr;
+    return &chunk->Commands[index];
+}
+
+void RenderCommandBuffer::Sort()
+{
+    if (_count == 0)
+        return;
+
+    // LSD radix sort, a byte per pass. All histograms come from one read, passes where every key
+    // has the same byte are skipped, usually the pass and shader bytes.
+    SortEntry* from = _memory->Push<SortEntry>(2 * _count);
+    SortEntry* to = from + _count;
+    u32 histograms[8][256] = {};
+    for (u32 i = 0; i < _count; ++i)
+    {
+        const u64 key = _chunks[i / CommandsPerChunk]->Keys[i % CommandsPerChunk];
+        from[i].Key = key;
+        from[i].Index = i;
+        for (u32 byte = 0; byte < 8; ++byte) histograms[byte][(key >> (8 * byte)) & 0xFF]++;
+    }
+
+    for (u32 byte = 0; byte < 8; ++byte)
+    {
+        u32* histogram = histograms[byte];
+        if (histogram[(from[0].Key >> (8 * byte)) & 0xFF] == _count)
+            continue;
+
+        u32 offset = 0;
+        for (u32 bucket = 0; bucket < 256; ++bucket)
+        {
+            const u32 count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += count;
+        }
+        for (u32 i = 0; i < _count; ++i)
+            to[histogram[(from[i].Key >> (8 * byte)) & 0xFF]++] = from[i];
+
+        SortEntry* swap = from;
+        from = to;
+        to = swap;
+    }
+    _sorted = from;
+}
+
+void RenderCommandBuffer::GetPassRange(RenderPass pass, u32* begin, u32* end) const
+{
+    Assert(_sorted || _count == 0);
+    auto lowerBound = [this](u32 passValue) {
+        u32 low = 0;
+        u32 high = _count;
+        while (low < high)
+        {
+            const u32 middle = (low + high) / 2;
+            if ((u32)GetPass(_sorted[middle].Key) < passValue)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    };
+    *begin = lowerBound((u32)pass);
+    *end = lowerBound((u32)pass + 1);
+}
+}  // namespace DG::graphics
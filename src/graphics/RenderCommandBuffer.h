@@ -0,0 +1,91 @@
+/**
+ *  @file    RenderCommandBuffer.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include "engine/Types.h"
+#include "math/GLMInclude.h"
+
+namespace DG
+{
+class FrameAllocator;
+}
+
+namespace DG::graphics
+{
+class Mesh;
+class Shader;
+
+// Lowest first. Shadow draws are rendered with the shadow map shader of the renderer.
+enum class RenderPass : u8
+{
+    Shadow,
+    Opaque
+};
+
+// One mesh draw
+struct RenderCommand
+{
+    mat4 ModelMatrix;  // Of the component, the mesh local transform is applied when drawing
+    // Types qualified, the members hide their names
+    const graphics::Mesh* Mesh;
+    graphics::Shader* Shader;  // Null in passes with a shader of their own
+};
+
+// Draws of one frame in the frame memory, sorted by a 64 bit key before submission so draws
+// sharing a shader and a vertex array end up next to each other. From the top bit down the key
+// holds the pass, shader, material, vertex array and depth. Only the order depends on the key,
+// ids that don't fit their bits merely group worse.
+class RenderCommandBuffer
+{
+   public:
+    enum : u32
+    {
+        CommandsPerChunk = 1024
+    };
+
+    explicit RenderCommandBuffer(FrameAllocator* memory) : _memory(memory) {}
+
+    static u64 MakeKey(RenderPass pass, u32 shader, u32 material, u32 vertexArray, f32 depth);
+    static RenderPass GetPass(u64 key) { return (RenderPass)(key >> 62); }
+    // The shadow pass keeps the cascade here, it has a shader of its own
+    static u32 GetShader(u64 key);
+
+    // Grows by a chunk of frame memory whenever the last one is full, one thread at a time
+    RenderCommand* Add(u64 key);
+    // Radix sort on the keys, equal keys keep the order they were added in
+    void Sort();
+
+    u32 GetCount() const { return _count; }
+    // Sorted indices of the draws in pass, after Sort
+    void GetPassRange(RenderPass pass, u32* begin, u32* end) const;
+    // In the order they were added
+    const RenderCommand& Get(u32 index) const
+    {
+        return _chunks[index / CommandsPerChunk]->Commands[index % CommandsPerChunk];
+    }
+    // After Sort
+    const RenderCommand& GetSorted(u32 index) const { return Get(_sorted[index].Index); }
+    u64 GetSortedKey(u32 index) const { return _sorted[index].Key; }
+
+   private:
+    struct Chunk
+    {
+        RenderCommand Commands[CommandsPerChunk];
+        u64 Keys[CommandsPerChunk];
+    };
+    struct SortEntry
+    {
+        u64 Key;
+        u32 Index;
+    };
+
+    FrameAllocator* _memory;
+    Chunk** _chunks = nullptr;  // Doubles when full, the chunks themselves never move
+    u32 _chunkCapacity = 0;
+    u32 _count = 0;
+    SortEntry* _sorted = nullptr;
+};
+}  // namespace DG::graphics
@@ -5,8 +5,10 @@
  */
 
 #include "Renderer.h"
+#include "GLCallCounter.h"
 #include "imgui/imgui_impl_sdl_gl3.h"
 #include "main.h"
+#include "platform/Job.h"
 
 namespace DG::graphics
 {
@@ -38,6 +40,7 @@ static bool InitOpenGL(RenderState* renderState)
         SDL_LogError(0, "I did load GL with no context!\n");
         return false;
     }
+    InstallGLCallCounter();
 
     SDL_DisplayMode current;
     int should_be_zero = SDL_GetCurrentDisplayMode(0, &current);
@@ -71,6 +74,10 @@ static int RenderThreadStart(void* data)
 {
     SDL_Log("Initializing Renderer...");
     RenderState* renderState = (RenderState*)data;
+
+    // Lets the render thread spread its own passes over the workers. It only helps with those while
+    // waiting, a long gameplay job picked up there would hold back the frame.
+    JobSystem::RegisterSubmitThread();
     {
         InitOpenGL(renderState);
         renderState->GraphicsSystem = renderState->RenderMemory.PushAndConstruct<GraphicsSystem>();
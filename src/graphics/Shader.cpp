@@ -178,57 +178,88 @@ void Shader::ReloadShader()
     }
 
     _isValid = isValid;
+    CacheUniformLocations();
 }
 
-void Shader::SetUniform(std::string_view name, const int& val)
+void Shader::CacheUniformLocations()
+{
+    _uniformLocations.clear();
+    if (!_isValid)
+        return;
+
+    GLint uniformCount = 0;
+    glGetProgramiv(_programId, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        char name[256];
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(_programId, (GLuint)i, sizeof(name), nullptr, &size, &type, name);
+
+        // Block members have no location, arrays are set through their first element
+        const s32 location = glGetUniformLocation(_programId, name);
+        if (location < 0)
+            continue;
+        if (char* subscript = SDL_strstr(name, "[0]"))
+            *subscript = 0;
+        _uniformLocations.push_back({StringId::FromString(name), location});
+    }
+}
+
+void Shader::SetUniform(StringId name, const int& val)
 {
     glUniform1i(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::ivec2& val)
+void Shader::SetUniform(StringId name, const glm::ivec2& val)
 {
     glUniform2i(GetUniformLocation(name), val.x, val.y);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::ivec3& val)
+void Shader::SetUniform(StringId name, const glm::ivec3& val)
 {
     glUniform3i(GetUniformLocation(name), val.x, val.y, val.z);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::ivec4& val)
+void Shader::SetUniform(StringId name, const glm::ivec4& val)
 {
     glUniform4i(GetUniformLocation(name), val.x, val.y, val.z, val.w);
 }
 
-void Shader::SetUniform(std::string_view name, const float& val)
+void Shader::SetUniform(StringId name, const float& val)
 {
     glUniform1f(GetUniformLocation(name), val);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::vec2& val)
+void Shader::SetUniform(StringId name, const glm::vec2& val)
 {
     glUniform2f(GetUniformLocation(name), val.x, val.y);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::vec3& val)
+void Shader::SetUniform(StringId name, const glm::vec3& val)
 {
     glUniform3f(GetUniformLocation(name), val.x, val.y, val.z);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::vec4& val)
+void Shader::SetUniform(StringId name, const glm::vec4& val)
 {
     glUniform4f(GetUniformLocation(name), val.x, val.y, val.z, val.w);
 }
 
-void Shader::SetUniform(std::string_view name, const glm::mat4& val)
+void Shader::SetUniform(StringId name, const glm::mat4& val)
 {
     glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &val[0][0]);
 }
 
-s32 Shader::GetUniformLocation(std::string_view name)
+s32 Shader::GetUniformLocation(StringId name) const
 {
-    const s32 location = glGetUniformLocation(_programId, name.data());
-    return location;
+    // A handful per program, a scan beats hashing
+    for (const UniformLocation& uniform : _uniformLocations)
+    {
+        if (uniform.Name == name)
+            return uniform.Location;
+    }
+    return -1;
 }
 
 bool Shader::HasGeometryShader() const { return fs::exists(_geometryPath); }
@@ -6,8 +6,10 @@
 
 #pragma once
 #include <filesystem>
+#include <vector>
 #include "engine/Types.h"
 #include "math/GLMInclude.h"
+#include "platform/StringIdCRC32.h"
 
 namespace DG::graphics
 {
@@ -18,23 +20,31 @@ class Shader
     u32 GetProgramId() const { return _programId; }
     Shader(const char *shaderName);
 
-    void SetUniform(std::string_view, const int &);
-    void SetUniform(std::string_view, const glm::ivec2 &);
-    void SetUniform(std::string_view, const glm::ivec3 &);
-    void SetUniform(std::string_view, const glm::ivec4 &);
+    // Locations are looked up once per link, unknown names are ignored like GL does
+    void SetUniform(StringId, const int &);
+    void SetUniform(StringId, const glm::ivec2 &);
+    void SetUniform(StringId, const glm::ivec3 &);
+    void SetUniform(StringId, const glm::ivec4 &);
 
-    void SetUniform(std::string_view, const float &);
-    void SetUniform(std::string_view, const glm::vec2 &);
-    void SetUniform(std::string_view, const glm::vec3 &);
-    void SetUniform(std::string_view, const glm::vec4 &);
+    void SetUniform(StringId, const float &);
+    void SetUniform(StringId, const glm::vec2 &);
+    void SetUniform(StringId, const glm::vec3 &);
+    void SetUniform(StringId, const glm::vec4 &);
 
-    void SetUniform(std::string_view, const glm::mat4 &);
+    void SetUniform(StringId, const glm::mat4 &);
 
     void ReloadShader();
 
    protected:
    private:
-    s32 GetUniformLocation(std::string_view name);
+    struct UniformLocation
+    {
+        StringId Name;
+        s32 Location;
+    };
+
+    s32 GetUniformLocation(StringId name) const;
+    void CacheUniformLocations();
     bool HasGeometryShader() const;
 
     bool HasSourceChanged();
@@ -42,6 +52,7 @@ class Shader
     bool _isValid = false;
     bool _hasFiles = true;
     u32 _programId = 0;
+    std::vector<UniformLocation> _uniformLocations;
 
     std::experimental::filesystem::path _vertexPath;
     std::experimental::filesystem::path _fragmentPath;
@@ -0,0 +1,104 @@
+/**
+ *  @file    ShadowCascades.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "ShadowCascades.h"
+#include "engine/Camera.h"
+
+namespace DG::graphics
+{
+void FitShadowCascades(const Camera& camera, const vec3& lightDirection, const AABB& casters,
+                       const ShadowSettings& settings, ShadowCascade* cascades)
+{
+    // Slopes of the frustum edges, the projection is symmetric
+    const mat4& projection = camera.GetProjectionMatrix();
+    const f32 slopeX = 1.f / projection[0][0];
+    const f32 slopeY = 1.f / projection[1][1];
+    const mat4 inverseView = glm::inverse(camera.GetViewMatrix());
+    const f32 nearPlane = camera.GetNear();
+    const f32 farPlane = glm::max(glm::min(settings.Distance, camera.GetFar()), 2.f * nearPlane);
+    const f32 lambda = glm::clamp(settings.SplitLambda, 0.f, 1.f);
+
+    const mat4 lightView = glm::lookAt(-lightDirection, vec3(0.f), vec3(0.f, 1.f, 0.f));
+    const AABB lightCasters = TransformAABB(casters, lightView);
+    const f32 resolution = (f32)ShadowTileResolution;
+
+    f32 sliceNear = nearPlane;
+    for (u32 cascade = 0; cascade < ShadowCascadeCount; ++cascade)
+    {
+        // Practical split scheme, logarithmic near the camera and uniform further out
+        const f32 t = (f32)(cascade + 1) / (f32)ShadowCascadeCount;
+        const f32 sliceFar =
+            glm::mix(nearPlane + (farPlane - nearPlane) * t,
+                     nearPlane * glm::pow(farPlane / nearPlane, t), lambda);
+
+        // The radius of the bounding sphere doesn't change with the camera, rounding it up keeps
+        // float noise from changing the projection
+        vec3 corners[8];
+        vec3 center(0.f);
+        for (u32 i = 0; i < 8; ++i)
+        {
+            const f32 depth = i < 4 ? sliceNear : sliceFar;
+            const vec3 viewCorner((i & 1 ? 1.f : -1.f) * slopeX * depth,
+                                  (i & 2 ? 1.f : -1.f) * slopeY * depth, -depth);
+            corners[i] = vec3(inverseView * vec4(viewCorner, 1.f));
+            center += corners[i] * 0.125f;
+        }
+        f32 radius = 0.f;
+        for (const vec3& corner : corners) radius = glm::max(radius, glm::length(corner - center));
+        radius = glm::ceil(radius * 16.f) / 16.f;
+
+        // The extent leaves room for one snap step, which is one of its texels
+        const f32 snap = 2.f * radius / (resolution - 2.f);
+        const f32 extent = radius + snap;
+        vec3 lightCenter = vec3(lightView * vec4(center, 1.f));
+        lightCenter.x = glm::floor(lightCenter.x / snap) * snap;
+        lightCenter.y = glm::floor(lightCenter.y / snap) * snap;
+
+        // Casters between the light and the slice have to be in front of the near plane
+        const f32 zMax = glm::ceil(glm::max(lightCasters.Max.z, lightCenter.z + radius) / snap);
+        const f32 zMin = glm::floor(glm::min(lightCasters.Min.z, lightCenter.z - radius) / snap);
+
+        cascades[cascade].ViewProjection =
+            glm::ortho(lightCenter.x - extent, lightCenter.x + extent, lightCenter.y - extent,
+                       lightCenter.y + extent, -zMax * snap, -zMin * snap) *
+            lightView;
+        cascades[cascade].SplitFar = sliceFar;
+        cascades[cascade].IsCached = false;
+        sliceNear = sliceFar;
+    }
+}
+
+u64 HashShadowCaster(u32 model, const mat4& modelMatrix)
+{
+    // FNV-1a
+    u64 hash = 14695981039346656037ull;
+    auto hashBytes = [&hash](const void* data, u32 size) {
+        for (u32 i = 0; i < size; ++i)
+        {
+            hash ^= ((const u8*)data)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    hashBytes(&model, sizeof(model));
+    hashBytes(&modelMatrix, sizeof(modelMatrix));
+    return hash;
+}
+
+bool ShadowCascadeCache::Update(u32 cascade, const mat4& viewProjection, u64 signature)
+{
+    const bool isCached = _isValid[cascade] && _signatures[cascade] == signature &&
+                          _viewProjections[cascade] == viewProjection;
+    _viewProjections[cascade] = viewProjection;
+    _signatures[cascade] = signature;
+    _isValid[cascade] = true;
+    return isCached;
+}
+
+void ShadowCascadeCache::Invalidate()
+{
+    for (bool& isValid : _isValid) isValid = false;
+}
+}  // namespace DG::graphics
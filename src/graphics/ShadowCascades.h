@@ -0,0 +1,64 @@
+/**
+ *  @file    ShadowCascades.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include "engine/Types.h"
+#include "math/BoundingBox.h"
+
+namespace DG
+{
+class Camera;
+}
+
+namespace DG::graphics
+{
+enum : u32
+{
+    ShadowCascadeCount = 4,
+    // The cascades share a 2x2 atlas
+    ShadowTileResolution = 1024
+};
+
+// One slice of the camera frustum as seen from the directional light
+struct ShadowCascade
+{
+    mat4 ViewProjection;
+    f32 SplitFar;   // View depth where the next cascade takes over
+    bool IsCached;  // The atlas tile still holds these casters, no draws were recorded
+};
+
+struct ShadowSettings
+{
+    f32 Distance = 150.f;     // Nothing further from the camera receives shadows
+    f32 SplitLambda = 0.75f;  // 0 splits the distance uniformly, 1 logarithmically
+    // Skips tiles whose casters and projection didn't change, e.g. while the camera is idle
+    bool CacheStatic = true;
+};
+
+// Fits an orthographic light projection around the bounding sphere of every camera slice. The
+// projections only move in whole texels, so static casters land on the same texels frame after
+// frame.
+void FitShadowCascades(const Camera& camera, const vec3& lightDirection, const AABB& casters,
+                       const ShadowSettings& settings, ShadowCascade* cascades);
+
+// Summed over the casters of a cascade, the sum doesn't depend on the culling order
+u64 HashShadowCaster(u32 model, const mat4& modelMatrix);
+
+// What every atlas tile was last recorded with. Frames are rendered in order, so a tile still
+// holds what the last frame recording its cascade put there.
+class ShadowCascadeCache
+{
+   public:
+    // True if the tile can be kept, otherwise it is remembered as recorded now
+    bool Update(u32 cascade, const mat4& viewProjection, u64 signature);
+    void Invalidate();
+
+   private:
+    mat4 _viewProjections[ShadowCascadeCount];
+    u64 _signatures[ShadowCascadeCount];
+    bool _isValid[ShadowCascadeCount] = {};
+};
+}  // namespace DG::graphics
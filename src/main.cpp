@@ -12,20 +12,28 @@
 #include "components/StaticMeshComponent.h"
 #include "engine/Messaging.h"
 #include "engine/Types.h"
+#include "engine/TypeBenchmark.h"
+#include "engine/WorldBenchmark.h"
 #include "engine/WorldEditor.h"
+#include "engine/WorldFile.h"
 #include "graphics/FrameData.h"
+#include "graphics/GLCallCounter.h"
 #include "graphics/GameWorldWindow.h"
 #include "graphics/GraphicsSystem.h"
+#include "graphics/RenderBenchmark.h"
 #include "graphics/Renderer.h"
 #include "imgui/DG_Imgui.h"
 #include "imgui/imgui_dock.h"
 #include "imgui/imgui_impl_sdl_gl3.h"
 #include "memory/Memory.h"
+#include "memory/MemoryBenchmark.h"
 #include "physics/Physics.h"
 #include "platform/ConditionVariable.h"
 #include "platform/InputSystem.h"
 #include "platform/Job.h"
+#include "platform/JobBenchmark.h"
 #include "platform/SDLHelper.h"
+#include "platform/TaskGraph.h"
 #include "platform/StringIdCRC32.h"
 
 namespace DG
@@ -64,6 +72,10 @@ bool InitImgui()
 
 bool InitWorkerThreads()
 {
+#if DG_JOB_FIBERS
+    JobSystem::InitFibers(FiberConfig());
+#endif
+
     // Register Main Thread
     JobSystem::RegisterWorker();
 
@@ -77,26 +89,141 @@ bool InitWorkerThreads()
 
 bool InitMemory()
 {
-    // Grab a 1GB of memory
-    const u32 TotalMemorySize = 1 * 1024 * 1024 * 1024;  // 1 GB
-    // ToDo: Get rid of this!
-    u8* memory = (u8*)VirtualAlloc(0, TotalMemorySize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-    if (!memory)
+    // Only address space is reserved, pages get committed once the arenas grow into them
+    const u32 PersistentMemorySize = 256 * 1024 * 1024;  // 256 MB
+    const u32 TransientMemorySize = 1 * 1024 * 1024 * 1024;  // 1 GB
+    if (!Memory.PersistentMemory.InitVirtual(PersistentMemorySize) ||
+        !Memory.TransientMemory.InitVirtual(TransientMemorySize))
     {
-        SDL_LogError(0, "Couldn't allocate game memory.");
+        SDL_LogError(0, "Couldn't reserve game memory.");
         return false;
     }
 
-    // Assign 50 MB to Persistent, rest is transient
-    const u32 PersistentMemorySize = 50 * 1024 * 1024;  // 50 MB
-    Memory.PersistentMemory.Init(memory, PersistentMemorySize);
-
-    const u32 TransientMemorySize = TotalMemorySize - PersistentMemorySize;
-    Memory.TransientMemory.Init(memory + PersistentMemorySize, TransientMemorySize);
+    // Budgets are the sizes the arenas had before they could grow
+    Memory.PersistentMemory.SetMemoryTag(RegisterMemoryTag("Persistent", 50 * 1024 * 1024));
+    Memory.TransientMemory.SetMemoryTag(RegisterMemoryTag("Transient", 950 * 1024 * 1024));
 
     return true;
 }
 
+struct ArenaStats
+{
+    const char* Name;
+    u32 Reserved;
+    u32 Committed;
+    u32 HighWater;
+};
+
+template <typename Allocator>
+static ArenaStats GetArenaStats(const char* name, const Allocator& allocator)
+{
+    return ArenaStats{name, allocator.GetReservedSize(), allocator.GetCommittedSize(),
+                      allocator.GetHighWaterMark()};
+}
+
+static const u32 FrameDataCount = 5;
+static const char* FrameArenaNames[FrameDataCount] = {"Frame[0]", "Frame[1]", "Frame[2]",
+                                                      "Frame[3]", "Frame[4]"};
+
+static u32 GatherArenaStats(const graphics::FrameData* frames, ArenaStats* stats)
+{
+    u32 count = 0;
+    stats[count++] = GetArenaStats("Persistent", Memory.PersistentMemory);
+    stats[count++] = GetArenaStats("Transient", Memory.TransientMemory);
+    stats[count++] = GetArenaStats("PlayMode", Game->PlayModeStack);
+    stats[count++] = GetArenaStats("Render", Game->RenderState->RenderMemory);
+    for (u32 i = 0; i < FrameDataCount; ++i)
+        stats[count++] = GetArenaStats(FrameArenaNames[i], frames[i].FrameMemory);
+    return count;
+}
+
+static void LogArenaStats(const graphics::FrameData* frames)
+{
+    ArenaStats stats[4 + FrameDataCount];
+    const u32 count = GatherArenaStats(frames, stats);
+    SDL_Log("Memory arenas (KB): reserved, committed, high-water");
+    for (u32 i = 0; i < count; ++i)
+    {
+        SDL_Log("  %-10s %8u %8u %8u", stats[i].Name, stats[i].Reserved / 1024,
+                stats[i].Committed / 1024, stats[i].HighWater / 1024);
+    }
+}
+
+static void AddArenaStatsWindow(const graphics::FrameData* frames, bool* isOpen)
+{
+    if (!ImGui::Begin("Memory Arenas", isOpen))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ArenaStats stats[4 + FrameDataCount];
+    const u32 count = GatherArenaStats(frames, stats);
+    ImGui::Columns(4);
+    ImGui::Text("Arena");
+    ImGui::NextColumn();
+    ImGui::Text("Reserved KB");
+    ImGui::NextColumn();
+    ImGui::Text("Committed KB");
+    ImGui::NextColumn();
+    ImGui::Text("High-water KB");
+    ImGui::NextColumn();
+    ImGui::Separator();
+    for (u32 i = 0; i < count; ++i)
+    {
+        ImGui::Text("%s", stats[i].Name);
+        ImGui::NextColumn();
+        ImGui::Text("%u", stats[i].Reserved / 1024);
+        ImGui::NextColumn();
+        ImGui::Text("%u", stats[i].Committed / 1024);
+        ImGui::NextColumn();
+        ImGui::Text("%u", stats[i].HighWater / 1024);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+#if DG_MEMORY_TRACKING
+    ImGui::Spacing();
+    if (ImGui::Button("Dump to memory_stats.json"))
+        DumpMemoryStatsToJson("memory_stats.json");
+
+    ImGui::Columns(6);
+    ImGui::Text("Tag");
+    ImGui::NextColumn();
+    ImGui::Text("Live KB");
+    ImGui::NextColumn();
+    ImGui::Text("Peak KB");
+    ImGui::NextColumn();
+    ImGui::Text("Budget KB");
+    ImGui::NextColumn();
+    ImGui::Text("Allocs/Frame");
+    ImGui::NextColumn();
+    ImGui::Text("Overruns");
+    ImGui::NextColumn();
+    ImGui::Separator();
+    const u32 tagCount = GetMemoryTagCount();
+    for (u32 i = 1; i < tagCount; ++i)
+    {
+        MemoryTagStats tag;
+        GetMemoryTagStats((MemoryTag)i, &tag);
+        ImGui::Text("%s", tag.Name);
+        ImGui::NextColumn();
+        ImGui::Text("%lld", (long long)(tag.LiveBytes / 1024));
+        ImGui::NextColumn();
+        ImGui::Text("%lld", (long long)(tag.PeakBytes / 1024));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long)(tag.Budget / 1024));
+        ImGui::NextColumn();
+        ImGui::Text("%u (%u)", tag.LastFrameAllocations, tag.PeakFrameAllocations);
+        ImGui::NextColumn();
+        ImGui::Text("%u", tag.BudgetOverruns);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+#endif
+    ImGui::End();
+}
+
 void Cleanup()
 {
     // PhysX Cleanup
@@ -121,7 +248,7 @@ u64 GetFrameBufferIndex(u64 frameIndex, u64 size)
 }
 
 template <typename T>
-void CopyImVector(ImVector<T>* dest, ImVector<T>* src, StackAllocator& allocator)
+void CopyImVector(ImVector<T>* dest, ImVector<T>* src, FrameAllocator& allocator)
 {
     dest->Size = src->Size;
     dest->Capacity = src->Capacity;
@@ -131,6 +258,427 @@ void CopyImVector(ImVector<T>* dest, ImVector<T>* src, StackAllocator& allocator
     memcpy(dest->Data, src->Data, memSize);
 }
 
+// Everything the frame graph stages share, set up once per frame before the graph runs
+struct FrameContext
+{
+    graphics::FrameData* Frames;
+    graphics::FrameData* CurrentFrameData;
+    graphics::FrameData* PreviousFrameData;
+    graphics::GameWorldWindow* MainGameWindow;
+    u64 CurrentTime;
+    f32 CpuFrequency;
+    f32 DtSeconds;
+    bool IsDumpFrameGraphRequested;
+    bool IsArenaStatsVisible;
+};
+
+// What the frame graph stages read and write, one bit each
+struct FrameResource
+{
+    enum : u64
+    {
+        Input = 1 << 0,
+        Clocks = 1 << 1,
+        ImGuiState = 1 << 2,
+        Messages = 1 << 3,
+        World = 1 << 4,
+        Physics = 1 << 5,
+        ImGuiDrawData = 1 << 6,
+        RenderCommands = 1 << 7,
+        All = ~0ull
+    };
+};
+
+static void UpdateInputStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+
+    // Poll Events and Update Input accordingly
+    Game->RawInputSystem->Update();
+
+    // Measure time and update clocks!
+    const u64 lastTime = context->CurrentTime;
+    context->CurrentTime = SDL_GetPerformanceCounter();
+    f32 dtSeconds = (f32)(context->CurrentTime - lastTime) / context->CpuFrequency;
+
+    // This usually happens once we hit a breakpoint when debugging
+    if (dtSeconds > 0.25f)
+        dtSeconds = 1.0f / TargetFrameRate;
+
+    // Update Clocks
+    g_RealTimeClock.Update(dtSeconds);
+    g_EditingClock.Update(dtSeconds);
+    g_InGameClock.Update(dtSeconds);
+    context->DtSeconds = dtSeconds;
+}
+
+static void BeginImGuiStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+    graphics::GameWorldWindow& mainGameWindow = *context->MainGameWindow;
+
+    // Imgui
+    ImGui_ImplSdlGL3_NewFrame(Game->RenderState->Window);
+    ImGuizmo::BeginFrame();
+    ImVec2 mainBarSize;
+
+    // Main Menu Bar
+    if (ImGui::BeginMainMenuBar())
+    {
+        mainBarSize = ImGui::GetWindowSize();
+        if (ImGui::BeginMenu("File"))
+        {
+            if (ImGui::MenuItem("Save layout"))
+            {
+                ImGui::SaveDock();
+            }
+
+            if (ImGui::MenuItem("Save level to level.dgworld"))
+            {
+                Game->WorldEdit->GetWorld()->SaveToFile("level.dgworld");
+            }
+
+            if (ImGui::MenuItem("Export level.dgworld to level.json"))
+            {
+                ExportWorldFileToJson("level.dgworld", "level.json");
+            }
+
+            if (ImGui::MenuItem("Exit"))
+            {
+                Game->RawInputSystem->RequestClose();
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Shader"))
+        {
+            if (ImGui::MenuItem("Reload changed shaders"))
+            {
+                auto it = g_Managers->ShaderManager->begin();
+                auto end = g_Managers->ShaderManager->end();
+                while (it != end)
+                {
+                    it->ReloadShader();
+                    ++it;
+                }
+            }
+            ImGui::EndMenu();
+        }
+
+        if (ImGui::BeginMenu("Debug"))
+        {
+            if (ImGui::MenuItem("Dump frame graph"))
+            {
+                context->IsDumpFrameGraphRequested = true;
+            }
+            ImGui::MenuItem("Memory arenas", nullptr, &context->IsArenaStatsVisible);
+            if (ImGui::MenuItem("Defragment components"))
+            {
+                Game->ActiveWorld->DefragmentComponents();
+            }
+            ImGui::EndMenu();
+        }
+
+        if (Game->Mode == GameState::GameMode::EditMode)
+        {
+            if (ImGui::MenuItem("Start Playmode"))
+            {
+                Game->Mode = GameState::GameMode::PlayMode;
+                g_EditingClock.SetPaused(true);
+                g_InGameClock.SetPaused(false);
+
+                // Cleanup PlayMode stack
+                Game->PlayModeStack.Reset();
+                GameWorld* editWorld = Game->WorldEdit->GetWorld();
+                const s32 worldSize = editWorld->GetMemorySize();
+                Game->ActiveWorld = Game->PlayModeStack.PushAndConstruct<GameWorld>();
+                Game->ActiveWorld->Startup(Game->PlayModeStack.Push(worldSize, 16), worldSize);
+
+                // Copy World from Edit mode over
+                editWorld->CloneInto(Game->ActiveWorld);
+            }
+        }
+        else if (Game->Mode == GameState::GameMode::PlayMode)
+        {
+            if (ImGui::MenuItem("Stop Playmode"))
+            {
+                Game->Mode = GameState::GameMode::EditMode;
+                g_EditingClock.SetPaused(false);
+                g_InGameClock.SetPaused(true);
+
+                Game->ActiveWorld->Shutdown();
+                Game->ActiveWorld->~GameWorld();
+                Game->ActiveWorld = Game->WorldEdit->GetWorld();
+            }
+        }
+
+        if (ImGui::MenuItem("Spawn Duck Actor"))
+        {
+            auto actor = Game->ActiveWorld->CreateActor<Actor>();
+            auto staticMesh =
+                actor->RegisterComponent<StaticMeshComponent>("DuckModel", Transform());
+
+            /*std::ofstream o("pretty.json");
+            nlohmann::json j;
+            actor->Serialize(j);
+            o << std::setw(4) << j << std::endl;*/
+        }
+
+        // Shift all the way to the right
+        ImGui::SameLine(ImGui::GetWindowWidth() - 200);
+        ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
+                    ImGui::GetIO().Framerate);
+
+        ImGui::EndMainMenuBar();
+    }
+
+    // Create Main Window
+    vec2 adjustedDisplaySize = ImGui::GetIO().DisplaySize;
+    adjustedDisplaySize.y -= mainBarSize.y;
+    ImGui::SetNextWindowPos(ImVec2(0, mainBarSize.y));
+    ImGui::SetNextWindowSize(adjustedDisplaySize, ImGuiCond_Always);
+    bool isContentVisible =
+        ImGui::Begin("###content", 0,
+                     ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse |
+                         ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
+                         ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse |
+                         ImGuiWindowFlags_NoBringToFrontOnFocus |
+                         ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoInputs);
+    Assert(isContentVisible);
+
+    ImGui::BeginDockspace();
+
+    // Imgui Window for MainViewport
+    mainGameWindow.AddToImgui();
+}
+
+static void UpdateMessagingStage(void*) { g_MessagingSystem.Update(); }
+
+static void UpdateWorldStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+    context->MainGameWindow->Update(context->DtSeconds);  // Also updates the world
+}
+
+static void UpdateWorldEditStage(void*) { Game->WorldEdit->Update(); }
+
+static void EndImGuiStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+    if (context->IsArenaStatsVisible)
+        AddArenaStatsWindow(context->Frames, &context->IsArenaStatsVisible);
+
+    AddImguiTweakers();
+
+    ImGui::EndDockspace();
+    ImGui::End();
+    ImGui::Render();  // Just generates statements to be rendered, doesnt actually render!
+}
+
+static void CopyImGuiDrawDataStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+    graphics::FrameData& currentFrameData = *context->CurrentFrameData;
+
+    // Copying imgui render data to context
+    ImDrawData* drawData = currentFrameData.FrameMemory.Push<ImDrawData>();
+    *drawData = *ImGui::GetDrawData();
+    ImDrawList** newList =
+        currentFrameData.FrameMemory.Push<ImDrawList*>(drawData->CmdListsCount);
+
+    // Create copies of cmd lists
+    for (int i = 0; i < drawData->CmdListsCount; ++i)
+    {
+        // Copy this list!
+        ImDrawList* drawList = drawData->CmdLists[i];
+        newList[i] = currentFrameData.FrameMemory.PushZeroed<ImDrawList>();
+        ImDrawList* copiedDrawList = newList[i];
+
+        // Create copies of
+        copiedDrawList->CmdBuffer = ImVector<ImDrawCmd>();
+        CopyImVector<ImDrawCmd>(&copiedDrawList->CmdBuffer, &drawList->CmdBuffer,
+                                currentFrameData.FrameMemory);
+
+        copiedDrawList->IdxBuffer = ImVector<ImDrawIdx>();
+        CopyImVector<ImDrawIdx>(&copiedDrawList->IdxBuffer, &drawList->IdxBuffer,
+                                currentFrameData.FrameMemory);
+
+        copiedDrawList->VtxBuffer = ImVector<ImDrawVert>();
+        CopyImVector<ImDrawVert>(&copiedDrawList->VtxBuffer, &drawList->VtxBuffer,
+                                 currentFrameData.FrameMemory);
+    }
+
+    drawData->CmdLists = newList;
+
+    // Set Imgui Render Data
+    currentFrameData.ImOverlayDrawData = drawData;
+}
+
+// Static meshes the tree finds in the frustum of one view
+struct VisibleMeshes
+{
+    mat4 ViewProjection;
+    const StaticMeshComponent** Meshes;  // Room for every proxy of the tree
+    graphics::GraphicsModel** Models;
+    u32 Count;
+};
+
+static void QueryVisibleMeshes(const GameWorld& world, VisibleMeshes* view)
+{
+    world.QueryFrustum(ExtractFrustum(view->ViewProjection), [&](Handle<SceneComponent> handle) {
+        const SceneComponent* component = world.Resolve(handle);
+        if (!component || !component->IsTypeOrDerivedType<StaticMeshComponent>())
+            return;
+        const StaticMeshComponent* staticMesh = (const StaticMeshComponent*)component;
+        graphics::GraphicsModel* model =
+            g_Managers->ModelManager->Exists(staticMesh->GetRenderable());
+        Assert(model);
+        view->Meshes[view->Count] = staticMesh;
+        view->Models[view->Count++] = model;
+    });
+}
+
+static void GatherActorsStage(void* userData)
+{
+    static vec3 lightDirection(0.1f, -1.f, 0.f);
+    static graphics::ShadowSettings shadowSettings;
+    static graphics::ShadowCascadeCache shadowCache;
+    TWEAKER(F3, "Light Direction", &lightDirection);
+    TWEAKER_CAT("Shadows", F1, "Distance", &shadowSettings.Distance);
+    TWEAKER_CAT("Shadows", F1, "Split Lambda", &shadowSettings.SplitLambda);
+    TWEAKER_CAT("Shadows", CB, "Cache Static", &shadowSettings.CacheStatic);
+
+    FrameContext* context = (FrameContext*)userData;
+    FrameAllocator& frameMemory = context->CurrentFrameData->FrameMemory;
+    graphics::RenderContext* renderContext =
+        context->CurrentFrameData->WorldRenderData[0]->RenderCTX;
+    graphics::RenderCommandBuffer* commands = renderContext->GetCommands();
+    typedef graphics::RenderCommandBuffer Buffer;
+
+    // The root of the spatial tree encloses every caster, the light has to see all of them
+    const GameWorld* world = Game->ActiveWorld;
+    AABB casters = {vec3(0.f), vec3(0.f)};
+    world->GetSpatialTree().GetRootAABB(&casters);
+
+    // The render thread fits the projection to the window the same way
+    Camera camera = *Game->ActiveWorld->GetActiveCamera();
+    const vec2 windowSize = context->MainGameWindow->GetSize();
+    if (windowSize.x > 0.f && windowSize.y > 0.f)
+        camera.UpdateProjection(windowSize.x, windowSize.y);
+
+    renderContext->LightDirection = lightDirection;
+    graphics::ShadowCascade* cascades = renderContext->Cascades;
+    graphics::FitShadowCascades(camera, lightDirection, casters, shadowSettings, cascades);
+
+    // The camera first, then a view per cascade. Each one walks the tree on its own.
+    const u32 capacity = world->GetSpatialTree().GetProxyCount();
+    const u32 viewCount = 1 + graphics::ShadowCascadeCount;
+    VisibleMeshes views[viewCount];
+    views[0].ViewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+    for (u32 cascade = 0; cascade < graphics::ShadowCascadeCount; ++cascade)
+        views[1 + cascade].ViewProjection = cascades[cascade].ViewProjection;
+    for (VisibleMeshes& view : views)
+    {
+        view.Meshes = frameMemory.Push<const StaticMeshComponent*>(capacity);
+        view.Models = frameMemory.Push<graphics::GraphicsModel*>(capacity);
+        view.Count = 0;
+    }
+    JobSystem::ParallelFor(viewCount, 1, [&](u32 v) { QueryVisibleMeshes(*world, &views[v]); });
+
+    // Front to back, depth along the view direction
+    const vec3 eye = camera.GetPosition();
+    const vec3 forward = camera.GetForward();
+    for (u32 i = 0; i < views[0].Count; ++i)
+    {
+        const graphics::GraphicsModel* model = views[0].Models[i];
+        const mat4& modelMatrix = views[0].Meshes[i]->GetGlobalModelMatrix();
+        const f32 depth = glm::dot(vec3(modelMatrix[3]) - eye, forward);
+        // Models have no materials yet, their id keeps the draws of a model together
+        const u32 material = model->id.GetHash();
+        for (const graphics::Mesh& mesh : model->meshes)
+        {
+            graphics::RenderCommand* draw = commands->Add(
+                Buffer::MakeKey(graphics::RenderPass::Opaque, model->shader.GetProgramId(),
+                                material, mesh.vao, depth));
+            draw->ModelMatrix = modelMatrix;
+            draw->Mesh = &mesh;
+            draw->Shader = &model->shader;
+        }
+    }
+
+    // Cascades whose casters and projection didn't change keep their tile. Every frame gets
+    // rendered in order, the tile holds what the cache saw last.
+    const bool isCaching = shadowSettings.CacheStatic;
+    if (!isCaching)
+        shadowCache.Invalidate();
+    for (u32 cascade = 0; cascade < graphics::ShadowCascadeCount; ++cascade)
+    {
+        const VisibleMeshes& view = views[1 + cascade];
+        if (isCaching)
+        {
+            u64 signature = view.Count;
+            for (u32 i = 0; i < view.Count; ++i)
+                signature += graphics::HashShadowCaster(view.Models[i]->id.GetHash(),
+                                                        view.Meshes[i]->GetGlobalModelMatrix());
+            cascades[cascade].IsCached =
+                shadowCache.Update(cascade, cascades[cascade].ViewProjection, signature);
+            if (cascades[cascade].IsCached)
+                continue;
+        }
+
+        // The shadow pass has one shader, the cascade takes its place in the key
+        for (u32 i = 0; i < view.Count; ++i)
+        {
+            for (const graphics::Mesh& mesh : view.Models[i]->meshes)
+            {
+                graphics::RenderCommand* shadow = commands->Add(
+                    Buffer::MakeKey(graphics::RenderPass::Shadow, cascade, 0, mesh.vao, 0.f));
+                shadow->ModelMatrix = view.Meshes[i]->GetGlobalModelMatrix();
+                shadow->Mesh = &mesh;
+                shadow->Shader = nullptr;
+            }
+        }
+    }
+    commands->Sort();
+}
+
+static void RenderHandoffStage(void* userData)
+{
+    FrameContext* context = (FrameContext*)userData;
+    graphics::FrameData& currentFrameData = *context->CurrentFrameData;
+    currentFrameData.WorldRenderData[0]->Window = context->MainGameWindow;
+    currentFrameData.IsPreRenderDone = true;
+
+    context->PreviousFrameData->RenderDone.WaitAndReset();
+
+    Game->RenderState->FrameDataToRender = &currentFrameData;
+    Game->RenderState->RenderCondition.Signal();
+    currentFrameData.DoubleBufferDone.WaitAndReset();
+}
+
+// Stages touching SDL or ImGui stay on the main thread and are serialized through ImGuiState.
+// The ImGui copy and the actor gather only depend on those and overlap each other.
+void BuildFrameGraph(TaskGraph& graph)
+{
+    typedef FrameResource R;
+    graph.AddTask("Input", UpdateInputStage, 0, R::Input | R::Clocks, TaskGraph::MainThread);
+    graph.AddTask("BeginImGui", BeginImGuiStage, R::Input | R::Clocks, R::ImGuiState | R::World,
+                  TaskGraph::MainThread);
+    graph.AddTask("Messaging", UpdateMessagingStage, R::Input | R::Clocks,
+                  R::Messages | R::ImGuiState, TaskGraph::MainThread);
+    graph.AddTask("UpdateWorld", UpdateWorldStage, R::Input | R::Clocks | R::Messages,
+                  R::World | R::Physics | R::ImGuiState, TaskGraph::MainThread);
+    graph.AddTask("UpdateWorldEdit", UpdateWorldEditStage, R::Messages, R::World | R::ImGuiState,
+                  TaskGraph::MainThread);
+    graph.AddTask("EndImGui", EndImGuiStage, 0, R::ImGuiState | R::World, TaskGraph::MainThread);
+    graph.AddTask("CopyImGuiDrawData", CopyImGuiDrawDataStage, R::ImGuiState, R::ImGuiDrawData);
+    graph.AddTask("GatherActors", GatherActorsStage, R::World | R::Physics, R::RenderCommands);
+
+    // Sink, reads everything the frame produced
+    graph.AddTask("RenderHandoff", RenderHandoffStage, R::All, R::ImGuiDrawData | R::RenderCommands,
+                  TaskGraph::MainThread);
+    graph.Build();
+}
+
 }  // namespace DG
 
 int main(int, char* [])
@@ -146,6 +694,25 @@ int main(int, char* [])
     if (!InitWorkerThreads())
         return -1;
 
+#if DG_JOB_BENCHMARK
+    RunJobStressTest();
+    RunBackgroundWaitTest();
+    RunParallelForBenchmark();
+    RunNestedWaitBenchmark();
+    RunPriorityStressTest();
+#endif
+#if DG_MEMORY_BENCHMARK
+    RunFrameAllocatorBenchmark();
+    RunPoolAllocatorBenchmark();
+#endif
+#if DG_TYPE_BENCHMARK
+    RunTypeCheckBenchmark();
+#endif
+#if DG_RENDER_BENCHMARK
+    RunRenderCommandBenchmark();
+    RunCullingBenchmark();
+#endif
+
     InitClocks();
 
     // Initialize Resource Managers
@@ -156,10 +723,12 @@ int main(int, char* [])
     g_Managers->ShaderManager = Memory.TransientMemory.PushAndConstruct<graphics::ShaderManager>();
 
     // Initialize Game
-    const u32 playModeSize = 4 * 1024 * 1024;  // 4MB
+    const u32 playModeSize = 256 * 1024 * 1024;      // 256MB reserved
+    const u32 renderMemorySize = 256 * 1024 * 1024;  // 256MB reserved
     Game = Memory.PersistentMemory.Push<GameState>();
     Game->GameIsRunning = true;
-    Game->PlayModeStack.Init(Memory.TransientMemory.Push(playModeSize, 4), playModeSize);
+    Game->PlayModeStack.InitVirtual(playModeSize);
+    Game->PlayModeStack.SetMemoryTag(RegisterMemoryTag("PlayMode", 4 * 1024 * 1024));
     Game->RawInputSystem = Memory.TransientMemory.PushAndConstruct<RawInputSystem>();
 
     // Init Messaging
@@ -168,8 +737,8 @@ int main(int, char* [])
 
     // Init RenderState
     Game->RenderState = Memory.TransientMemory.PushAndConstruct<graphics::RenderState>();
-    Game->RenderState->RenderMemory.Init(Memory.TransientMemory.Push(playModeSize, 4),
-                                         playModeSize);
+    Game->RenderState->RenderMemory.InitVirtual(renderMemorySize);
+    Game->RenderState->RenderMemory.SetMemoryTag(RegisterMemoryTag("Render", 4 * 1024 * 1024));
 
     // Create Window on main thread
     if (!InitWindow())
@@ -185,23 +754,32 @@ int main(int, char* [])
     if (!InitPhysics())
         return -1;
 
+#if DG_WORLD_BENCHMARK
+    RunWorldIterationBenchmark();
+    RunTransformHierarchyBenchmark();
+    RunCommandBufferBenchmark();
+    RunWorldCloneBenchmark();
+    RunWorldFileBenchmark();
+    RunSpatialTreeBenchmark();
+#endif
+
     Game->WorldEdit = Memory.TransientMemory.PushAndConstruct<WorldEdit>();
     Game->WorldEdit->Startup(&Memory.TransientMemory);
     Game->ActiveWorld = Game->WorldEdit->GetWorld();
 
     AttachDebugListenersToMessageSystem();
 
-    u64 currentTime = SDL_GetPerformanceCounter();
-    f32 cpuFrequency = (f32)(SDL_GetPerformanceFrequency());
-
     // Init FrameRingBuffer
-    graphics::FrameData* frames = Memory.TransientMemory.Push<graphics::FrameData>(5);
+    graphics::FrameData* frames =
+        Memory.TransientMemory.Push<graphics::FrameData>(FrameDataCount);
 
-    for (int i = 0; i < 5; ++i)
+    for (u32 i = 0; i < FrameDataCount; ++i)
     {
-        const u32 frameDataSize = 16 * 1024 * 1024;  // 16MB
-        u8* base = Memory.TransientMemory.Push(frameDataSize, 4);
-        frames[i].FrameMemory.Init(base, frameDataSize);
+        // Big and touched every frame, huge pages save most of the TLB misses
+        const u32 frameDataSize = 256 * 1024 * 1024;  // 256MB reserved
+        frames[i].FrameMemory.InitVirtual(frameDataSize, true);
+        frames[i].FrameMemory.SetMemoryTag(
+            RegisterMemoryTag(FrameArenaNames[i], 16 * 1024 * 1024));
         frames[i].Reset();
         frames[i].IsPreRenderDone = true;
         frames[i].RenderDone.Create();
@@ -209,7 +787,7 @@ int main(int, char* [])
     }
 
     // Signal once, this opens the gate for the first frame to pass!
-    frames[4].RenderDone.Signal();
+    frames[FrameDataCount - 1].RenderDone.Signal();
 
     // Stop clocks depending on edit mode
     if (Game->Mode == GameState::GameMode::EditMode)
@@ -221,16 +799,67 @@ int main(int, char* [])
     graphics::GameWorldWindow mainGameWindow;
     mainGameWindow.Initialize("EditWindow", Game->WorldEdit->GetWorld());
 
+    // Built once, replayed every frame
+    TaskGraph frameGraph;
+    BuildFrameGraph(frameGraph);
+
+    FrameContext frameContext = {};
+    frameContext.Frames = frames;
+    frameContext.MainGameWindow = &mainGameWindow;
+    frameContext.CurrentTime = SDL_GetPerformanceCounter();
+    frameContext.CpuFrequency = (f32)(SDL_GetPerformanceFrequency());
+
+    JobStats lastJobStats = JobSystem::GetStats();
     while (!Game->RawInputSystem->IsQuitRequested())
     {
         static bool isWireframe = false;
         TWEAKER_CAT("OpenGL", CB, "Wireframe", &isWireframe);
 
+        // Job system counters of the last frame
+        {
+            const JobStats jobStats = JobSystem::GetStats();
+            static s32 wakeUps;
+            static s32 stealAttempts;
+            static f32 stealSuccessRate;
+            wakeUps = (s32)(jobStats.WakeUps - lastJobStats.WakeUps);
+            stealAttempts = (s32)(jobStats.StealAttempts - lastJobStats.StealAttempts);
+            const u32 stealSuccesses = jobStats.StealSuccesses - lastJobStats.StealSuccesses;
+            stealSuccessRate = stealAttempts ? (f32)stealSuccesses / (f32)stealAttempts : 0.0f;
+            lastJobStats = jobStats;
+
+            TWEAKER_FRAME_CAT("Jobs", S1, "Wake-ups", &wakeUps);
+            TWEAKER_FRAME_CAT("Jobs", S1, "Steal attempts", &stealAttempts);
+            TWEAKER_FRAME_CAT("Jobs", F1, "Steal success rate", &stealSuccessRate);
+        }
+
+        // Renderer counters of the last rendered frame
+        {
+            const graphics::RenderStats renderStats = Game->RenderState->GraphicsSystem->GetStats();
+            static s32 drawCalls;
+            static s32 instances;
+            static f32 submitMs;
+            static s32 shadowCascades;
+            drawCalls = (s32)renderStats.DrawCalls;
+            instances = (s32)renderStats.Instances;
+            submitMs = renderStats.SubmitMs;
+            shadowCascades = (s32)renderStats.ShadowCascades;
+
+            TWEAKER_FRAME_CAT("Render", S1, "Draw calls", &drawCalls);
+            TWEAKER_FRAME_CAT("Render", S1, "Instances", &instances);
+            TWEAKER_FRAME_CAT("Render", F1, "Submit ms", &submitMs);
+#if DG_GL_CALL_COUNTER
+            static s32 glCalls;
+            glCalls = (s32)renderStats.GLCalls;
+            TWEAKER_FRAME_CAT("Render", S1, "GL calls", &glCalls);
+#endif
+            TWEAKER_FRAME_CAT("Render", S1, "Shadow cascades", &shadowCascades);
+        }
+
         // Frame Data Setup
         graphics::FrameData& previousFrameData =
-            frames[GetFrameBufferIndex(Game->CurrentFrameIdx - 1, 5)];
+            frames[GetFrameBufferIndex(Game->CurrentFrameIdx - 1, FrameDataCount)];
         graphics::FrameData& currentFrameData =
-            frames[GetFrameBufferIndex(Game->CurrentFrameIdx, 5)];
+            frames[GetFrameBufferIndex(Game->CurrentFrameIdx, FrameDataCount)];
         currentFrameData.Reset();
 
         // For now assume one world only
@@ -241,224 +870,32 @@ int main(int, char* [])
         currentFrameData.WorldRenderData[0] =
             currentFrameData.FrameMemory.PushAndConstruct<graphics::WorldRenderData>();
         currentFrameData.WorldRenderData[0]->RenderCTX =
-            currentFrameData.FrameMemory.PushAndConstruct<graphics::RenderContext>();
+            currentFrameData.FrameMemory.PushAndConstruct<graphics::RenderContext>(
+                &currentFrameData.FrameMemory);
         currentFrameData.WorldRenderData[0]->DebugRenderCTX =
             currentFrameData.FrameMemory.PushAndConstruct<graphics::DebugRenderContext>();
 
         graphics::g_DebugRenderContext = currentFrameData.WorldRenderData[0]->DebugRenderCTX;
         currentFrameData.WorldRenderData[0]->RenderCTX->IsWireframe = isWireframe;
 
-        // Update Phase!
-        {
-            // Poll Events and Update Input accordingly
-            Game->RawInputSystem->Update();
-
-            // Measure time and update clocks!
-            const u64 lastTime = currentTime;
-            currentTime = SDL_GetPerformanceCounter();
-            f32 dtSeconds = (f32)(currentTime - lastTime) / cpuFrequency;
-
-            // This usually happens once we hit a breakpoint when debugging
-            if (dtSeconds > 0.25f)
-                dtSeconds = 1.0f / TargetFrameRate;
-
-            // Update Clocks
-            g_RealTimeClock.Update(dtSeconds);
-            g_EditingClock.Update(dtSeconds);
-            g_InGameClock.Update(dtSeconds);
-
-            // Imgui
-            ImGui_ImplSdlGL3_NewFrame(Game->RenderState->Window);
-            ImGuizmo::BeginFrame();
-            ImVec2 mainBarSize;
-
-            // Main Menu Bar
-            if (ImGui::BeginMainMenuBar())
-            {
-                mainBarSize = ImGui::GetWindowSize();
-                if (ImGui::BeginMenu("File"))
-                {
-                    if (ImGui::MenuItem("Save layout"))
-                    {
-                        ImGui::SaveDock();
-                    }
-
-                    if (ImGui::MenuItem("Exit"))
-                    {
-                        Game->RawInputSystem->RequestClose();
-                    }
-                    ImGui::EndMenu();
-                }
-                if (ImGui::BeginMenu("Shader"))
-                {
-                    if (ImGui::MenuItem("Reload changed shaders"))
-                    {
-                        auto it = g_Managers->ShaderManager->begin();
-                        auto end = g_Managers->ShaderManager->end();
-                        while (it != end)
-                        {
-                            it->ReloadShader();
-                            ++it;
-                        }
-                    }
-                    ImGui::EndMenu();
-                }
-
-                if (Game->Mode == GameState::GameMode::EditMode)
-                {
-                    if (ImGui::MenuItem("Start Playmode"))
-                    {
-                        Game->Mode = GameState::GameMode::PlayMode;
-                        g_EditingClock.SetPaused(true);
-                        g_InGameClock.SetPaused(false);
-
-                        // Cleanup PlayMode stack
-                        Game->PlayModeStack.Reset();
-                        Game->ActiveWorld = Game->PlayModeStack.Push<GameWorld>();
-
-                        // Copy World from Edit mode over
-                        // CopyGameWorld(Game->ActiveWorld, Game->WorldEdit->GetWorld());
-                    }
-                }
-                else if (Game->Mode == GameState::GameMode::PlayMode)
-                {
-                    if (ImGui::MenuItem("Stop Playmode"))
-                    {
-                        Game->Mode = GameState::GameMode::EditMode;
-                        g_EditingClock.SetPaused(false);
-                        g_InGameClock.SetPaused(true);
-
-                        Game->ActiveWorld->Shutdown();
-                        Game->ActiveWorld->~GameWorld();
-                        Game->ActiveWorld = Game->WorldEdit->GetWorld();
-                    }
-                }
-
-                if (ImGui::MenuItem("Spawn Duck Actor"))
-                {
-                    auto actor = Game->ActiveWorld->CreateActor<Actor>();
-                    auto staticMesh =
-                        actor->RegisterComponent<StaticMeshComponent>("DuckModel", Transform());
-
-                    /*std::ofstream o("pretty.json");
-                    nlohmann::json j;
-                    actor->Serialize(j);
-                    o << std::setw(4) << j << std::endl;*/
-                }
-
-                // Shift all the way to the right
-                ImGui::SameLine(ImGui::GetWindowWidth() - 200);
-                ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
-                            ImGui::GetIO().Framerate);
-
-                ImGui::EndMainMenuBar();
-            }
+        frameContext.CurrentFrameData = &currentFrameData;
+        frameContext.PreviousFrameData = &previousFrameData;
 
-            // Create Main Window
-            vec2 adjustedDisplaySize = ImGui::GetIO().DisplaySize;
-            adjustedDisplaySize.y -= mainBarSize.y;
-            ImGui::SetNextWindowPos(ImVec2(0, mainBarSize.y));
-            ImGui::SetNextWindowSize(adjustedDisplaySize, ImGuiCond_Always);
-            bool isContentVisible =
-                ImGui::Begin("###content", 0,
-                             ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse |
-                                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
-                                 ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse |
-                                 ImGuiWindowFlags_NoBringToFrontOnFocus |
-                                 ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoInputs);
-            Assert(isContentVisible);
-
-            ImGui::BeginDockspace();
-
-            // Imgui Window for MainViewport
-            mainGameWindow.AddToImgui();
-
-            // Game Logic
-            g_MessagingSystem.Update();
-            mainGameWindow.Update(dtSeconds);  // Also updates the world
-            Game->WorldEdit->Update();
-
-            AddImguiTweakers();
-
-            ImGui::EndDockspace();
-            ImGui::End();
-            ImGui::Render();  // Just generates statements to be rendered, doesnt actually render!
-        }
+        // Update, PreRender and the hand-off to the render thread
+        frameGraph.Execute(&frameContext);
 
-        // PreRender Phase!
+        if (frameContext.IsDumpFrameGraphRequested)
         {
-            // Copying imgui render data to context
-            ImDrawData* drawData = currentFrameData.FrameMemory.Push<ImDrawData>();
-            *drawData = *ImGui::GetDrawData();
-            ImDrawList** newList =
-                currentFrameData.FrameMemory.Push<ImDrawList*>(drawData->CmdListsCount);
-
-            // Create copies of cmd lists
-            for (int i = 0; i < drawData->CmdListsCount; ++i)
-            {
-                // Copy this list!
-                ImDrawList* drawList = drawData->CmdLists[i];
-                newList[i] = currentFrameData.FrameMemory.Push<ImDrawList>();
-                ImDrawList* copiedDrawList = newList[i];
-
-                // Create copies of
-                copiedDrawList->CmdBuffer = ImVector<ImDrawCmd>();
-                CopyImVector<ImDrawCmd>(&copiedDrawList->CmdBuffer, &drawList->CmdBuffer,
-                                        currentFrameData.FrameMemory);
-
-                copiedDrawList->IdxBuffer = ImVector<ImDrawIdx>();
-                CopyImVector<ImDrawIdx>(&copiedDrawList->IdxBuffer, &drawList->IdxBuffer,
-                                        currentFrameData.FrameMemory);
-
-                copiedDrawList->VtxBuffer = ImVector<ImDrawVert>();
-                CopyImVector<ImDrawVert>(&copiedDrawList->VtxBuffer, &drawList->VtxBuffer,
-                                         currentFrameData.FrameMemory);
-            }
-
-            drawData->CmdLists = newList;
-
-            // Set Imgui Render Data
-            currentFrameData.ImOverlayDrawData = drawData;
-
-            graphics::RenderQueue* rq = currentFrameData.FrameMemory.Push<graphics::RenderQueue>();
-            // ToDo(Faaux)(Graphics): This needs to be a dynamic amount of renderables
-            rq->Renderables = currentFrameData.FrameMemory.Push<graphics::Renderable>(250);
-            rq->Count = 0;
-            // Get all actors that need to be drawn
-            for (auto& actor : Game->ActiveWorld->GetAllActors())
-            {
-                // Check if we have a Mesh associated
-                auto staticMeshes = actor->GetComponentsOfType(StaticMeshComponent::GetClassType());
-                for (auto& sm : staticMeshes)
-                {
-                    auto staticMesh = (StaticMeshComponent*)sm;
-                    auto model = g_Managers->ModelManager->Exists(staticMesh->GetRenderable());
-                    Assert(model);
-                    Assert(!rq->Shader || rq->Shader == &model->shader);
-                    rq->Shader = &model->shader;
-                    rq->Renderables[rq->Count].Model = model;
-                    rq->Renderables[rq->Count].ModelMatrix = staticMesh->GetGlobalModelMatrix();
-                    rq->Count++;
-                }
-            }
-            if (rq->Count != 0)
-                currentFrameData.WorldRenderData[0]->RenderCTX->AddRenderQueue(rq);
-            currentFrameData.WorldRenderData[0]->Window = &mainGameWindow;
-            currentFrameData.IsPreRenderDone = true;
-        }
-        // Render Phase
-        {
-            previousFrameData.RenderDone.WaitAndReset();
-
-            Game->RenderState->FrameDataToRender = &currentFrameData;
-            Game->RenderState->RenderCondition.Signal();
-            currentFrameData.DoubleBufferDone.WaitAndReset();
+            frameGraph.DumpCriticalPath();
+            frameContext.IsDumpFrameGraphRequested = false;
         }
+        MemoryTrackerEndFrame();
         Game->CurrentFrameIdx++;
     }
     Game->GameIsRunning = false;
 
-    g_JobQueueShutdownRequested = true;
+    JobSystem::Shutdown();
+    LogArenaStats(frames);
     Cleanup();
 
     return 0;
@@ -10,6 +10,11 @@
 namespace DG
 {
 AABB TransformAABB(const AABB& aabb, const Transform& transform)
+{
+    return TransformAABB(aabb, transform.GetModelMatrix());
+}
+
+AABB TransformAABB(const AABB& aabb, const mat4& model)
 {
     AABB result;
     f32 a, b;
@@ -19,11 +24,10 @@ AABB TransformAABB(const AABB& aabb, const Transform& transform)
     vec3 aMax = aabb.Max;
 
     // Begin at T.
-    result.Min = result.Max = transform.GetPosition();
+    result.Min = result.Max = vec3(model[3]);
 
     // Find extreme points by considering product of
     // min and max with each component of M.
-    auto& model = transform.GetModelMatrix();
     for (s32 j = 0; j < 3; j++)
     {
         for (s32 i = 0; i < 3; i++)
@@ -59,4 +63,50 @@ AABB CombineAABB(const AABB& f, const AABB& s)
     result.Max.z = glm::max(f.Max.z, s.Max.z);
     return result;
 }
+
+bool ContainsAABB(const AABB& outer, const AABB& inner)
+{
+    return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y &&
+           outer.Min.z <= inner.Min.z && outer.Max.x >= inner.Max.x &&
+           outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+}
+
+bool OverlapsAABB(const AABB& f, const AABB& s)
+{
+    return f.Min.x <= s.Max.x && f.Min.y <= s.Max.y && f.Min.z <= s.Max.z &&
+           s.Min.x <= f.Max.x && s.Min.y <= f.Max.y && s.Min.z <= f.Max.z;
+}
+
+Frustum ExtractFrustum(const mat4& viewProjection)
+{
+    // Rows of the matrix, glm is column major
+    const mat4 m = glm::transpose(viewProjection);
+    Frustum result;
+    result.Planes[0] = m[3] + m[0];  // Left
+    result.Planes[1] = m[3] - m[0];  // Right
+    result.Planes[2] = m[3] + m[1];  // Bottom
+    result.Planes[3] = m[3] - m[1];  // Top
+    result.Planes[4] = m[3] + m[2];  // Near
+    result.Planes[5] = m[3] - m[2];  // Far
+    for (vec4& plane : result.Planes) plane /= glm::length(vec3(plane));
+    return result;
+}
+
+FrustumTest TestAABBInFrustum(const AABB& aabb, const Frustum& frustum)
+{
+    const vec3 center = (aabb.Min + aabb.Max) * 0.5f;
+    const vec3 extent = (aabb.Max - aabb.Min) * 0.5f;
+    FrustumTest result = FrustumTest::Inside;
+    for (const vec4& plane : frustum.Planes)
+    {
+        const vec3 normal(plane);
+        const f32 distance = glm::dot(normal, center) + plane.w;
+        const f32 radius = glm::dot(glm::abs(normal), extent);
+        if (distance < -radius)
+            return FrustumTest::Outside;
+        if (distance < radius)
+            result = FrustumTest::Intersecting;
+    }
+    return result;
+}
 }  // namespace DG
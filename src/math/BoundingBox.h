@@ -7,6 +7,7 @@
 #pragma once
 #include "GLMInclude.h"
 #include "Transform.h"
+#include "engine/Types.h"
 
 namespace DG
 {
@@ -17,6 +18,27 @@ struct AABB
 };
 
 AABB TransformAABB(const AABB& aabb, const Transform& transform);
+AABB TransformAABB(const AABB& aabb, const mat4& model);
 
 AABB CombineAABB(const AABB& f, const AABB& s);
+bool ContainsAABB(const AABB& outer, const AABB& inner);
+bool OverlapsAABB(const AABB& f, const AABB& s);
+
+// Planes point inwards, p is inside if dot(vec3(plane), p) + plane.w >= 0 for all six
+struct Frustum
+{
+    vec4 Planes[6];
+};
+
+// Gribb/Hartmann, the planes are normalized
+Frustum ExtractFrustum(const mat4& viewProjection);
+
+enum class FrustumTest : u8
+{
+    Outside,
+    Intersecting,
+    Inside
+};
+// Conservative, boxes close to an edge of the frustum can pass without touching it
+FrustumTest TestAABBInFrustum(const AABB& aabb, const Frustum& frustum);
 }  // namespace DG
@@ -7,6 +7,7 @@
 #include "Memory.h"
 #include "math/GLMInclude.h"
 #include "platform/BitOperations.h"
+#include "VirtualMemory.h"
 
 namespace DG
 {
@@ -27,10 +28,13 @@ u8* StackAllocator::Push(u32 size, u32 alignment)
 
     u8* data = _current - (size + padding);
     StackHeader* header = (StackHeader*)(data - sizeof(StackHeader));
+    if ((u8*)header < _committedBottom)
+        Commit((u8*)header);
     header->free = false;
     header->size = size + (u32)padding;
 
     _current = (u8*)header;
+    Track(header->size + sizeof(StackHeader));
 
     Assert((size_t)data % alignment == 0);
     _hwm = glm::max((u32)((size_t)(_base + _size) - (size_t)_current), _hwm);
@@ -45,6 +49,7 @@ void StackAllocator::Pop(void* p)
     u8* data = (u8*)p;
     StackHeader* header = (StackHeader*)(data - sizeof(StackHeader));
     header->free = true;
+    Track(-(s64)(header->size + sizeof(StackHeader)));
 
 #if _DEBUG
     SDL_memset4(data, 0xDEADBEEF, header->size / 4);
@@ -61,54 +66,325 @@ void StackAllocator::Pop(void* p)
     Assert(_base + _size >= _current);
 }
 
-void StackAllocator::Reset() { _current = _base + _size; }
+void StackAllocator::Reset()
+{
+    _current = _base + _size;
+#if DG_MEMORY_TRACKING
+    // Tags can be shared, e.g. by every world, only give back what this stack reported
+    DG_TRACK_FREE(_tag, (u64)_trackedBytes);
+    _trackedBytes = 0;
+#endif
+}
+
+std::ptrdiff_t StackAllocator::CopyFrom(const StackAllocator& source)
+{
+    Assert(_isInitialized && source._isInitialized);
+    Assert(_size == source._size);
+    Assert(_current == _base + _size);
+
+    const u32 usedSize = (u32)(source._base + source._size - source._current);
+    u8* current = _base + _size - usedSize;
+    if (current < _committedBottom)
+        Commit(current);
+    SDL_memcpy(current, source._current, usedSize);
+    _current = current;
+    _hwm = glm::max(usedSize, _hwm);
+    Track(usedSize);
+
+    // Alignments within the copy only hold if both stacks are aligned the same
+    const std::ptrdiff_t offset = _base - source._base;
+    Assert(offset % 16 == 0);
+    return offset;
+}
+
+void StackAllocator::SetMemoryTag(MemoryTag tag)
+{
+#if DG_MEMORY_TRACKING
+    _tag = tag;
+#endif
+}
+
+void StackAllocator::Track(s64 bytes)
+{
+#if DG_MEMORY_TRACKING
+    if (_tag == 0)
+        return;
+    if (bytes > 0)
+        TrackAllocation(_tag, (u64)bytes);
+    else
+        TrackFree(_tag, (u64)-bytes);
+    _trackedBytes += bytes;
+#endif
+}
+
+bool StackAllocator::InitVirtual(u32 size, bool hugePages)
+{
+    Assert(!_isInitialized);
+    const u32 granularity = GetVirtualMemoryGranularity(hugePages);
+    size = (size + granularity - 1) & ~(granularity - 1);
+
+    u8* base = ReserveVirtualMemory(size, hugePages);
+    if (!base)
+        return false;
+
+    Init(base, size);
+    _committedBottom = base + size;
+    _isVirtual = true;
+    _isHugePages = hugePages;
+    return true;
+}
+
+void StackAllocator::ReleaseVirtual()
+{
+    Assert(_isVirtual);
+    ReleaseVirtualMemory(_base, _size);
+    _isInitialized = false;
+    _isVirtual = false;
+    _base = _current = _committedBottom = nullptr;
+    _size = _hwm = 0;
+}
+
+void StackAllocator::Commit(u8* newBottom)
+{
+    // The stack grows down, commit from the new bottom up to what is committed already
+    Assert(_isVirtual);
+    Assert(newBottom >= _base);  // Out of reserved memory
+    const size_t granularity = GetVirtualMemoryGranularity(_isHugePages);
+    newBottom = (u8*)((size_t)(newBottom - _base) / granularity * granularity + (size_t)_base);
+
+    const bool committed = CommitVirtualMemory(newBottom, _committedBottom - newBottom);
+    Assert(committed);
+    _committedBottom = newBottom;
+}
+
+// Block of a FrameAllocator owned by the current thread. A few allocators are in use at once
+// (one per frame in flight), a small cache per thread covers them without any lookup structure.
+struct FrameAllocatorBlock
+{
+    const FrameAllocator* Owner;
+    u32 Generation;
+    u8* Current;
+    u8* End;
+};
+static const u32 FRAME_ALLOCATOR_BLOCK_CACHE_SIZE = 8;
+thread_local FrameAllocatorBlock LocalFrameBlocks[FRAME_ALLOCATOR_BLOCK_CACHE_SIZE];
+thread_local u32 LocalFrameBlockNextEvict = 0;
+
+void FrameAllocator::Init(u8* base, u32 size, u32 blockSize)
+{
+    Assert(!_isInitialized);
+    Assert(blockSize > 0 && blockSize <= size);
+    _isInitialized = true;
+    _base = base;
+    _size = size;
+    _blockSize = blockSize;
+    _committed.store(size, std::memory_order_relaxed);
+}
+
+bool FrameAllocator::InitVirtual(u32 size, bool hugePages, u32 blockSize)
+{
+    Assert(!_isInitialized);
+    const u32 granularity = GetVirtualMemoryGranularity(hugePages);
+    size = (size + granularity - 1) & ~(granularity - 1);
+
+    u8* base = ReserveVirtualMemory(size, hugePages);
+    if (!base)
+        return false;
+
+    Init(base, size, blockSize);
+    _committed.store(0, std::memory_order_relaxed);
+    _isVirtual = true;
+    _isHugePages = hugePages;
+    return true;
+}
+
+void FrameAllocator::ReleaseVirtual()
+{
+    Assert(_isVirtual);
+    ReleaseVirtualMemory(_base, _size);
+    _isInitialized = false;
+    _isVirtual = false;
+    _base = nullptr;
+    _size = _hwm = 0;
+    _committed.store(0, std::memory_order_relaxed);
+}
+
+u8* FrameAllocator::Carve(u32 size)
+{
+    const u32 offset = _offset.fetch_add(size, std::memory_order_relaxed);
+    Assert(offset + size <= _size);
+    if (offset + size > _committed.load(std::memory_order_acquire))
+        Commit(offset + size);
+    // Once per block instead of per push, the tag counters are shared between all threads
+    DG_TRACK_ALLOCATION(_tag, size);
+    return _base + offset;
+}
+
+void FrameAllocator::Commit(u32 end)
+{
+    Assert(_isVirtual);
+    SDL_AtomicLock(&_commitLock);
+    const u32 committed = _committed.load(std::memory_order_relaxed);
+    if (end > committed)
+    {
+        // Another thread might have committed while we waited for the lock
+        const u32 granularity = GetVirtualMemoryGranularity(_isHugePages);
+        u32 newCommitted = (end + granularity - 1) & ~(granularity - 1);
+        if (newCommitted > _size)
+            newCommitted = _size;
+
+        const bool success = CommitVirtualMemory(_base + committed, newCommitted - committed);
+        Assert(success);
+        _committed.store(newCommitted, std::memory_order_release);
+    }
+    SDL_AtomicUnlock(&_commitLock);
+}
+
+u8* FrameAllocator::Push(u32 size, u32 alignment)
+{
+    if (size == 0)
+        return nullptr;
+
+    Assert(_isInitialized);
+    Assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    const u32 generation = _generation.load(std::memory_order_relaxed);
+    FrameAllocatorBlock* block = nullptr;
+    for (FrameAllocatorBlock& candidate : LocalFrameBlocks)
+    {
+        if (candidate.Owner == this)
+        {
+            block = &candidate;
+            break;
+        }
+    }
+    if (!block)
+    {
+        block = &LocalFrameBlocks[LocalFrameBlockNextEvict];
+        LocalFrameBlockNextEvict = (LocalFrameBlockNextEvict + 1) % FRAME_ALLOCATOR_BLOCK_CACHE_SIZE;
+        block->Owner = this;
+        block->Current = block->End = nullptr;
+    }
+    if (block->Generation != generation)
+    {
+        // Reset happened since we last allocated, the block is gone
+        block->Generation = generation;
+        block->Current = block->End = nullptr;
+    }
+
+    u8* data = (u8*)(((size_t)block->Current + alignment - 1) & ~(size_t)(alignment - 1));
+    if (!block->Current || data + size > block->End)
+    {
+        // Big allocations get their own piece, the current block stays usable
+        if (size + alignment > _blockSize / 4)
+        {
+            u8* memory = Carve(size + alignment - 1);
+            return (u8*)(((size_t)memory + alignment - 1) & ~(size_t)(alignment - 1));
+        }
+
+        block->Current = Carve(_blockSize);
+        block->End = block->Current + _blockSize;
+        data = (u8*)(((size_t)block->Current + alignment - 1) & ~(size_t)(alignment - 1));
+    }
+
+    block->Current = data + size;
+    return data;
+}
+
+void FrameAllocator::Reset()
+{
+    const u32 used = GetUsedSize();
+    if (used > _hwm)
+        _hwm = used;
+    // Everything carved was reported
+    DG_TRACK_FREE(_tag, _offset.load(std::memory_order_relaxed));
+    _offset.store(0, std::memory_order_relaxed);
+    _generation.fetch_add(1, std::memory_order_release);
+}
+
+void FrameAllocator::SetMemoryTag(MemoryTag tag)
+{
+#if DG_MEMORY_TRACKING
+    _tag = tag;
+#endif
+}
+
+u32 FrameAllocator::GetUsedSize() const
+{
+    const u32 offset = _offset.load(std::memory_order_relaxed);
+    return offset < _size ? offset : _size;
+}
+
+u32 FrameAllocator::GetHighWaterMark() const
+{
+    const u32 used = GetUsedSize();
+    return used > _hwm ? used : _hwm;
+}
+
+static const u32 POOL_SLOTS_PER_CHUNK = 64;
+static const u32 POOL_CHUNKS_PER_BLOCK = 8;
 
 void BasePoolAllocator::Initialize(StackAllocator* allocator, s32 size)
 {
     Assert(!_isInitialized);
-    Assert(_size % 4 == 0);
+    Assert(size % 4 == 0);
     _isInitialized = true;
     _allocator = allocator;
     _size = size;
 
-    _head = AllocateNewChunk();
+    // Header and slots share one power of two sized region, the header sits at its start
+    _chunkHeaderSize = (sizeof(Chunk) + 15) & ~15u;
+    const u32 neededSize = _chunkHeaderSize + POOL_SLOTS_PER_CHUNK * (u32)size;
+    _chunkSize = 1;
+    while (_chunkSize < neededSize)
+        _chunkSize <<= 1;
+
+    AllocateNewBlock();
 }
 
 void BasePoolAllocator::Shutdown()
 {
-    Chunk* current = _head;
-    Chunk* next = _head->Next;
-    _allocator->Pop(current->Base);
-    _allocator->Pop(current);
-    while (next)
+    Chunk* block = _blockHead;
+    while (block)
     {
-        current = next;
-        next = next->Next;
-        _allocator->Pop(current->Base);
-        _allocator->Pop(current);
+        Chunk* next = block->NextBlock;
+        _allocator->Pop(block->BlockMemory);
+        block = next;
     }
+    _freeHead = nullptr;
+    _usedHead = nullptr;
+    _blockHead = nullptr;
 }
 
 u8* BasePoolAllocator::Allocate()
 {
     Assert(_isInitialized);
 
-    // Find a chunk with space
-    Chunk* candidate = _head;
-    while (candidate->Bitmask == 0)
+    if (!_freeHead)
+        AllocateNewBlock();
+
+    Chunk* chunk = _freeHead;
+    if (chunk->Bitmask == 0xFFFFFFFFFFFFFFFF)
     {
-        if (!candidate->Next)
-            candidate->Next = AllocateNewChunk();
-        candidate = candidate->Next;
+        // First slot in use, make the chunk visible to iteration
+        chunk->PrevUsed = nullptr;
+        chunk->NextUsed = _usedHead;
+        if (_usedHead)
+            _usedHead->PrevUsed = chunk;
+        _usedHead = chunk;
     }
 
     u32 index = 0;
-    BitScanForward(candidate->Bitmask, &index);
+    BitScanForward(chunk->Bitmask, &index);
 
-    u8* data = candidate->Base + (_size * index);
+    u8* data = chunk->Base + (_size * index);
     u64 bit = (u64)1 << index;
-    candidate->Bitmask &= ~bit;
+    chunk->Bitmask &= ~bit;
 
+    if (chunk->Bitmask == 0)
+        _freeHead = chunk->NextFree;
+
+    DG_TRACK_ALLOCATION(_tag, _size);
     return data;
 }
 
@@ -116,41 +392,85 @@ void BasePoolAllocator::Free(void* ptr)
 {
     Assert(_isInitialized);
 
-    // Find correct chunk
-    Chunk* candidate = _head;
-    while (candidate && (candidate->Base > ptr || candidate->Base + 63 * _size < ptr))
+    Chunk* chunk = GetChunk(ptr);
+    Assert(chunk->Base <= ptr && chunk->Base + (POOL_SLOTS_PER_CHUNK - 1) * _size >= ptr);
+
+    u64 index = ((u64)ptr - (u64)chunk->Base) / _size;
+    u64 bit = (u64)1 << index;
+    Assert((chunk->Bitmask & bit) == 0);  // Double free
+
+    if (chunk->Bitmask == 0)
     {
-        candidate = candidate->Next;
+        chunk->NextFree = _freeHead;
+        _freeHead = chunk;
     }
-    Assert(candidate);
+    chunk->Bitmask |= bit;
+    DG_TRACK_FREE(_tag, _size);
 
-    u64 index = ((u64)ptr - (u64)candidate->Base) / _size;
-    u64 bit = (u64)1 << index;
-    candidate->Bitmask |= bit;
+    if (chunk->Bitmask == 0xFFFFFFFFFFFFFFFF)
+    {
+        // Unlink but keep NextUsed intact so an iterator standing on this chunk can continue
+        if (chunk->PrevUsed)
+            chunk->PrevUsed->NextUsed = chunk->NextUsed;
+        else
+            _usedHead = chunk->NextUsed;
+        if (chunk->NextUsed)
+            chunk->NextUsed->PrevUsed = chunk->PrevUsed;
+    }
 
 #if _DEBUG
     SDL_memset4(ptr, 0xDEADBEEF, _size / 4);
 #endif
 }
 
+void BasePoolAllocator::SetMemoryTag(MemoryTag tag)
+{
+#if DG_MEMORY_TRACKING
+    _tag = tag;
+#endif
+}
+
 BasePoolAllocator::Iterator<u8> BasePoolAllocator::begin() const
 {
-    return Iterator<u8>(_head, _size);
+    return Iterator<u8>(_usedHead, _size);
 }
 BasePoolAllocator::Iterator<u8> BasePoolAllocator::end() const
 {
     return Iterator<u8>(nullptr, _size);
 }
 
-BasePoolAllocator::Chunk* BasePoolAllocator::AllocateNewChunk() const
+void BasePoolAllocator::AllocateNewBlock()
 {
     Assert(_isInitialized);
-    Chunk* chunk = _allocator->Push<Chunk>();
 
-    chunk->Next = nullptr;
-    chunk->Bitmask = 0xFFFFFFFFFFFFFFFF;
-    chunk->Base = _allocator->Push(64 * _size, 16);
+    // StackAllocator can not align to more than 256 bytes, overallocate and align by hand
+    u8* blockMemory = _allocator->Push(_chunkSize * (POOL_CHUNKS_PER_BLOCK + 1), 16);
+    u8* first = (u8*)(((size_t)blockMemory + _chunkSize - 1) & ~(size_t)(_chunkSize - 1));
 
-    return chunk;
+    for (u32 i = 0; i < POOL_CHUNKS_PER_BLOCK; ++i)
+    {
+        Chunk* chunk = (Chunk*)(first + i * _chunkSize);
+        chunk->NextUsed = nullptr;
+        chunk->PrevUsed = nullptr;
+        chunk->Bitmask = 0xFFFFFFFFFFFFFFFF;
+        chunk->Base = (u8*)chunk + _chunkHeaderSize;
+        chunk->NextBlock = nullptr;
+        chunk->BlockMemory = nullptr;
+
+        // Keep address order so allocations fill the block front to back
+        chunk->NextFree = i + 1 < POOL_CHUNKS_PER_BLOCK ? (Chunk*)(first + (i + 1) * _chunkSize)
+                                                        : _freeHead;
+    }
+    _freeHead = (Chunk*)first;
+
+    Chunk* firstChunk = (Chunk*)first;
+    firstChunk->BlockMemory = blockMemory;
+    firstChunk->NextBlock = _blockHead;
+    _blockHead = firstChunk;
+}
+
+BasePoolAllocator::Chunk* BasePoolAllocator::GetChunk(void* ptr) const
+{
+    return (Chunk*)((size_t)ptr & ~(size_t)(_chunkSize - 1));
 }
 }  // namespace DG
@@ -5,7 +5,10 @@
  */
 
 #pragma once
+#include <atomic>
+#include <cstddef>
 #include "engine/Types.h"
+#include "memory/MemoryTracker.h"
 #include "platform/BitOperations.h"
 
 namespace DG
@@ -19,14 +22,30 @@ struct StackAllocator
         _isInitialized = true;
         _base = base;
         _current = base + size;
+        _committedBottom = base;
         _size = size;
     }
 
+    // Reserves size bytes of address space and commits pages as the stack grows into them
+    bool InitVirtual(u32 size, bool hugePages = false);
+    void ReleaseVirtual();
+
     u8* Push(u32 size, u32 alignment);
     void Pop(void* ptr);
 
     void Reset();
 
+    // Turns this empty stack into a copy of source, both have to be the same size. Returns the
+    // offset to add to pointers into source to get the same data in here.
+    std::ptrdiff_t CopyFrom(const StackAllocator& source);
+
+    // Reports pushes and pops to the tag, tags overlap when allocators are carved from each other
+    void SetMemoryTag(MemoryTag tag);
+
+    u32 GetReservedSize() const { return _size; }
+    u32 GetCommittedSize() const { return (u32)(_base + _size - _committedBottom); }
+    u32 GetHighWaterMark() const { return _hwm; }
+
     template <typename T, typename... Args>
     T* PushAndConstruct(Args&&... args);
 
@@ -40,11 +59,21 @@ struct StackAllocator
         u32 size;
     };
 
+    void Commit(u8* newBottom);
+    void Track(s64 bytes);
+
     bool _isInitialized = false;
+    bool _isVirtual = false;
+    bool _isHugePages = false;
     u8* _base = 0;
     u8* _current = 0;
+    u8* _committedBottom = 0;
     u32 _size = 0;
     u32 _hwm = 0;
+#if DG_MEMORY_TRACKING
+    MemoryTag _tag = 0;
+    s64 _trackedBytes = 0;  // What this stack reported to its tag, Reset gives back only that
+#endif
 };
 
 template <typename T, typename... Args>
@@ -62,20 +91,102 @@ T* StackAllocator::Push(u32 count)
     return (T*)memory;
 }
 
+// Linear allocator for data living exactly one frame, safe to use from any number of threads.
+// Every thread carves its own block out of the shared memory with one atomic add and allocates
+// from that without synchronization. There are no headers and no frees, Reset is O(1).
+class FrameAllocator
+{
+   public:
+    void Init(u8* base, u32 size, u32 blockSize = 64 * 1024);
+    // Reserves size bytes of address space and commits pages as blocks are carved from it
+    bool InitVirtual(u32 size, bool hugePages = false, u32 blockSize = 64 * 1024);
+    void ReleaseVirtual();
+
+    u8* Push(u32 size, u32 alignment);
+
+    // Push does not clear the memory, PushZeroed does
+    template <typename T>
+    T* Push(u32 count = 1);
+    template <typename T>
+    T* PushZeroed(u32 count = 1);
+    template <typename T, typename... Args>
+    T* PushAndConstruct(Args&&... args);
+
+    // Nobody may allocate while resetting, every thread drops its block on the next Push
+    void Reset();
+
+    // Reports carved blocks and big pushes, not every single push
+    void SetMemoryTag(MemoryTag tag);
+
+    u32 GetUsedSize() const;
+    u32 GetReservedSize() const { return _size; }
+    u32 GetCommittedSize() const { return _committed.load(std::memory_order_relaxed); }
+    // Most memory used by a single frame
+    u32 GetHighWaterMark() const;
+
+   private:
+    u8* Carve(u32 size);
+    void Commit(u32 end);
+
+    bool _isInitialized = false;
+    bool _isVirtual = false;
+    bool _isHugePages = false;
+    u8* _base = nullptr;
+    u32 _size = 0;
+    u32 _blockSize = 0;
+    u32 _hwm = 0;
+    SDL_SpinLock _commitLock = 0;
+    std::atomic<u32> _committed{0};
+    std::atomic<u32> _offset{0};
+    std::atomic<u32> _generation{0};
+#if DG_MEMORY_TRACKING
+    MemoryTag _tag = 0;
+#endif
+};
+
+template <typename T>
+T* FrameAllocator::Push(u32 count)
+{
+    return (T*)Push(sizeof(T) * count, alignof(T));
+}
+
+template <typename T>
+T* FrameAllocator::PushZeroed(u32 count)
+{
+    void* memory = Push(sizeof(T) * count, alignof(T));
+    SDL_memset(memory, 0, sizeof(T) * count);
+    return (T*)memory;
+}
+
+template <typename T, typename... Args>
+T* FrameAllocator::PushAndConstruct(Args&&... args)
+{
+    void* memory = Push(sizeof(T), alignof(T));
+    return new (memory) T(std::forward<Args>(args)...);
+}
+
 struct GameMemory
 {
     StackAllocator PersistentMemory;
     StackAllocator TransientMemory;
 };
 
+// Fixed size object pool, chunks of 64 slots each.
+// Chunks are aligned to their power of two size so Free finds the owner with a mask, chunks with
+// free slots are kept in a list so Allocate never searches. Iteration only visits chunks that
+// have at least one slot in use. Freeing while iterating is fine, allocating is not.
 class BasePoolAllocator
 {
    private:
     struct Chunk
     {
-        Chunk* Next;
-        u64 Bitmask;
+        Chunk* NextFree;  // Chunks with at least one free slot
+        Chunk* NextUsed;  // Chunks with at least one used slot
+        Chunk* PrevUsed;
+        u64 Bitmask;  // 1 = free
         u8* Base;
+        Chunk* NextBlock;  // Only set on the first chunk of a block
+        u8* BlockMemory;
     };
 
    public:
@@ -85,6 +196,8 @@ class BasePoolAllocator
     u8* Allocate();
     void Free(void* ptr);
 
+    void SetMemoryTag(MemoryTag tag);
+
     template <typename T>
     class Iterator
     {
@@ -145,12 +258,20 @@ class BasePoolAllocator
     Iterator<u8> end() const;
 
    private:
-    Chunk* AllocateNewChunk() const;
+    void AllocateNewBlock();
+    Chunk* GetChunk(void* ptr) const;
 
     bool _isInitialized = false;
     StackAllocator* _allocator = nullptr;
-    Chunk* _head = nullptr;
+    Chunk* _freeHead = nullptr;
+    Chunk* _usedHead = nullptr;
+    Chunk* _blockHead = nullptr;
+    u32 _chunkSize = 0;
+    u32 _chunkHeaderSize = 0;
     s32 _size = 0;
+#if DG_MEMORY_TRACKING
+    MemoryTag _tag = 0;
+#endif
 };
 
 template <class T>
@@ -164,6 +285,8 @@ struct PoolAllocator : private BasePoolAllocator
 
     T* Allocate();
     void Free(void* ptr);
+
+    using BasePoolAllocator::SetMemoryTag;
 };
 
 template <typename T>
@@ -194,7 +317,7 @@ void BasePoolAllocator::Iterator<T>::MoveToNext()
     {
         if (_negatedBitmask == 0)
         {
-            _chunk = _chunk->Next;
+            _chunk = _chunk->NextUsed;
             _negatedBitmask = _chunk ? ~_chunk->Bitmask : 0;
             continue;
         }
@@ -0,0 +1,291 @@
+/**
+ *  @file    MemoryBenchmark.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "MemoryBenchmark.h"
+#include <SDL.h>
+#include "Memory.h"
+
+namespace DG
+{
+static const u32 ALLOCATIONS_PER_THREAD = 20000;
+static const u32 MAX_BENCHMARK_THREADS = 16;
+static const u32 BENCHMARK_ARENA_SIZE = 64 * 1024 * 1024;
+
+struct AllocatorBenchmarkContext
+{
+    StackAllocator* Stack;
+    SDL_SpinLock StackLock;
+    FrameAllocator* Frame;
+    SDL_atomic_t StartedThreads;
+    u32 ThreadCount;
+};
+
+// Same sequence of sizes between 16 and 128 bytes for every run
+static u32 NextAllocationSize(u32* state)
+{
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return 16 + (x % 113);
+}
+
+static void WaitForAllThreads(AllocatorBenchmarkContext* context)
+{
+    // Start together so the threads really contend
+    SDL_AtomicIncRef(&context->StartedThreads);
+    while ((u32)SDL_AtomicGet(&context->StartedThreads) < context->ThreadCount)
+    {
+    }
+}
+
+static int StackAllocatorThread(void* data)
+{
+    AllocatorBenchmarkContext* context = (AllocatorBenchmarkContext*)data;
+    u32 state = 0x9E3779B9;
+    WaitForAllThreads(context);
+    for (u32 i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+    {
+        const u32 size = NextAllocationSize(&state);
+        SDL_AtomicLock(&context->StackLock);
+        u8* memory = context->Stack->Push(size, 8);
+        SDL_AtomicUnlock(&context->StackLock);
+        memory[0] = (u8)i;
+    }
+    return 0;
+}
+
+static int FrameAllocatorThread(void* data)
+{
+    AllocatorBenchmarkContext* context = (AllocatorBenchmarkContext*)data;
+    u32 state = 0x9E3779B9;
+    WaitForAllThreads(context);
+    for (u32 i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+    {
+        u8* memory = context->Frame->Push(NextAllocationSize(&state), 8);
+        memory[0] = (u8)i;
+    }
+    return 0;
+}
+
+static f64 MeasureThreads(AllocatorBenchmarkContext* context, SDL_ThreadFunction function)
+{
+    SDL_Thread* threads[MAX_BENCHMARK_THREADS];
+    SDL_AtomicSet(&context->StartedThreads, 0);
+
+    const u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < context->ThreadCount; ++i)
+    {
+        threads[i] = SDL_CreateThread(function, "AllocatorBenchmark", context);
+    }
+    for (u32 i = 0; i < context->ThreadCount; ++i)
+    {
+        SDL_WaitThread(threads[i], nullptr);
+    }
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           (f64)SDL_GetPerformanceFrequency();
+}
+
+void RunFrameAllocatorBenchmark()
+{
+    u8* stackMemory = new u8[BENCHMARK_ARENA_SIZE];
+    u8* frameMemory = new u8[BENCHMARK_ARENA_SIZE];
+    StackAllocator stack;
+    stack.Init(stackMemory, BENCHMARK_ARENA_SIZE);
+    FrameAllocator frame;
+    frame.Init(frameMemory, BENCHMARK_ARENA_SIZE);
+
+    u32 maxThreads = (u32)SDL_GetCPUCount();
+    if (maxThreads > MAX_BENCHMARK_THREADS)
+        maxThreads = MAX_BENCHMARK_THREADS;
+
+    SDL_Log("FrameAllocator benchmark, %u allocations per thread (includes thread start up)",
+            ALLOCATIONS_PER_THREAD);
+    for (u32 threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        AllocatorBenchmarkContext context = {};
+        context.Stack = &stack;
+        context.Frame = &frame;
+        context.ThreadCount = threadCount;
+
+        stack.Reset();
+        frame.Reset();
+        const f64 stackTime = MeasureThreads(&context, StackAllocatorThread);
+        const f64 frameTime = MeasureThreads(&context, FrameAllocatorThread);
+
+        SDL_Log("  %2u threads: StackAllocator + lock %8.3fms, FrameAllocator %8.3fms, %.2fx",
+                threadCount, stackTime, frameTime, frameTime > 0.0 ? stackTime / frameTime : 0.0);
+    }
+
+    delete[] stackMemory;
+    delete[] frameMemory;
+}
+
+struct PoolBenchmarkObject
+{
+    u64 Payload[4];
+};
+
+static const u32 POOL_BENCHMARK_ARENA_SIZE = 256 * 1024 * 1024;
+// The linear pool is quadratic, past this it would take minutes
+static const u32 LINEAR_POOL_MAX_OBJECTS = 64 * 1024;
+
+// Chunk search the way the pool worked before, kept as reference point for the benchmark
+struct LinearPool
+{
+    struct Chunk
+    {
+        Chunk* Next;
+        u64 Bitmask;
+        u8* Base;
+    };
+
+    Chunk* Head = nullptr;
+    StackAllocator* Allocator = nullptr;
+
+    Chunk* NewChunk()
+    {
+        Chunk* chunk = Allocator->Push<Chunk>();
+        chunk->Bitmask = 0xFFFFFFFFFFFFFFFF;
+        chunk->Base = Allocator->Push(64 * sizeof(PoolBenchmarkObject), 16);
+        return chunk;
+    }
+
+    u8* Allocate()
+    {
+        Chunk* candidate = Head;
+        while (candidate->Bitmask == 0)
+        {
+            if (!candidate->Next)
+                candidate->Next = NewChunk();
+            candidate = candidate->Next;
+        }
+        u32 index = 0;
+        BitScanForward(candidate->Bitmask, &index);
+        candidate->Bitmask &= ~((u64)1 << index);
+        return candidate->Base + sizeof(PoolBenchmarkObject) * index;
+    }
+
+    void Free(void* ptr)
+    {
+        Chunk* candidate = Head;
+        while (candidate->Base > ptr || candidate->Base + 63 * sizeof(PoolBenchmarkObject) < ptr)
+            candidate = candidate->Next;
+        const u64 index = ((u64)ptr - (u64)candidate->Base) / sizeof(PoolBenchmarkObject);
+        candidate->Bitmask |= (u64)1 << index;
+    }
+};
+
+struct PoolBenchmarkResult
+{
+    f64 AllocateNs;
+    f64 FreeNs;
+    f64 IterateNs;
+};
+
+static f64 ElapsedNsPerOp(u64 start, u32 operations)
+{
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000000000.0 /
+           (f64)SDL_GetPerformanceFrequency() / (f64)operations;
+}
+
+// Shuffled so frees hit chunks all over the pool
+static void ShufflePointers(void** pointers, u32 count)
+{
+    u32 state = 0x9E3779B9;
+    for (u32 i = count - 1; i > 0; --i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const u32 j = state % (i + 1);
+        void* temp = pointers[i];
+        pointers[i] = pointers[j];
+        pointers[j] = temp;
+    }
+}
+
+template <class Pool>
+static PoolBenchmarkResult MeasurePool(Pool* pool, void** pointers, u32 count)
+{
+    PoolBenchmarkResult result = {};
+
+    // Fill, then free half and refill it so Allocate has to find holes
+    for (u32 i = 0; i < count; ++i)
+        pointers[i] = pool->Allocate();
+    ShufflePointers(pointers, count);
+
+    const u32 churn = count / 2;
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < churn; ++i)
+        pool->Free(pointers[i]);
+    result.FreeNs = ElapsedNsPerOp(start, churn);
+
+    start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < churn; ++i)
+        pointers[i] = pool->Allocate();
+    result.AllocateNs = ElapsedNsPerOp(start, churn);
+
+    for (u32 i = 0; i < count; ++i)
+        pool->Free(pointers[i]);
+    return result;
+}
+
+void RunPoolAllocatorBenchmark()
+{
+    u8* memory = new u8[POOL_BENCHMARK_ARENA_SIZE];
+    const u32 sizes[] = {1024, 64 * 1024, 1024 * 1024};
+    void** pointers = new void*[1024 * 1024];
+
+    SDL_Log("PoolAllocator benchmark, %u byte objects, ns per operation",
+            (u32)sizeof(PoolBenchmarkObject));
+    for (u32 count : sizes)
+    {
+        StackAllocator stack;
+        stack.Init(memory, POOL_BENCHMARK_ARENA_SIZE);
+
+        PoolAllocator<PoolBenchmarkObject> pool;
+        pool.Initialize(&stack);
+        const PoolBenchmarkResult result = MeasurePool(&pool, pointers, count);
+
+        // Iterate over a sparse pool, every 4th object alive
+        for (u32 i = 0; i < count; ++i)
+            pointers[i] = pool.Allocate();
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (i % 4 != 0)
+                pool.Free(pointers[i]);
+        }
+        u64 sum = 0;
+        const u64 start = SDL_GetPerformanceCounter();
+        for (PoolBenchmarkObject& object : pool)
+            sum += object.Payload[0];
+        const f64 iterateNs = ElapsedNsPerOp(start, count / 4);
+        pool.Shutdown();
+
+        SDL_Log("  %7u objects: PoolAllocator alloc %7.1f free %7.1f iterate %5.1f (%llu)", count,
+                result.AllocateNs, result.FreeNs, iterateNs, (unsigned long long)sum);
+
+        if (count > LINEAR_POOL_MAX_OBJECTS)
+        {
+            SDL_Log("  %7u objects: linear pool skipped", count);
+            continue;
+        }
+
+        stack.Reset();
+        LinearPool linear;
+        linear.Allocator = &stack;
+        linear.Head = linear.NewChunk();
+        const PoolBenchmarkResult linearResult = MeasurePool(&linear, pointers, count);
+        SDL_Log("  %7u objects: linear pool   alloc %7.1f free %7.1f", count,
+                linearResult.AllocateNs, linearResult.FreeNs);
+    }
+
+    delete[] pointers;
+    delete[] memory;
+}
+}  // namespace DG
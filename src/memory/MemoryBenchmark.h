@@ -0,0 +1,18 @@
+/**
+ *  @file    MemoryBenchmark.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+
+namespace DG
+{
+// Times FrameAllocator::Push against a StackAllocator behind a lock with 1 to N threads
+// allocating at once and logs the results.
+void RunFrameAllocatorBenchmark();
+
+// Times PoolAllocator allocate, free and iteration with 1k, 64k and 1M live objects against a
+// pool that searches its chunk list linearly and logs the results.
+void RunPoolAllocatorBenchmark();
+}  // namespace DG
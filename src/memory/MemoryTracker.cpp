@@ -0,0 +1,164 @@
+/**
+ *  @file    MemoryTracker.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "MemoryTracker.h"
+
+#if DG_MEMORY_TRACKING
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include "json.hpp"
+
+namespace DG
+{
+static const u32 MAX_MEMORY_TAGS = 128;
+static const u32 MAX_MEMORY_TAG_NAME = 64;
+
+struct MemoryTagData
+{
+    char Name[MAX_MEMORY_TAG_NAME];
+    std::atomic<u64> Budget;
+    std::atomic<s64> LiveBytes;
+    std::atomic<s64> PeakBytes;
+    std::atomic<u64> TotalAllocations;
+    std::atomic<u32> FrameAllocations;
+    u32 LastFrameAllocations;
+    u32 PeakFrameAllocations;
+    u32 BudgetOverruns;
+    bool WasOverBudget;
+};
+
+// Index 0 stays unused so a zeroed tag member means untracked
+static MemoryTagData Tags[MAX_MEMORY_TAGS];
+static std::atomic<u32> TagCount{1};
+static SDL_SpinLock RegisterLock = 0;
+
+MemoryTag RegisterMemoryTag(const char* name, u64 budget)
+{
+    SDL_AtomicLock(&RegisterLock);
+    const u32 count = TagCount.load(std::memory_order_relaxed);
+    for (u32 i = 1; i < count; ++i)
+    {
+        if (SDL_strcmp(Tags[i].Name, name) == 0)
+        {
+            SDL_AtomicUnlock(&RegisterLock);
+            if (budget)
+                SetMemoryTagBudget((MemoryTag)i, budget);
+            return (MemoryTag)i;
+        }
+    }
+
+    Assert(count < MAX_MEMORY_TAGS);
+    MemoryTagData& tag = Tags[count];
+    SDL_strlcpy(tag.Name, name, MAX_MEMORY_TAG_NAME);
+    tag.Budget.store(budget, std::memory_order_relaxed);
+    TagCount.store(count + 1, std::memory_order_release);
+    SDL_AtomicUnlock(&RegisterLock);
+    return (MemoryTag)count;
+}
+
+void SetMemoryTagBudget(MemoryTag tag, u64 budget)
+{
+    Assert(tag < TagCount.load(std::memory_order_acquire));
+    Tags[tag].Budget.store(budget, std::memory_order_relaxed);
+}
+
+void TrackAllocation(MemoryTag tag, u64 bytes)
+{
+    if (tag == 0)
+        return;
+
+    MemoryTagData& data = Tags[tag];
+    const s64 live = data.LiveBytes.fetch_add((s64)bytes, std::memory_order_relaxed) + (s64)bytes;
+    s64 peak = data.PeakBytes.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !data.PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+    data.TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+    data.FrameAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TrackFree(MemoryTag tag, u64 bytes)
+{
+    if (tag == 0)
+        return;
+    Tags[tag].LiveBytes.fetch_sub((s64)bytes, std::memory_order_relaxed);
+}
+
+void MemoryTrackerEndFrame()
+{
+    const u32 count = TagCount.load(std::memory_order_acquire);
+    for (u32 i = 1; i < count; ++i)
+    {
+        MemoryTagData& data = Tags[i];
+        data.LastFrameAllocations = data.FrameAllocations.exchange(0, std::memory_order_relaxed);
+        if (data.LastFrameAllocations > data.PeakFrameAllocations)
+            data.PeakFrameAllocations = data.LastFrameAllocations;
+
+        // Only warn when the tag goes over, not every frame it stays there
+        const u64 budget = data.Budget.load(std::memory_order_relaxed);
+        const s64 live = data.LiveBytes.load(std::memory_order_relaxed);
+        const bool isOverBudget = budget && live > 0 && (u64)live > budget;
+        if (isOverBudget)
+        {
+            data.BudgetOverruns++;
+            if (!data.WasOverBudget)
+                SDL_LogWarn(0, "Memory tag %s is over budget: %lld of %llu bytes", data.Name,
+                            (long long)live, (unsigned long long)budget);
+        }
+        data.WasOverBudget = isOverBudget;
+    }
+}
+
+u32 GetMemoryTagCount() { return TagCount.load(std::memory_order_acquire); }
+
+bool GetMemoryTagStats(MemoryTag tag, MemoryTagStats* stats)
+{
+    if (tag == 0 || tag >= TagCount.load(std::memory_order_acquire))
+        return false;
+
+    const MemoryTagData& data = Tags[tag];
+    stats->Name = data.Name;
+    stats->Budget = data.Budget.load(std::memory_order_relaxed);
+    stats->LiveBytes = data.LiveBytes.load(std::memory_order_relaxed);
+    stats->PeakBytes = data.PeakBytes.load(std::memory_order_relaxed);
+    stats->TotalAllocations = data.TotalAllocations.load(std::memory_order_relaxed);
+    stats->LastFrameAllocations = data.LastFrameAllocations;
+    stats->PeakFrameAllocations = data.PeakFrameAllocations;
+    stats->BudgetOverruns = data.BudgetOverruns;
+    return true;
+}
+
+bool DumpMemoryStatsToJson(const char* path)
+{
+    nlohmann::json json = nlohmann::json::array();
+    const u32 count = GetMemoryTagCount();
+    for (u32 i = 1; i < count; ++i)
+    {
+        MemoryTagStats stats;
+        GetMemoryTagStats((MemoryTag)i, &stats);
+        json.push_back({{"name", stats.Name},
+                        {"budget", stats.Budget},
+                        {"liveBytes", stats.LiveBytes},
+                        {"peakBytes", stats.PeakBytes},
+                        {"totalAllocations", stats.TotalAllocations},
+                        {"lastFrameAllocations", stats.LastFrameAllocations},
+                        {"peakFrameAllocations", stats.PeakFrameAllocations},
+                        {"budgetOverruns", stats.BudgetOverruns}});
+    }
+
+    std::ofstream o(path);
+    if (!o)
+    {
+        SDL_LogError(0, "Couldn't write memory stats to %s", path);
+        return false;
+    }
+    o << std::setw(4) << json << std::endl;
+    return true;
+}
+}  // namespace DG
+#endif
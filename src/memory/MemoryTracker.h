@@ -0,0 +1,60 @@
+/**
+ *  @file    MemoryTracker.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include "engine/Types.h"
+
+// Allocators report to named tags, compiling this out removes every counter and call
+#ifndef DG_MEMORY_TRACKING
+#define DG_MEMORY_TRACKING 1
+#endif
+
+namespace DG
+{
+// 0 is the untracked tag, reports to it are dropped
+typedef u16 MemoryTag;
+
+struct MemoryTagStats
+{
+    const char* Name;
+    u64 Budget;  // 0 = no budget
+    s64 LiveBytes;
+    s64 PeakBytes;
+    u64 TotalAllocations;
+    u32 LastFrameAllocations;
+    u32 PeakFrameAllocations;
+    u32 BudgetOverruns;  // Frames that ended over budget
+};
+
+#if DG_MEMORY_TRACKING
+// Registering a name twice returns the same tag, e.g. one tag for all ComponentStorage<T>
+MemoryTag RegisterMemoryTag(const char* name, u64 budget = 0);
+void SetMemoryTagBudget(MemoryTag tag, u64 budget);
+
+void TrackAllocation(MemoryTag tag, u64 bytes);
+void TrackFree(MemoryTag tag, u64 bytes);
+
+// Closes the per frame allocation counts and checks the budgets
+void MemoryTrackerEndFrame();
+
+u32 GetMemoryTagCount();
+bool GetMemoryTagStats(MemoryTag tag, MemoryTagStats* stats);
+bool DumpMemoryStatsToJson(const char* path);
+
+#define DG_TRACK_ALLOCATION(tag, bytes) DG::TrackAllocation(tag, bytes)
+#define DG_TRACK_FREE(tag, bytes) DG::TrackFree(tag, bytes)
+#else
+inline MemoryTag RegisterMemoryTag(const char*, u64 = 0) { return 0; }
+inline void SetMemoryTagBudget(MemoryTag, u64) {}
+inline void MemoryTrackerEndFrame() {}
+inline u32 GetMemoryTagCount() { return 0; }
+inline bool GetMemoryTagStats(MemoryTag, MemoryTagStats*) { return false; }
+inline bool DumpMemoryStatsToJson(const char*) { return false; }
+
+#define DG_TRACK_ALLOCATION(tag, bytes)
+#define DG_TRACK_FREE(tag, bytes)
+#endif
+}  // namespace DG
@@ -0,0 +1,127 @@
+/**
+ *  @file    VirtualMemory.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "VirtualMemory.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DG
+{
+static const u32 COMMIT_GRANULARITY = 64 * 1024;
+static const u32 HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+u32 GetVirtualMemoryGranularity(bool hugePages)
+{
+#if defined(_WIN32)
+    return COMMIT_GRANULARITY;
+#else
+    return hugePages ? HUGE_PAGE_SIZE : COMMIT_GRANULARITY;
+#endif
+}
+
+#if defined(_WIN32)
+u8* ReserveVirtualMemory(u64 size, bool hugePages)
+{
+    // Large pages on Windows can not be committed on demand, stay with normal pages
+    return (u8*)VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool CommitVirtualMemory(u8* ptr, u64 size)
+{
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void ReleaseVirtualMemory(u8* base, u64 size) { VirtualFree(base, 0, MEM_RELEASE); }
+
+u8* MapFile(const char* path, u64* size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER fileSize;
+    u8* memory = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        // The view keeps the mapping alive, both handles can go right away
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mapping)
+        {
+            memory = (u8*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (u64)fileSize.QuadPart;
+    }
+    CloseHandle(file);
+    return memory;
+}
+
+void UnmapFile(u8* memory, u64 size) { UnmapViewOfFile(memory); }
+#else
+u8* ReserveVirtualMemory(u64 size, bool hugePages)
+{
+    const u64 alignment = hugePages ? HUGE_PAGE_SIZE : 0;
+    u8* memory = (u8*)mmap(nullptr, size + alignment, PROT_NONE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == (u8*)MAP_FAILED)
+        return nullptr;
+
+    if (!hugePages)
+        return memory;
+
+    // Cut the reservation down to a huge page aligned range so THP can back all of it
+    u8* aligned = (u8*)(((size_t)memory + alignment - 1) & ~(size_t)(alignment - 1));
+    if (aligned != memory)
+        munmap(memory, aligned - memory);
+    const u64 tail = (memory + size + alignment) - (aligned + size);
+    if (tail)
+        munmap(aligned + size, tail);
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+bool CommitVirtualMemory(u8* ptr, u64 size)
+{
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void ReleaseVirtualMemory(u8* base, u64 size) { munmap(base, size); }
+
+u8* MapFile(const char* path, u64* size)
+{
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+        return nullptr;
+
+    struct stat info;
+    u8* memory = nullptr;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        // The mapping keeps the file alive, the descriptor can go right away
+        memory = (u8*)mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                           file, 0);
+        if (memory == (u8*)MAP_FAILED)
+            memory = nullptr;
+        *size = (u64)info.st_size;
+    }
+    close(file);
+    return memory;
+}
+
+void UnmapFile(u8* memory, u64 size) { munmap(memory, size); }
+#endif
+}  // namespace DG
@@ -0,0 +1,26 @@
+/**
+ *  @file    VirtualMemory.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include "engine/Types.h"
+
+namespace DG
+{
+// Address space is reserved up front and only backed by physical memory once committed.
+// With hugePages the reservation is aligned to the huge page size and the kernel is asked to back
+// it with transparent huge pages (Linux only, ignored elsewhere).
+u8* ReserveVirtualMemory(u64 size, bool hugePages);
+bool CommitVirtualMemory(u8* ptr, u64 size);
+void ReleaseVirtualMemory(u8* base, u64 size);
+
+// Reserve sizes and commits are rounded to this
+u32 GetVirtualMemoryGranularity(bool hugePages);
+
+// Maps a whole file copy on write: the pages can be written to, the file itself never changes.
+// Null if the file can't be opened or is empty.
+u8* MapFile(const char* path, u64* size);
+void UnmapFile(u8* memory, u64 size);
+}  // namespace DG
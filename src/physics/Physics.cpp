@@ -23,7 +23,7 @@ class PhysicsMeshManager : public ResourceManager<physx::PxTriangleMesh*>
     void LoadOrGet(StringId id, physx::PxTriangleMesh* p) { Register(id, p); }
 };
 
-static std::unordered_map<PhysicsWorld*, PhysXScene> WorldToPhysX;
+static std::unordered_map<const PhysicsWorld*, PhysXScene> WorldToPhysX;
 
 static PhysicsMeshManager gPhysicsMeshManager;
 
@@ -259,6 +259,49 @@ void PhysicsWorld::RemoveModel(void* model)
     actor->release();
 }
 
+void PhysicsWorld::CloneStaticModelsInto(PhysicsWorld* target,
+                                         std::vector<std::pair<void*, void*>>* clones) const
+{
+    const auto scene = WorldToPhysX.at(this).Scene;
+    const auto targetScene = WorldToPhysX.at(target).Scene;
+
+    const physx::PxU32 count = scene->getNbActors(physx::PxActorTypeFlag::eRIGID_STATIC);
+    std::vector<physx::PxActor*> actors(count);
+    scene->getActors(physx::PxActorTypeFlag::eRIGID_STATIC, actors.data(), count);
+
+    std::vector<physx::PxRigidActor*> copies;
+    copies.reserve(count);
+    clones->reserve(clones->size() + count);
+    for (physx::PxActor* actor : actors)
+    {
+        // Without userData it is the ground plane, every scene makes its own
+        if (!actor->userData)
+            continue;
+
+        const physx::PxRigidStatic* original = actor->is<physx::PxRigidStatic>();
+        physx::PxRigidStatic* copy =
+            physx::PxCloneStatic(*gPhysics, original->getGlobalPose(), *original);
+        copy->userData = original->userData;
+        copies.push_back(copy);
+        clones->emplace_back(original->userData, copy);
+    }
+    if (copies.empty())
+        return;
+
+    // Building the scene query tree once beats inserting the actors one by one
+    physx::PxPruningStructure* pruningStructure =
+        gPhysics->createPruningStructure(copies.data(), (physx::PxU32)copies.size());
+    if (pruningStructure)
+    {
+        targetScene->addActors(*pruningStructure);
+        pruningStructure->release();
+    }
+    else
+    {
+        targetScene->addActors((physx::PxActor* const*)copies.data(), (physx::PxU32)copies.size());
+    }
+}
+
 bool InitPhysics()
 {
     gFoundation = PxCreateFoundation(PX_FOUNDATION_VERSION, gAllocator, gErrorCallback);
@@ -5,6 +5,8 @@
  */
 
 #pragma once
+#include <utility>
+#include <vector>
 #include "graphics/GraphicsSystem.h"
 #include "math/GLMInclude.h"
 #include "platform/Clock.h"
@@ -24,6 +26,11 @@ class PhysicsWorld
                          void* userData);
     void RemoveModel(void* model);
 
+    // Adds a copy of every model added with AddStaticModel to target in one go. The cooked meshes
+    // are shared. Appends userData and the copy of each model to clones.
+    void CloneStaticModelsInto(PhysicsWorld* target,
+                               std::vector<std::pair<void*, void*>>* clones) const;
+
    private:
     const Clock* _clock;
     bool _outputDebugLines = false;
@@ -15,8 +15,13 @@ bool BitScanForward(u64 toScan, u32 *index)
     char wasFound = _BitScanForward64(&idx, toScan);
     *index = idx;
     return wasFound == 1;
-#elif
-#error _BitScanForward64 functionality only implemented for windows
+#elif defined(__GNUC__) || defined(__clang__)
+    if (!toScan)
+        return false;
+    *index = (u32)__builtin_ctzll(toScan);
+    return true;
+#else
+#error BitScanForward not implemented for this compiler
 #endif  // defined(__WIN32__) || defined(__WINRT__)
 }
 }  // namespace DG
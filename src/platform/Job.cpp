@@ -6,96 +6,502 @@
 
 #include "Job.h"
 #include <SDL.h>
-#include <atomic>  // ToDo: Remove this!
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define DG_CPU_PAUSE() _mm_pause()
+#else
+#define DG_CPU_PAUSE()
+#endif
+#if DG_JOB_FIBERS
+#include <ucontext.h>
+#endif
 
 namespace DG
 {
-static const u32 JOB_COUNT = 4096;
-static const u32 JOB_MASK = JOB_COUNT - 1u;
+static const s64 INITIAL_QUEUE_SIZE = 1024;
+static const u32 JOB_BLOCK_SIZE = 512;
 
-thread_local u32 LocalJobBufferIndex = 0;
-thread_local Job LocalJobBuffer[JOB_COUNT];
-thread_local Job* LocalJobQueue[JOB_COUNT];
-thread_local JobSystem::JobWorkQueue LocalQueue(LocalJobQueue, JOB_COUNT);
+// Idle workers spin first, then yield their time slice and only then go to sleep
+static const u32 IDLE_SPIN_ROUNDS = 64;
+static const u32 IDLE_YIELD_ROUNDS = 16;
+#if DG_JOB_FIBERS
+// Upper bound on how long a finished job can wait for its parked fiber to be resumed
+static const u32 PARKED_FIBER_SLEEP_MILLISECONDS = 1;
+#endif
 
-bool g_JobQueueShutdownRequested = false;
+// A worker prefers a waiting background job after running this many normal ones in a row
+static const u32 BACKGROUND_AGING_JOBS = 32;
 
-static JobSystem::JobWorkQueue* _queues[64];
+static const u32 PRIORITY_COUNT = (u32)JobPriority::Count;
+
+// Every thread owns a pool, jobs always return to the pool they were taken from
+struct JobPool
+{
+    Job* Allocate();
+    void Free(Job* job);
+
+    Job* FreeList = nullptr;                    // Owning thread only
+    std::atomic<Job*> RemoteFreeList{nullptr};  // Pushed to by every other thread
+};
+
+// Everything other threads need to know about a worker, one cache line each
+struct alignas(64) WorkerSlot
+{
+    JobSystem::JobWorkQueue* Queues[PRIORITY_COUNT] = {};
+    SDL_sem* Semaphore = nullptr;
+    std::atomic<bool> IsSleeping{false};
+
+    // Only written by the owning worker
+    std::atomic<u32> StealAttempts{0};
+    std::atomic<u32> StealSuccesses{0};
+
+    u32 NormalJobsSinceBackground = 0;
+};
+
+thread_local JobPool LocalJobPool;
+thread_local JobSystem::JobWorkQueue LocalQueues[PRIORITY_COUNT];
+thread_local WorkerSlot* LocalWorker = nullptr;
+thread_local u32 LocalRandomState = 0x9E3779B9;
+thread_local JobPriority LocalPriority = JobPriority::Normal;  // Of the job running right now
+thread_local bool LocalIsSubmitThread = false;  // Never steals, see RegisterSubmitThread
+
+std::atomic<bool> g_JobQueueShutdownRequested{false};
+
+static WorkerSlot _workers[64];
 static SDL_mutex* _mutex = SDL_CreateMutex();
-static SDL_cond* _cond = SDL_CreateCond();
-static s32 _workerCount = 0;
-static SDL_atomic_t _jobCount;
-JobSystem::JobWorkQueue::JobWorkQueue(Job** queue, u32 size) : _jobs(queue), _size(size) {}
+static std::atomic<s32> _workerCount{0};
+static std::atomic<s32> _runnableJobCount{0};  // Jobs sitting in any queue
+static std::atomic<s32> _runnableCriticalCount{0};
+static std::atomic<s32> _runnableBackgroundCount{0};
+static std::atomic<s32> _runningBackgroundCount{0};
+static std::atomic<s32> _sleepingCount{0};
+static std::atomic<u32> _wakeUps{0};
+
+// xorshift32, rand() takes a lock on some CRTs
+static u32 NextRandom()
+{
+    u32 x = LocalRandomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    LocalRandomState = x;
+    return x;
+}
+
+static void IncrementCounter(std::atomic<u32>& counter)
+{
+    // Single writer, no need for a locked add
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+#if DG_JOB_FIBERS
+// Fibers are only ever resumed on the thread that parked them. Thread locals stay valid across a
+// switch that way and none of the lists below need any synchronization.
+struct Fiber
+{
+    ucontext_t Context;
+    u8* Stack = nullptr;
+    Job* WaitingOn = nullptr;
+    Fiber* Next = nullptr;
+};
+
+thread_local Fiber LocalThreadFiber;  // The stack the thread was started on
+thread_local Fiber* LocalCurrentFiber = nullptr;
+thread_local Fiber* LocalFreeFibers = nullptr;
+thread_local Fiber* LocalWaitingFibers = nullptr;
+
+static FiberConfig _fiberConfig;
+static bool _isFiberPoolEnabled = false;
+static std::atomic<bool> _useFibers{false};
+static std::atomic<u32> _fiberFallbackWaits{0};
+
+static Fiber* GetCurrentFiber() { return LocalCurrentFiber ? LocalCurrentFiber : &LocalThreadFiber; }
+
+static void SwitchToFiber(Fiber* from, Fiber* to)
+{
+    LocalCurrentFiber = to;
+    swapcontext(&from->Context, &to->Context);
+}
+
+static Fiber* TakeReadyFiber()
+{
+    Fiber** link = &LocalWaitingFibers;
+    while (*link)
+    {
+        Fiber* fiber = *link;
+        if (fiber->WaitingOn->CheckIsDone())
+        {
+            *link = fiber->Next;
+            fiber->WaitingOn = nullptr;
+            return fiber;
+        }
+        link = &fiber->Next;
+    }
+    return nullptr;
+}
 
-Job* JobSystem::JobWorkQueue::GetJob()
+static bool HasParkedFibers() { return LocalWaitingFibers != nullptr; }
+
+// Same rule as Wait, a job waited on by a parked fiber must not sit behind seconds of background
+// work. Only allowed if every parked fiber waits on background work itself.
+static bool CanTakeBackgroundJobs()
+{
+    for (Fiber* fiber = LocalWaitingFibers; fiber; fiber = fiber->Next)
+    {
+        if (fiber->WaitingOn->priority != JobPriority::Background)
+            return false;
+    }
+    return true;
+}
+
+// Hands the thread to a parked fiber whose job is done. The current fiber goes to the free list,
+// it only ever gets switched away from inside a worker loop and continues that loop once picked.
+static bool ResumeReadyFiber()
+{
+    Fiber* ready = TakeReadyFiber();
+    if (!ready)
+        return false;
+
+    Fiber* self = GetCurrentFiber();
+    self->Next = LocalFreeFibers;
+    LocalFreeFibers = self;
+    const JobPriority priority = LocalPriority;
+    SwitchToFiber(self, ready);
+    LocalPriority = priority;
+    return true;
+}
+
+// Worker loop of every pool fiber. Never returns, only the stack the thread was started on can
+// leave the worker loop. Once shutdown is requested and nothing is parked anymore that stack is
+// sitting in the free list and takes the thread back.
+void JobSystem::FiberMain()
 {
-    Job* job = Pop();
+    u32 idleRounds = 0;
+    while (true)
+    {
+        if (g_JobQueueShutdownRequested.load(std::memory_order_relaxed) && !LocalWaitingFibers)
+        {
+            Fiber** link = &LocalFreeFibers;
+            while (*link != &LocalThreadFiber) link = &(*link)->Next;
+            *link = LocalThreadFiber.Next;
+
+            Fiber* self = GetCurrentFiber();
+            self->Next = LocalFreeFibers;
+            LocalFreeFibers = self;
+            SwitchToFiber(self, &LocalThreadFiber);
+            continue;
+        }
+        RunWorkerStep(&idleRounds);
+    }
+}
+
+static void CreateFiberPool(void (*fiberMain)())
+{
+    for (u32 i = 0; i < _fiberConfig.FibersPerWorker; ++i)
+    {
+        // Fibers live as long as the thread does, same as the job blocks
+        Fiber* fiber = new Fiber();
+        fiber->Stack = new u8[_fiberConfig.StackSize];
+        getcontext(&fiber->Context);
+        fiber->Context.uc_stack.ss_sp = fiber->Stack;
+        fiber->Context.uc_stack.ss_size = _fiberConfig.StackSize;
+        fiber->Context.uc_link = nullptr;
+        makecontext(&fiber->Context, fiberMain, 0);
+
+        fiber->Next = LocalFreeFibers;
+        LocalFreeFibers = fiber;
+    }
+}
+
+// Parks whatever runs right now and lets a fresh fiber take over this thread until job is done
+static void ParkUntilDone(Job* job)
+{
+    Fiber* self = GetCurrentFiber();
+    self->WaitingOn = job;
+    self->Next = LocalWaitingFibers;
+    LocalWaitingFibers = self;
+
+    Fiber* next = LocalFreeFibers;
+    LocalFreeFibers = next->Next;
+    const JobPriority priority = LocalPriority;
+    SwitchToFiber(self, next);
+    LocalPriority = priority;
+    Assert(job->CheckIsDone());
+}
+#else
+static bool HasParkedFibers() { return false; }
+static bool CanTakeBackgroundJobs() { return true; }
+#endif
+
+Job* JobPool::Allocate()
+{
+    Job* job = FreeList;
+    if (!job)
+    {
+        // Take everything other threads gave back in one go, no ABA since we never pop singles
+        job = RemoteFreeList.exchange(nullptr, std::memory_order_acquire);
+    }
     if (!job)
     {
-        // Steal Job
-        u32 index = rand() % _workerCount;
-        JobWorkQueue* queueToStealFrom = _queues[index];
-        if (&LocalQueue != queueToStealFrom)
+        // Blocks live as long as the thread does, which for workers is the whole program
+        Job* block = new Job[JOB_BLOCK_SIZE];
+        for (u32 i = 0; i < JOB_BLOCK_SIZE - 1; ++i)
+        {
+            block[i].parent = &block[i + 1];
+        }
+        block[JOB_BLOCK_SIZE - 1].parent = nullptr;
+        job = block;
+    }
+    FreeList = job->parent;
+    return job;
+}
+
+void JobPool::Free(Job* job)
+{
+    if (this == &LocalJobPool)
+    {
+        job->parent = FreeList;
+        FreeList = job;
+        return;
+    }
+
+    Job* head = RemoteFreeList.load(std::memory_order_relaxed);
+    do
+    {
+        job->parent = head;
+    } while (!RemoteFreeList.compare_exchange_weak(head, job, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+}
+
+static void WakeWorker()
+{
+    // One job, one worker. Start somewhere random so the same worker is not always picked
+    const u32 workerCount = (u32)_workerCount.load(std::memory_order_acquire);
+    if (workerCount == 0)
+        return;
+    const u32 start = NextRandom() % workerCount;
+    for (u32 i = 0; i < workerCount; ++i)
+    {
+        WorkerSlot& worker = _workers[(start + i) % workerCount];
+        if (!worker.IsSleeping.load(std::memory_order_relaxed))
+            continue;
+
+        if (worker.IsSleeping.exchange(false, std::memory_order_acq_rel))
+        {
+            _sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+            _wakeUps.fetch_add(1, std::memory_order_relaxed);
+            SDL_SemPost(worker.Semaphore);
+            return;
+        }
+    }
+}
+
+static void ReleaseBackgroundSlot()
+{
+    // Workers that went to sleep because the limit was reached would miss the free slot
+    _runningBackgroundCount.fetch_sub(1, std::memory_order_seq_cst);
+    if (_runnableBackgroundCount.load(std::memory_order_relaxed) > 0 &&
+        _sleepingCount.load(std::memory_order_seq_cst) > 0)
+        WakeWorker();
+}
+
+static void Execute(Job* job)
+{
+    // The job is gone after Finish, keep what we need
+    const JobPriority priority = job->priority;
+    const JobPriority previousPriority = LocalPriority;
+    LocalPriority = priority;
+
+    job->function(job, job->data);
+    JobSystem::Finish(job);
+
+    LocalPriority = previousPriority;
+    if (priority == JobPriority::Background)
+        ReleaseBackgroundSlot();
+}
+
+static s32 GetMaxRunningBackgroundJobs()
+{
+    // Always leave half the workers for frame work, background jobs can run for seconds
+    const s32 maxRunning = _workerCount.load(std::memory_order_relaxed) / 2;
+    return maxRunning > 0 ? maxRunning : 1;
+}
+
+Job* JobSystem::TakeJob(JobPriority priority)
+{
+    JobWorkQueue& localQueue = LocalQueues[(u32)priority];
+    Job* job = localQueue.Pop();
+    const u32 workerCount = (u32)_workerCount.load(std::memory_order_acquire);
+    if (!job && workerCount > 0 && !LocalIsSubmitThread)
+    {
+        // Steal Job, never from ourselves
+        u32 index = NextRandom() % workerCount;
+        if (_workers[index].Queues[(u32)priority] == &localQueue)
+            index = (index + 1) % workerCount;
+
+        JobWorkQueue* queueToStealFrom = _workers[index].Queues[(u32)priority];
+        if (&localQueue != queueToStealFrom)
         {
             job = queueToStealFrom->Steal();
+            if (LocalWorker)
+            {
+                IncrementCounter(LocalWorker->StealAttempts);
+                if (job)
+                    IncrementCounter(LocalWorker->StealSuccesses);
+            }
         }
     }
+    if (job)
+        _runnableJobCount.fetch_sub(1, std::memory_order_relaxed);
     return job;
 }
 
+Job* JobSystem::TakeBackgroundJob()
+{
+    if (_runnableBackgroundCount.load(std::memory_order_relaxed) == 0 ||
+        _runnableCriticalCount.load(std::memory_order_acquire) != 0)
+        return nullptr;
+
+    // Reserve a slot first so concurrent workers can not overshoot the limit
+    if (_runningBackgroundCount.fetch_add(1, std::memory_order_acq_rel) >=
+        GetMaxRunningBackgroundJobs())
+    {
+        _runningBackgroundCount.fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = TakeJob(JobPriority::Background);
+    if (!job)
+    {
+        _runningBackgroundCount.fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    _runnableBackgroundCount.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+static Job* CreateJobInternal(Job* parent, JobFunction function, JobPriority priority)
+{
+    Job* job = LocalJobPool.Allocate();
+    Assert(job->unfinishedJobs.load(std::memory_order_relaxed) == 0);
+
+    job->function = function;
+    job->parent = parent;
+    job->pool = &LocalJobPool;
+    job->priority = priority;
+    job->isDetached = false;
+    job->unfinishedJobs.store(1, std::memory_order_relaxed);
+    SDL_memset(&job->data, 0, COUNT_OF(job->data));
+
+    return job;
+}
+
+JobSystem::JobWorkQueue::CircularArray::CircularArray(s64 capacity, CircularArray* previous)
+    : Capacity(capacity), Mask(capacity - 1), Jobs(new std::atomic<Job*>[capacity]),
+      Previous(previous)
+{
+    Assert((capacity & Mask) == 0);  // Power of two
+}
+
+JobSystem::JobWorkQueue::CircularArray::~CircularArray()
+{
+    delete[] Jobs;
+    delete Previous;
+}
+
+Job* JobSystem::JobWorkQueue::CircularArray::Get(s64 index) const
+{
+    return Jobs[index & Mask].load(std::memory_order_relaxed);
+}
+
+void JobSystem::JobWorkQueue::CircularArray::Put(s64 index, Job* job)
+{
+    Jobs[index & Mask].store(job, std::memory_order_relaxed);
+}
+
+JobSystem::JobWorkQueue::CircularArray* JobSystem::JobWorkQueue::CircularArray::Grow(s64 bottom,
+                                                                                       s64 top)
+{
+    CircularArray* result = new CircularArray(Capacity * 2, this);
+    for (s64 i = top; i < bottom; ++i)
+    {
+        result->Put(i, Get(i));
+    }
+    return result;
+}
+
+JobSystem::JobWorkQueue::JobWorkQueue() : _array(new CircularArray(INITIAL_QUEUE_SIZE, nullptr))
+{
+}
+
+JobSystem::JobWorkQueue::~JobWorkQueue() { delete _array.load(std::memory_order_relaxed); }
+
 void JobSystem::JobWorkQueue::Push(Job* job)
 {
-    s32 t = _top;
-    _jobs[t & JOB_MASK] = job;
+    const s64 b = _bottom.load(std::memory_order_relaxed);
+    const s64 t = _top.load(std::memory_order_acquire);
+    CircularArray* array = _array.load(std::memory_order_relaxed);
 
-    SDL_CompilerBarrier();
+    if (b - t > array->Capacity - 1)
+    {
+        // Full, old array stays alive for any stealer still reading from it
+        array = array->Grow(b, t);
+        _array.store(array, std::memory_order_release);
+    }
 
-    _top = t + 1;
+    // Release publishes the slot (and the job contents) to any stealer acquiring _bottom
+    array->Put(b, job);
+    _bottom.store(b + 1, std::memory_order_release);
 }
 
 Job* JobSystem::JobWorkQueue::Pop()
 {
-    s32 t = _top - 1;
-    _top = t;
+    const s64 b = _bottom.load(std::memory_order_relaxed) - 1;
+    CircularArray* array = _array.load(std::memory_order_relaxed);
+    _bottom.store(b, std::memory_order_relaxed);
 
-    SDL_CompilerBarrier();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    s32 b = SDL_AtomicGet(&_bottom);
+    s64 t = _top.load(std::memory_order_relaxed);
 
     // Empty queue
-    if (b > t)
+    if (t > b)
     {
-        _top = b;
+        _bottom.store(b + 1, std::memory_order_relaxed);
         return nullptr;
     }
 
     // not empty
-    Job* job = _jobs[t & JOB_MASK];
+    Job* job = array->Get(b);
 
     // Not Last Item
-    if (b != t)
+    if (t != b)
         return job;
 
     // Check if a steal operation got there before us
-    if (!SDL_AtomicCAS(&_bottom, b, b + 1))
+    if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
         job = nullptr;  // Someone stole the job
 
-    _top = b + 1;
+    _bottom.store(b + 1, std::memory_order_relaxed);
     return job;
 }
 
 Job* JobSystem::JobWorkQueue::Steal()
 {
-    long b = SDL_AtomicGet(&_bottom);
+    s64 t = _top.load(std::memory_order_acquire);
 
-    SDL_CompilerBarrier();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    long t = _top;
-    if (b < t)
+    const s64 b = _bottom.load(std::memory_order_acquire);
+    if (t < b)
     {
         // non-empty queue
-        Job* job = _jobs[b & JOB_MASK];
-        if (SDL_AtomicCAS(&_bottom, b, b + 1))
+        CircularArray* array = _array.load(std::memory_order_acquire);
+        Job* job = array->Get(t);
+        if (_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
         {
             return job;
         }
@@ -105,75 +511,224 @@ Job* JobSystem::JobWorkQueue::Steal()
 
 void JobSystem::Finish(Job* job)
 {
-    const s32 unfinishedJobs = SDL_AtomicAdd(&job->unfinishedJobs, -1);
-    if (unfinishedJobs == 1)
+    // Walk up the tree iteratively, deep job trees would otherwise recurse just as deep
+    while (job)
     {
-        if (job->parent)
-        {
-            Finish(job->parent);
-        }
-        SDL_AtomicAdd(&_jobCount, -1);
+        // Read before the decrement, a finished root job can be recycled by its waiter right away
+        Job* parent = job->parent;
+        const bool isDetached = job->isDetached;
+        const s32 unfinishedJobs = job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel);
+        if (unfinishedJobs != 1)
+            return;
+
+        if (parent || isDetached)
+            ReleaseJob(job);
+        job = parent;
     }
 }
 
-bool Job::CheckIsDone() { return SDL_AtomicGet(&unfinishedJobs) == 0; }
+bool Job::CheckIsDone() const { return unfinishedJobs.load(std::memory_order_acquire) == 0; }
 
 Job* JobSystem::CreateJob(JobFunction function)
 {
-    u32 index = LocalJobBufferIndex & JOB_MASK;
-    ++LocalJobBufferIndex;
-    Job& job = LocalJobBuffer[index];
-    Assert(SDL_AtomicGet(&job.unfinishedJobs) == 0);
-    job.function = function;
-    job.parent = nullptr;
-    SDL_AtomicSet(&job.unfinishedJobs, 1);
-    SDL_memset(&job.data, 0, COUNT_OF(job.data));
+    return CreateJobInternal(nullptr, function, LocalPriority);
+}
 
-    return &job;
+Job* JobSystem::CreateJob(JobFunction function, JobPriority priority)
+{
+    return CreateJobInternal(nullptr, function, priority);
 }
 
 Job* JobSystem::CreateJobAsChild(Job* parent, JobFunction function)
 {
-    SDL_AtomicAdd(&parent->unfinishedJobs, 1);
+    // Publishing happens through Run, the release there orders this increment
+    parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+    return CreateJobInternal(parent, function, parent->priority);
+}
 
-    u32 index = LocalJobBufferIndex & JOB_MASK;
-    ++LocalJobBufferIndex;
-    Job& job = LocalJobBuffer[index];
+void JobSystem::Wait(Job* job)
+{
+    // Children are recycled as soon as they finish, only root jobs can be waited on
+    Assert(!job->parent && !job->isDetached);
+
+    // A waiting background job gives up its slot. Once every slot is held by a waiter nobody could
+    // run their children otherwise. Taking it back afterwards may overshoot the limit for a bit.
+    const bool releasesBackgroundSlot =
+        LocalPriority == JobPriority::Background && !job->CheckIsDone();
+    if (releasesBackgroundSlot)
+        ReleaseBackgroundSlot();
+
+#if DG_JOB_FIBERS
+    if (!job->CheckIsDone() && _useFibers.load(std::memory_order_relaxed) && !LocalIsSubmitThread)
+    {
+        // Out of fibers, fall back to running jobs on top of our own stack
+        if (LocalFreeFibers)
+            ParkUntilDone(job);
+        else
+            _fiberFallbackWaits.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
 
-    Assert(SDL_AtomicGet(&job.unfinishedJobs) == 0);
+    // wait until the job has completed. in the meantime, work on any other job. Only someone
+    // explicitly waiting on background work may pick it up, otherwise it could block for seconds
+    const bool allowBackground = job->priority == JobPriority::Background && !LocalIsSubmitThread;
+    while (!job->CheckIsDone())
+    {
+        Job* jobToBeDone = GetJob(allowBackground);
+        if (jobToBeDone)
+            Execute(jobToBeDone);
+        else
+            DG_CPU_PAUSE();
+    }
+    if (releasesBackgroundSlot)
+        _runningBackgroundCount.fetch_add(1, std::memory_order_relaxed);
+    ReleaseJob(job);
+}
 
-    job.function = function;
-    job.parent = parent;
-    SDL_AtomicSet(&job.unfinishedJobs, 1);
-    SDL_memset(&job.data, 0, COUNT_OF(job.data));
+bool JobSystem::RunPendingJob()
+{
+    Job* job = GetJob(false);
+    if (!job)
+        return false;
 
-    return &job;
+    Execute(job);
+    return true;
 }
 
-void JobSystem::Wait(Job* job)
+Job* JobSystem::GetJob(bool allowBackground)
 {
-    // wait until the job has completed. in the meantime, work on any other job.
-    while (!job->CheckIsDone())
+    Job* job = TakeJob(JobPriority::FrameCritical);
+    if (job)
     {
-        Job* jobToBeDone = LocalQueue.GetJob();
-        if (jobToBeDone)
+        _runnableCriticalCount.fetch_sub(1, std::memory_order_release);
+        return job;
+    }
+
+    if (!allowBackground)
+        return TakeJob(JobPriority::Normal);
+
+    // Aging, a steady stream of normal jobs must not starve background work forever
+    u32* normalJobsSinceBackground = LocalWorker ? &LocalWorker->NormalJobsSinceBackground : nullptr;
+    if (normalJobsSinceBackground && *normalJobsSinceBackground >= BACKGROUND_AGING_JOBS)
+    {
+        job = TakeBackgroundJob();
+        if (job)
         {
-            jobToBeDone->function(jobToBeDone, jobToBeDone->data);
-            Finish(jobToBeDone);
+            *normalJobsSinceBackground = 0;
+            return job;
         }
     }
+
+    job = TakeJob(JobPriority::Normal);
+    if (job)
+    {
+        if (normalJobsSinceBackground)
+            ++*normalJobsSinceBackground;
+        return job;
+    }
+
+    job = TakeBackgroundJob();
+    if (job && normalJobsSinceBackground)
+        *normalJobsSinceBackground = 0;
+    return job;
 }
 
 void JobSystem::Run(Job* job)
 {
-    LocalQueue.Push(job);
-    s32 prev = SDL_AtomicAdd(&_jobCount, 1);
-    if (prev == 0)
+    if (job->priority == JobPriority::FrameCritical)
+        _runnableCriticalCount.fetch_add(1, std::memory_order_relaxed);
+    else if (job->priority == JobPriority::Background)
+        _runnableBackgroundCount.fetch_add(1, std::memory_order_relaxed);
+    LocalQueues[(u32)job->priority].Push(job);
+
+    // Pairs with the sleeping worker checking _runnableJobCount after announcing itself. One of
+    // the two always sees the other, so a job can never be left behind with everyone asleep.
+    _runnableJobCount.fetch_add(1, std::memory_order_seq_cst);
+    if (_sleepingCount.load(std::memory_order_seq_cst) > 0)
+        WakeWorker();
+}
+
+void JobSystem::RunDetached(Job* job)
+{
+    Assert(!job->parent);
+    job->isDetached = true;
+    Run(job);
+}
+
+void JobSystem::Sleep()
+{
+    Assert(LocalWorker);
+    WorkerSlot& worker = *LocalWorker;
+    worker.IsSleeping.store(true, std::memory_order_seq_cst);
+    _sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+
+    // Background jobs over the limit do not count, finishing a running one wakes a worker
+    s32 runnableJobCount = _runnableJobCount.load(std::memory_order_seq_cst);
+    if (_runningBackgroundCount.load(std::memory_order_seq_cst) >= GetMaxRunningBackgroundJobs())
+        runnableJobCount -= _runnableBackgroundCount.load(std::memory_order_relaxed);
+
+    if (runnableJobCount <= 0 && !g_JobQueueShutdownRequested.load(std::memory_order_acquire))
     {
-        SDL_LockMutex(_mutex);
-        SDL_CondBroadcast(_cond);
-        SDL_UnlockMutex(_mutex);
+#if DG_JOB_FIBERS
+        // Nobody is told when the job of a parked fiber finishes, look again every now and then
+        if (LocalWaitingFibers)
+        {
+            if (SDL_SemWaitTimeout(worker.Semaphore, PARKED_FIBER_SLEEP_MILLISECONDS) == 0)
+                return;
+        }
+        else
+#endif
+        {
+            // Whoever wakes us already took us out of the sleeping set
+            SDL_SemWait(worker.Semaphore);
+            return;
+        }
+    }
+
+    // Work showed up in the meantime or we timed out, back out. If a waker beat us to it, eat its
+    // post.
+    if (worker.IsSleeping.exchange(false, std::memory_order_acq_rel))
+        _sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+    else
+        SDL_SemWait(worker.Semaphore);
+}
+
+void JobSystem::Shutdown()
+{
+    g_JobQueueShutdownRequested.store(true, std::memory_order_release);
+
+    const s32 workerCount = _workerCount.load(std::memory_order_acquire);
+    for (s32 i = 0; i < workerCount; ++i)
+    {
+        if (_workers[i].IsSleeping.exchange(false, std::memory_order_acq_rel))
+        {
+            _sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+            SDL_SemPost(_workers[i].Semaphore);
+        }
+    }
+}
+
+JobStats JobSystem::GetStats()
+{
+    JobStats stats = {};
+    stats.WakeUps = _wakeUps.load(std::memory_order_relaxed);
+#if DG_JOB_FIBERS
+    stats.FiberFallbackWaits = _fiberFallbackWaits.load(std::memory_order_relaxed);
+#endif
+
+    const s32 workerCount = _workerCount.load(std::memory_order_acquire);
+    for (s32 i = 0; i < workerCount; ++i)
+    {
+        stats.StealAttempts += _workers[i].StealAttempts.load(std::memory_order_relaxed);
+        stats.StealSuccesses += _workers[i].StealSuccesses.load(std::memory_order_relaxed);
     }
+    return stats;
+}
+
+void JobSystem::ReleaseJob(Job* job)
+{
+    Assert(job->CheckIsDone());
+    job->pool->Free(job);
 }
 
 void JobSystem::CreateAndRegisterWorker()
@@ -181,38 +736,122 @@ void JobSystem::CreateAndRegisterWorker()
     SDL_CreateThread(JobQueueWorkerFunction, "Worker", nullptr);
 }
 
-bool JobSystem::RegisterWorker()
+void JobSystem::InitFibers(const FiberConfig& config)
+{
+#if DG_JOB_FIBERS
+    Assert(_workerCount.load(std::memory_order_relaxed) == 0);
+    Assert(config.FibersPerWorker > 0 && config.StackSize >= 16 * 1024);
+    _fiberConfig = config;
+    _isFiberPoolEnabled = true;
+    _useFibers.store(true, std::memory_order_relaxed);
+#endif
+}
+
+void JobSystem::SetUseFibers(bool useFibers)
+{
+#if DG_JOB_FIBERS
+    _useFibers.store(useFibers && _isFiberPoolEnabled, std::memory_order_relaxed);
+#endif
+}
+
+bool JobSystem::IsUsingFibers()
+{
+#if DG_JOB_FIBERS
+    return _useFibers.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+static bool RegisterWorkerSlot()
 {
     SDL_LockMutex(_mutex);
 
-    if (_workerCount >= COUNT_OF(_queues))
+    const s32 workerCount = _workerCount.load(std::memory_order_relaxed);
+    if (workerCount >= COUNT_OF(_workers))
     {
         Assert(false);
+        SDL_UnlockMutex(_mutex);
         return false;
     }
-    _queues[_workerCount++] = &LocalQueue;
+    // Publish the slot before the count so stealers never see an empty one
+    WorkerSlot& worker = _workers[workerCount];
+    for (u32 i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        worker.Queues[i] = &LocalQueues[i];
+    }
+    worker.Semaphore = SDL_CreateSemaphore(0);
+    LocalWorker = &worker;
+    LocalRandomState = 0x9E3779B9u * (u32)(workerCount + 1);
+    _workerCount.store(workerCount + 1, std::memory_order_release);
     SDL_UnlockMutex(_mutex);
     return true;
 }
 
+bool JobSystem::RegisterWorker()
+{
+    if (!RegisterWorkerSlot())
+        return false;
+#if DG_JOB_FIBERS
+    if (_isFiberPoolEnabled)
+        CreateFiberPool(FiberMain);
+#endif
+    return true;
+}
+
+bool JobSystem::RegisterSubmitThread()
+{
+    // No fiber pool, a parked wait would have the pool fibers run anybody's jobs
+    LocalIsSubmitThread = true;
+    return RegisterWorkerSlot();
+}
+
 void JobSystem::RunCurrentThreadAsWorker() { RunWorker(); }
 
+s32 JobSystem::GetWorkerCount() { return _workerCount.load(std::memory_order_acquire); }
+
 void JobSystem::RunWorker()
 {
-    while (!g_JobQueueShutdownRequested)
+    // Parked fibers still have to finish what they started, their jobs are waited on
+    u32 idleRounds = 0;
+    while (!g_JobQueueShutdownRequested.load(std::memory_order_relaxed) || HasParkedFibers())
     {
-        Job* job = LocalQueue.GetJob();
-        if (job)
-        {
-            job->function(job, job->data);
-            Finish(job);
-        }
-        if (SDL_AtomicGet(&_jobCount) == 0)
-        {
-            SDL_LockMutex(_mutex);
-            SDL_CondWait(_cond, _mutex);
-            SDL_UnlockMutex(_mutex);
-        }
+        RunWorkerStep(&idleRounds);
+    }
+}
+
+void JobSystem::RunWorkerStep(u32* idleRounds)
+{
+#if DG_JOB_FIBERS
+    // Parked fibers go first, whatever they were doing is older than any new job
+    if (ResumeReadyFiber())
+    {
+        *idleRounds = 0;
+        return;
+    }
+#endif
+
+    Job* job = GetJob(CanTakeBackgroundJobs());
+    if (job)
+    {
+        Execute(job);
+        *idleRounds = 0;
+        return;
+    }
+
+    ++*idleRounds;
+    if (*idleRounds < IDLE_SPIN_ROUNDS)
+    {
+        DG_CPU_PAUSE();
+    }
+    else if (*idleRounds < IDLE_SPIN_ROUNDS + IDLE_YIELD_ROUNDS)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        Sleep();
+        *idleRounds = 0;
     }
 }
 
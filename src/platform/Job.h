@@ -5,63 +5,261 @@
  */
 
 #pragma once
+#include <atomic>
+#include <type_traits>
 #include "engine/Types.h"
 
+// Optional fiber backend, Wait parks the waiting job instead of running other jobs on its stack
+#ifndef DG_JOB_FIBERS
+#define DG_JOB_FIBERS 0
+#endif
+#if DG_JOB_FIBERS && !defined(__linux__)
+#error DG_JOB_FIBERS is only implemented on top of ucontext on Linux
+#endif
+
 namespace DG
 {
-extern bool g_JobQueueShutdownRequested;
+extern std::atomic<bool> g_JobQueueShutdownRequested;
 
 struct Job;
+struct JobPool;
 typedef void (*JobFunction)(Job*, const void*);
 
-struct Job
+// Background jobs never start while frame critical ones are queued and are only picked up by
+// idle workers, never by a thread helping out in Wait. They can not take every worker either,
+// background jobs waiting on others don't count.
+enum class JobPriority : u8
+{
+    FrameCritical,
+    Normal,
+    Background,
+    Count
+};
+
+struct alignas(64) Job
 {
     JobFunction function;
-    Job* parent;
-    SDL_atomic_t unfinishedJobs{0};
-    char data[12];  // Padded to be 32 byte in size!
-    bool CheckIsDone();
+    Job* parent;  // Doubles as the free list link while the job sits in its pool
+    JobPool* pool;
+    char data[34];  // Padded to be one cache line in size!
+    JobPriority priority;
+    bool isDetached;  // Root job nobody waits on, recycled once it finishes
+    std::atomic<s32> unfinishedJobs{0};
+    bool CheckIsDone() const;
+};
+static_assert(sizeof(Job) == 64, "sizeof(Job) needs to be exactly one cache line");
+
+// Totals since startup, diff two snapshots to get per frame numbers
+struct JobStats
+{
+    u32 WakeUps;
+    u32 StealAttempts;
+    u32 StealSuccesses;
+    u32 FiberFallbackWaits;  // Waits that had no free fiber and ran jobs on their own stack
+};
+
+struct FiberConfig
+{
+    u32 FibersPerWorker = 64;
+    u32 StackSize = 64 * 1024;
 };
-static_assert((sizeof(Job::function) + sizeof(Job::parent) + sizeof(Job::unfinishedJobs) +
-               sizeof(Job::data)) == 32,
-              "sizeof(Job) needs to be a multiple of 32Bytes");
 
 class JobSystem
 {
    public:
+    // Root jobs are returned to their pool by Wait, or once they finish when run detached. Child
+    // jobs are recycled once they finish.
+    // Without a priority jobs inherit the one of the job running on this thread (or Normal),
+    // children always inherit the one of their parent.
     static Job* CreateJob(JobFunction function);
+    static Job* CreateJob(JobFunction function, JobPriority priority);
     static Job* CreateJobAsChild(Job* parent, JobFunction function);
 
     static void Wait(Job* job);
     static void Run(Job* job);
+    // For root jobs that are never waited on, the job must not be touched afterwards
+    static void RunDetached(Job* job);
     static void Finish(Job* job);
 
+    // Executes one job from this threads queue or a stolen one, false if there was nothing to do
+    static bool RunPendingJob();
+
     static void CreateAndRegisterWorker();
     static bool RegisterWorker();
+    // For threads like the renderer that hand out work but must not be held up by anyone else's.
+    // Workers steal its jobs, in Wait it only runs jobs of its own queue and spins otherwise.
+    static bool RegisterSubmitThread();
 
     static void RunCurrentThreadAsWorker();
+    static s32 GetWorkerCount();
 
+    // Sets g_JobQueueShutdownRequested and wakes every sleeping worker so it can exit
+    static void Shutdown();
+    static JobStats GetStats();
+
+    // Every worker registered afterwards gets its own fiber pool, does nothing without DG_JOB_FIBERS
+    static void InitFibers(const FiberConfig& config);
+    static void SetUseFibers(bool useFibers);
+    static bool IsUsingFibers();
+
+    // Calls function(index) for every index in [0, count), returns once all of them ran.
+    // A grainSize of 0 picks one based on the worker count.
+    template <typename Function>
+    static void ParallelFor(u32 count, u32 grainSize, const Function& function);
+
+    // Same as ParallelFor but calls function(begin, end) once per split range
+    template <typename Function>
+    static void ParallelForRange(u32 count, u32 grainSize, const Function& function);
+
+    // Chase-Lev work stealing deque. Push/Pop are owner only, Steal may be called by anyone.
     class JobWorkQueue
     {
         friend class JobSystem;
 
        public:
-        JobWorkQueue(Job** queue, u32 size);
-        Job* GetJob();
+        JobWorkQueue();
+        ~JobWorkQueue();
 
        private:
+        struct CircularArray
+        {
+            CircularArray(s64 capacity, CircularArray* previous);
+            ~CircularArray();
+
+            Job* Get(s64 index) const;
+            void Put(s64 index, Job* job);
+            CircularArray* Grow(s64 bottom, s64 top);
+
+            s64 Capacity;
+            s64 Mask;
+            std::atomic<Job*>* Jobs;
+            CircularArray* Previous;  // Kept alive as stealers might still read from it
+        };
+
         void Push(Job* job);
         Job* Pop();
         Job* Steal();
 
-        Job** _jobs;
-        u32 _size;
-        SDL_atomic_t _bottom;
-        s32 _top = 0;
+        alignas(64) std::atomic<s64> _top{0};
+        alignas(64) std::atomic<s64> _bottom{0};
+        std::atomic<CircularArray*> _array;
     };
 
    private:
+    struct ParallelForData
+    {
+        enum : u32
+        {
+            InlineFunctionSize = 16
+        };
+
+        // Small trivially copyable callables live in the job itself, everything else is
+        // referenced from the stack of the caller, which waits for the whole range anyway.
+        alignas(8) u8 Function[InlineFunctionSize];
+        u32 Begin;
+        u32 End;
+        u32 GrainSize;
+    };
+    static_assert(sizeof(ParallelForData) <= sizeof(Job::data), "ParallelForData too big");
+
+    template <typename Function>
+    static constexpr bool IsFunctionInline();
+
+    template <typename Function>
+    static void ParallelForJob(Job* job, const void* data);
+
+    static Job* GetJob(bool allowBackground);
+    static Job* TakeJob(JobPriority priority);
+    static Job* TakeBackgroundJob();
     static void RunWorker();
+    // One job or one tier of idling, shared by worker threads and pool fibers
+    static void RunWorkerStep(u32* idleRounds);
+    static void FiberMain();
+    static void Sleep();
     static int JobQueueWorkerFunction(void* data);
+    static void ReleaseJob(Job* job);
 };
+
+template <typename Function>
+constexpr bool JobSystem::IsFunctionInline()
+{
+    return sizeof(Function) <= ParallelForData::InlineFunctionSize && alignof(Function) <= 8 &&
+           std::is_trivially_copyable<Function>::value;
+}
+
+template <typename Function>
+void JobSystem::ParallelForJob(Job* job, const void* data)
+{
+    const ParallelForData* args = (const ParallelForData*)data;
+    const Function* function;
+    if constexpr (IsFunctionInline<Function>())
+        function = (const Function*)args->Function;
+    else
+        function = *(const Function* const*)args->Function;
+
+    // Keep splitting off the upper half, whoever steals it splits it further. This fans the range
+    // out as a binary tree instead of the calling thread pushing every single range.
+    u32 begin = args->Begin;
+    u32 end = args->End;
+    while (end - begin > args->GrainSize)
+    {
+        const u32 middle = begin + (end - begin) / 2;
+        Job* child = CreateJobAsChild(job, ParallelForJob<Function>);
+        ParallelForData* childArgs = (ParallelForData*)child->data;
+        *childArgs = *args;
+        childArgs->Begin = middle;
+        childArgs->End = end;
+        Run(child);
+        end = middle;
+    }
+    (*function)(begin, end);
+}
+
+template <typename Function>
+void JobSystem::ParallelForRange(u32 count, u32 grainSize, const Function& function)
+{
+    if (count == 0)
+        return;
+
+    if (grainSize == 0)
+    {
+        // Aim for a couple of ranges per worker so stealing can even out uneven work
+        const s32 workerCount = GetWorkerCount();
+        const u32 targetRanges = (u32)(workerCount > 0 ? workerCount : 1) * 8;
+        grainSize = count / targetRanges;
+        if (grainSize == 0)
+            grainSize = 1;
+    }
+
+    if (count <= grainSize)
+    {
+        function(0, count);
+        return;
+    }
+
+    Job* root = CreateJob(ParallelForJob<Function>);
+    ParallelForData* args = (ParallelForData*)root->data;
+    if constexpr (IsFunctionInline<Function>())
+        SDL_memcpy(args->Function, &function, sizeof(Function));
+    else
+        *(const Function**)args->Function = &function;
+    args->Begin = 0;
+    args->End = count;
+    args->GrainSize = grainSize;
+
+    Run(root);
+    Wait(root);
+}
+
+template <typename Function>
+void JobSystem::ParallelFor(u32 count, u32 grainSize, const Function& function)
+{
+    const auto rangeFunction = [&function](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i)
+        {
+            function(i);
+        }
+    };
+    ParallelForRange(count, grainSize, rangeFunction);
+}
 }  // namespace DG
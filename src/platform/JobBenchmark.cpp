@@ -0,0 +1,366 @@
+/**
+ *  @file    JobBenchmark.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "JobBenchmark.h"
+#include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include "Job.h"
+
+namespace DG
+{
+static const u32 BENCHMARK_RUNS = 5;
+static const u32 NESTED_TREE_DEPTH = 10;
+static const u32 NESTED_TREE_COUNT = 200;
+static const u32 STRESS_FRAME_COUNT = 120;
+static const u32 STRESS_JOBS_PER_FRAME = 16;
+static const f64 STRESS_FRAME_MILLISECONDS = 16.0;
+static const f64 STRESS_BACKGROUND_MILLISECONDS = 3000.0;
+static const u32 EXACTLY_ONCE_ROUNDS = 200;
+static const u32 EXACTLY_ONCE_TREES = 64;
+static const u32 EXACTLY_ONCE_CHILDREN = 32;
+static const u32 BACKGROUND_WAIT_CHILDREN = 64;
+static const f64 BACKGROUND_WAIT_CHILD_MILLISECONDS = 0.1;
+static const u32 BACKGROUND_WAIT_TIMEOUT_MILLISECONDS = 10000;
+
+// Enough math per element that the loop is not purely bandwidth bound
+static inline f32 BenchmarkKernel(f32 value) { return std::sqrt(value * value + 1.0f) * 0.5f; }
+
+struct ExactlyOnceData
+{
+    std::atomic<u32>* RunCounts;
+    std::atomic<u32>* DetachedFinished;
+    u32 Index;
+};
+
+static void ExactlyOnceLeaf(Job*, const void* data)
+{
+    const ExactlyOnceData* args = (const ExactlyOnceData*)data;
+    args->RunCounts[args->Index].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Counts itself, then fans out children from whatever worker picked it up. Detached trees report
+// in once their root ran, the children are still in flight at that point.
+static void ExactlyOnceTree(Job* job, const void* data)
+{
+    const ExactlyOnceData* args = (const ExactlyOnceData*)data;
+    args->RunCounts[args->Index].fetch_add(1, std::memory_order_relaxed);
+    for (u32 i = 1; i <= EXACTLY_ONCE_CHILDREN; ++i)
+    {
+        Job* child = JobSystem::CreateJobAsChild(job, ExactlyOnceLeaf);
+        ExactlyOnceData* childArgs = (ExactlyOnceData*)child->data;
+        *childArgs = *args;
+        childArgs->Index = args->Index + i;
+        JobSystem::Run(child);
+    }
+}
+
+static void ExactlyOnceDetachedTree(Job* job, const void* data)
+{
+    ExactlyOnceTree(job, data);
+    ((const ExactlyOnceData*)data)->DetachedFinished->fetch_add(1, std::memory_order_release);
+}
+
+void RunJobStressTest()
+{
+    static_assert(sizeof(ExactlyOnceData) <= sizeof(Job::data), "ExactlyOnceData too big");
+    const u32 jobsPerTree = EXACTLY_ONCE_CHILDREN + 1;
+    const u32 jobCount = 2 * EXACTLY_ONCE_TREES * jobsPerTree;
+    std::atomic<u32>* runCounts = new std::atomic<u32>[jobCount];
+    std::atomic<u32> detachedFinished{0};
+
+    SDL_Log("Job stress test, %u rounds of %u jobs, %d workers", EXACTLY_ONCE_ROUNDS, jobCount,
+            JobSystem::GetWorkerCount());
+    u32 failedRounds = 0;
+    for (u32 round = 0; round < EXACTLY_ONCE_ROUNDS; ++round)
+    {
+        for (u32 i = 0; i < jobCount; ++i) runCounts[i].store(0, std::memory_order_relaxed);
+        detachedFinished.store(0, std::memory_order_relaxed);
+
+        // Every other tree is detached, the waited ones are spawned from inside a ParallelFor so
+        // roots get created and waited on by every worker
+        Job* waited[EXACTLY_ONCE_TREES];
+        JobSystem::ParallelFor(EXACTLY_ONCE_TREES, 1, [&](u32 tree) {
+            ExactlyOnceData args = {runCounts, &detachedFinished, 2 * tree * jobsPerTree};
+            Job* detached = JobSystem::CreateJob(ExactlyOnceDetachedTree);
+            *(ExactlyOnceData*)detached->data = args;
+            JobSystem::RunDetached(detached);
+
+            args.Index += jobsPerTree;
+            waited[tree] = JobSystem::CreateJob(ExactlyOnceTree);
+            *(ExactlyOnceData*)waited[tree]->data = args;
+            JobSystem::Run(waited[tree]);
+        });
+        for (Job* job : waited) JobSystem::Wait(job);
+
+        // Detached trees can still be running, wait until every count arrived
+        u32 pending = jobCount;
+        while (pending > 0)
+        {
+            pending = EXACTLY_ONCE_TREES - detachedFinished.load(std::memory_order_acquire);
+            for (u32 i = 0; i < jobCount; ++i)
+                pending += runCounts[i].load(std::memory_order_acquire) == 0;
+            if (pending > 0)
+                JobSystem::RunPendingJob();
+        }
+
+        for (u32 i = 0; i < jobCount; ++i)
+        {
+            const u32 runCount = runCounts[i].load(std::memory_order_relaxed);
+            if (runCount != 1)
+            {
+                SDL_LogError(0, "Job %u of round %u ran %u times", i, round, runCount);
+                failedRounds++;
+                break;
+            }
+        }
+    }
+    Assert(failedRounds == 0);
+    SDL_Log("  %u of %u rounds ran every job exactly once", EXACTLY_ONCE_ROUNDS - failedRounds,
+            EXACTLY_ONCE_ROUNDS);
+    delete[] runCounts;
+}
+
+template <typename Function>
+static f64 MeasureBestMilliseconds(const Function& function)
+{
+    const f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64 best = 0.0;
+    for (u32 run = 0; run < BENCHMARK_RUNS; ++run)
+    {
+        const u64 start = SDL_GetPerformanceCounter();
+        function();
+        const f64 elapsed = (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+void RunParallelForBenchmark()
+{
+    const u32 counts[] = {1000, 100000, 10000000};
+
+    SDL_Log("ParallelFor benchmark, %d workers, best of %u runs", JobSystem::GetWorkerCount(),
+            BENCHMARK_RUNS);
+    for (u32 count : counts)
+    {
+        f32* values = new f32[count];
+        for (u32 i = 0; i < count; ++i)
+        {
+            values[i] = (f32)i;
+        }
+
+        const f64 serial = MeasureBestMilliseconds([&]() {
+            for (u32 i = 0; i < count; ++i)
+            {
+                values[i] = BenchmarkKernel(values[i]);
+            }
+        });
+        const f64 parallel = MeasureBestMilliseconds([&]() {
+            JobSystem::ParallelFor(count, 0,
+                                   [&](u32 i) { values[i] = BenchmarkKernel(values[i]); });
+        });
+
+        SDL_Log("  %10u elements: serial %8.3fms, parallel %8.3fms, speedup %.2fx", count, serial,
+                parallel, parallel > 0.0 ? serial / parallel : 0.0);
+        delete[] values;
+    }
+}
+
+struct NestedJobData
+{
+    u32 Depth;
+};
+
+// Every inner node spawns two root jobs and waits on them, which is the worst case for the
+// recursive Wait since every wait nests further jobs on the stack of the waiting one
+static void NestedJob(Job*, const void* data)
+{
+    const NestedJobData* args = (const NestedJobData*)data;
+    if (args->Depth == 0)
+    {
+        f32 value = 1.0f;
+        for (u32 i = 0; i < 256; ++i)
+        {
+            value = BenchmarkKernel(value);
+        }
+        volatile f32 sink = value;
+        (void)sink;
+        return;
+    }
+
+    Job* children[2];
+    for (Job*& child : children)
+    {
+        child = JobSystem::CreateJob(NestedJob);
+        ((NestedJobData*)child->data)->Depth = args->Depth - 1;
+        JobSystem::Run(child);
+    }
+    for (Job* child : children)
+    {
+        JobSystem::Wait(child);
+    }
+}
+
+static void MeasureNestedWait(const char* name)
+{
+    const f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64* latencies = new f64[NESTED_TREE_COUNT];
+
+    const JobStats statsBefore = JobSystem::GetStats();
+    const u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < NESTED_TREE_COUNT; ++i)
+    {
+        const u64 treeStart = SDL_GetPerformanceCounter();
+        Job* root = JobSystem::CreateJob(NestedJob);
+        ((NestedJobData*)root->data)->Depth = NESTED_TREE_DEPTH;
+        JobSystem::Run(root);
+        JobSystem::Wait(root);
+        latencies[i] = (f64)(SDL_GetPerformanceCounter() - treeStart) * 1000.0 / frequency;
+    }
+    const f64 total = (f64)(SDL_GetPerformanceCounter() - start) / frequency;
+    const JobStats statsAfter = JobSystem::GetStats();
+
+    std::sort(latencies, latencies + NESTED_TREE_COUNT);
+    SDL_Log("  %-16s %8.1f trees/s, p50 %7.3fms, p99 %7.3fms, max %7.3fms, fallback waits %u",
+            name, (f64)NESTED_TREE_COUNT / total, latencies[NESTED_TREE_COUNT / 2],
+            latencies[NESTED_TREE_COUNT * 99 / 100], latencies[NESTED_TREE_COUNT - 1],
+            statsAfter.FiberFallbackWaits - statsBefore.FiberFallbackWaits);
+    delete[] latencies;
+}
+
+void RunNestedWaitBenchmark()
+{
+    SDL_Log("Nested wait benchmark, %u trees of depth %u, %d workers", NESTED_TREE_COUNT,
+            NESTED_TREE_DEPTH, JobSystem::GetWorkerCount());
+
+    const bool wasUsingFibers = JobSystem::IsUsingFibers();
+    JobSystem::SetUseFibers(false);
+    MeasureNestedWait("recursive wait");
+#if DG_JOB_FIBERS
+    JobSystem::SetUseFibers(true);
+    MeasureNestedWait("fibers");
+#endif
+    JobSystem::SetUseFibers(wasUsingFibers);
+}
+
+static void SpinFor(f64 milliseconds)
+{
+    const u64 end = SDL_GetPerformanceCounter() +
+                    (u64)(milliseconds * (f64)SDL_GetPerformanceFrequency() / 1000.0);
+    while (SDL_GetPerformanceCounter() < end)
+    {
+    }
+}
+
+// The ParallelFor root and its ranges inherit the background priority of this job
+static void BackgroundWaitJob(Job*, const void*)
+{
+    std::atomic<u32> sum{0};
+    JobSystem::ParallelFor(BACKGROUND_WAIT_CHILDREN, 1, [&sum](u32 i) {
+        SpinFor(BACKGROUND_WAIT_CHILD_MILLISECONDS);
+        sum.fetch_add(i, std::memory_order_relaxed);
+    });
+    Assert(sum.load(std::memory_order_relaxed) ==
+           BACKGROUND_WAIT_CHILDREN * (BACKGROUND_WAIT_CHILDREN - 1) / 2);
+}
+
+void RunBackgroundWaitTest()
+{
+    // Twice as many waiting jobs as there are workers, way above the background limit
+    const s32 workerCount = JobSystem::GetWorkerCount();
+    const u32 jobCount = 2 * (u32)(workerCount > 0 ? workerCount : 1);
+    SDL_Log("Background wait test, %u background jobs waiting on children, %d workers", jobCount,
+            workerCount);
+
+    Job** jobs = new Job*[jobCount];
+    for (u32 i = 0; i < jobCount; ++i)
+    {
+        jobs[i] = JobSystem::CreateJob(BackgroundWaitJob, JobPriority::Background);
+        JobSystem::Run(jobs[i]);
+    }
+
+    // Wait would help out and hang right along with the workers, poll with a deadline instead
+    const u64 deadline = SDL_GetPerformanceCounter() + (u64)BACKGROUND_WAIT_TIMEOUT_MILLISECONDS *
+                                                           SDL_GetPerformanceFrequency() / 1000;
+    u32 finished = 0;
+    while (SDL_GetPerformanceCounter() < deadline)
+    {
+        finished = 0;
+        for (u32 i = 0; i < jobCount; ++i) finished += jobs[i]->CheckIsDone();
+        if (finished == jobCount)
+            break;
+        SDL_Delay(1);
+    }
+
+    if (finished != jobCount)
+    {
+        // The jobs are leaked, they can never finish
+        SDL_LogError(0, "  Deadlocked, %u of %u background jobs finished", finished, jobCount);
+        Assert(false);
+        delete[] jobs;
+        return;
+    }
+    for (u32 i = 0; i < jobCount; ++i) JobSystem::Wait(jobs[i]);
+    SDL_Log("  All %u background jobs finished", jobCount);
+    delete[] jobs;
+}
+
+static void EmptyStressJob(Job*, const void*) {}
+
+static void BackgroundStressJob(Job*, const void*) { SpinFor(STRESS_BACKGROUND_MILLISECONDS); }
+
+static void FrameStressJob(Job* job, const void*)
+{
+    // One frame worth of work if it was spread evenly over the workers
+    const s32 workerCount = JobSystem::GetWorkerCount();
+    const f64 jobMilliseconds = STRESS_FRAME_MILLISECONDS * (f64)(workerCount > 0 ? workerCount : 1) /
+                                (f64)STRESS_JOBS_PER_FRAME;
+    JobSystem::ParallelFor(STRESS_JOBS_PER_FRAME, 1, [jobMilliseconds](u32) {
+        SpinFor(jobMilliseconds);
+    });
+}
+
+static void MeasureFrames(const char* name)
+{
+    const f64 frequency = (f64)SDL_GetPerformanceFrequency();
+    f64* frameTimes = new f64[STRESS_FRAME_COUNT];
+    for (u32 i = 0; i < STRESS_FRAME_COUNT; ++i)
+    {
+        const u64 start = SDL_GetPerformanceCounter();
+        Job* frame = JobSystem::CreateJob(FrameStressJob, JobPriority::FrameCritical);
+        JobSystem::Run(frame);
+        JobSystem::Wait(frame);
+        frameTimes[i] = (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+    }
+
+    std::sort(frameTimes, frameTimes + STRESS_FRAME_COUNT);
+    SDL_Log("  %-20s p50 %7.3fms, p99 %7.3fms, max %7.3fms", name,
+            frameTimes[STRESS_FRAME_COUNT / 2], frameTimes[STRESS_FRAME_COUNT * 99 / 100],
+            frameTimes[STRESS_FRAME_COUNT - 1]);
+    delete[] frameTimes;
+}
+
+void RunPriorityStressTest()
+{
+    const s32 workerCount = JobSystem::GetWorkerCount();
+    SDL_Log("Priority stress test, %u frames of %.0fms, %d workers", STRESS_FRAME_COUNT,
+            STRESS_FRAME_MILLISECONDS, workerCount);
+    MeasureFrames("frames only");
+
+    // More background work than it is allowed to occupy workers, all children of one root
+    Job* background = JobSystem::CreateJob(EmptyStressJob, JobPriority::Background);
+    for (s32 i = 0; i < workerCount; ++i)
+    {
+        JobSystem::Run(JobSystem::CreateJobAsChild(background, BackgroundStressJob));
+    }
+    JobSystem::Run(background);
+
+    MeasureFrames("with background");
+    JobSystem::Wait(background);
+}
+}  // namespace DG
@@ -0,0 +1,30 @@
+/**
+ *  @file    JobBenchmark.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+
+namespace DG
+{
+// Runs trees of waited on and detached jobs from every worker at once and checks that every job
+// ran exactly once. Logs and asserts on failure.
+void RunJobStressTest();
+
+// Starts more background jobs than may run at once, each waiting on background children of its
+// own, and checks they all finish instead of holding every background slot while waiting.
+void RunBackgroundWaitTest();
+
+// Times JobSystem::ParallelFor against a serial loop at a few sizes and logs the results.
+// Needs the workers to be up already.
+void RunParallelForBenchmark();
+
+// Runs deeply nested trees of jobs that each wait on their children, once with the recursive
+// Wait and once on fibers (with DG_JOB_FIBERS), and logs throughput and tail latency.
+void RunNestedWaitBenchmark();
+
+// Simulates 16ms frames of frame critical jobs, first alone and then next to background jobs
+// running for seconds, and logs how the frame time distribution changes.
+void RunPriorityStressTest();
+}  // namespace DG
@@ -20,6 +20,8 @@ class StringHashTable
    public:
     StringHashTable() : _values(tableSize) {}
     void Put(u32 key, const char* value);
+    // Null if nothing was put for key. Keys can share a slot, compare the hash of the result.
+    const char* Get(u32 key) const;
 
    private:
     std::vector<std::optional<const char*>> _values;
@@ -39,6 +41,12 @@ void StringHashTable<tableSize>::Put(u32 key, const char* value)
     _values[index] = SDL_strdup(value);
 }
 
+template <u32 tableSize>
+const char* StringHashTable<tableSize>::Get(u32 key) const
+{
+    return _values[key % tableSize].value_or(nullptr);
+}
+
 extern StringHashTable<2048> g_StringHashTable;
 #endif
 const u32 crc32_tab[] = {
@@ -34767,6 +34775,33 @@ struct StringId
 
     u32 GetHash() const { return m_nStringHash; }
 
+    // Same hash as the constructors, for text that is only known at runtime
+    static u32 HashString(const char* str)
+    {
+        u32 crc32 = 0xffffffff;
+        for (; *str; ++str) crc32 = (crc32 >> 8) ^ crc32_tab[(crc32 ^ *str) & 0xFF];
+        return crc32 ^ 0xFFFFFFFF;
+    }
+
+    // Interns text read from files. Unlike the constructors this doesn't assert when another
+    // string already took the debug slot, the text just isn't remembered then.
+    static StringId FromString(const char* str)
+    {
+        StringId result = FromHash(HashString(str));
+#if _DEBUG
+        if (!g_StringHashTable.Get(result.m_nStringHash))
+            g_StringHashTable.Put(result.m_nStringHash, str);
+#endif
+        return result;
+    }
+
+    static StringId FromHash(u32 hash)
+    {
+        StringId result;
+        result.m_nStringHash = hash;
+        return result;
+    }
+
    private:
     u32 m_nStringHash;
 };
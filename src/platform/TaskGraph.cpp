@@ -0,0 +1,199 @@
+/**
+ *  @file    TaskGraph.cpp
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#include "TaskGraph.h"
+#include <SDL.h>
+#include "BitOperations.h"
+#include "Job.h"
+
+namespace DG
+{
+struct TaskJobData
+{
+    TaskGraph* Graph;
+    u32 TaskIndex;
+};
+static_assert(sizeof(TaskJobData) <= sizeof(Job::data), "TaskJobData too big");
+
+static void EmptyJob(Job*, const void*) {}
+
+u32 TaskGraph::AddTask(const char* name, TaskFunction function, u64 reads, u64 writes, u8 flags)
+{
+    Assert(!_isBuilt);
+    Assert(_taskCount < MaxTasks);
+
+    Task& task = _tasks[_taskCount];
+    task.Name = name;
+    task.Function = function;
+    task.Reads = reads;
+    task.Writes = writes;
+    task.Flags = flags;
+    task.PredecessorCount = 0;
+    task.SuccessorCount = 0;
+    task.StartTime = 0;
+    task.EndTime = 0;
+    return _taskCount++;
+}
+
+void TaskGraph::Build()
+{
+    Assert(!_isBuilt);
+
+    // Tasks only ever depend on earlier ones, so the order they were added in is a valid
+    // topological order and the graph can not have cycles
+    for (u32 i = 0; i < _taskCount; ++i)
+    {
+        Task& earlier = _tasks[i];
+        for (u32 j = i + 1; j < _taskCount; ++j)
+        {
+            Task& later = _tasks[j];
+            const bool writeAfterAny = (earlier.Reads | earlier.Writes) & later.Writes;
+            const bool readAfterWrite = earlier.Writes & later.Reads;
+            if (!writeAfterAny && !readAfterWrite)
+                continue;
+
+            earlier.Successors[earlier.SuccessorCount++] = (u8)j;
+            later.PredecessorCount++;
+        }
+    }
+    _isBuilt = true;
+}
+
+void TaskGraph::Execute(void* userData, JobPriority priority)
+{
+    Assert(_isBuilt);
+
+    _userData = userData;
+    _finishedTaskCount.store(0, std::memory_order_relaxed);
+    _mainThreadReadyMask.store(0, std::memory_order_relaxed);
+    for (u32 i = 0; i < _taskCount; ++i)
+    {
+        _tasks[i].UnfinishedPredecessors.store(_tasks[i].PredecessorCount,
+                                               std::memory_order_relaxed);
+    }
+
+    // Every task job is a child of the root, the root itself only finishes after the last task
+    _executeStartTime = SDL_GetPerformanceCounter();
+    _root = JobSystem::CreateJob(EmptyJob, priority);
+    for (u32 i = 0; i < _taskCount; ++i)
+    {
+        if (_tasks[i].PredecessorCount == 0)
+            Schedule(i);
+    }
+
+    while (_finishedTaskCount.load(std::memory_order_acquire) != _taskCount)
+    {
+        u64 readyMask = _mainThreadReadyMask.exchange(0, std::memory_order_acquire);
+        u32 taskIndex;
+        while (BitScanForward(readyMask, &taskIndex))
+        {
+            readyMask &= readyMask - 1;
+            RunTask(taskIndex);
+        }
+
+        // Help out while the workers are busy with our tasks
+        JobSystem::RunPendingJob();
+    }
+
+    JobSystem::Finish(_root);
+    JobSystem::Wait(_root);
+    _root = nullptr;
+    _executeEndTime = SDL_GetPerformanceCounter();
+}
+
+void TaskGraph::TaskJob(Job* job, const void* data)
+{
+    const TaskJobData* taskData = (const TaskJobData*)data;
+    taskData->Graph->RunTask(taskData->TaskIndex);
+}
+
+void TaskGraph::Schedule(u32 taskIndex)
+{
+    if (_tasks[taskIndex].Flags & TaskFlags::MainThread)
+    {
+        _mainThreadReadyMask.fetch_or(1ull << taskIndex, std::memory_order_release);
+        return;
+    }
+
+    Job* job = JobSystem::CreateJobAsChild(_root, TaskJob);
+    TaskJobData* taskData = (TaskJobData*)job->data;
+    taskData->Graph = this;
+    taskData->TaskIndex = taskIndex;
+    JobSystem::Run(job);
+}
+
+void TaskGraph::RunTask(u32 taskIndex)
+{
+    Task& task = _tasks[taskIndex];
+    task.StartTime = SDL_GetPerformanceCounter();
+    task.Function(_userData);
+    task.EndTime = SDL_GetPerformanceCounter();
+
+    for (u32 i = 0; i < task.SuccessorCount; ++i)
+    {
+        Task& successor = _tasks[task.Successors[i]];
+        if (successor.UnfinishedPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Schedule(task.Successors[i]);
+    }
+
+    // Successors are scheduled before this, Execute relies on that to finish the root safely
+    _finishedTaskCount.fetch_add(1, std::memory_order_release);
+}
+
+void TaskGraph::DumpCriticalPath() const
+{
+    Assert(_isBuilt);
+    if (_taskCount == 0)
+        return;
+
+    const f64 toMilliseconds = 1000.0 / (f64)SDL_GetPerformanceFrequency();
+
+    // Longest path by measured duration, tasks are already in topological order
+    f64 pathLength[MaxTasks] = {};
+    s32 pathPrevious[MaxTasks];
+    for (u32 i = 0; i < _taskCount; ++i)
+    {
+        pathPrevious[i] = -1;
+    }
+
+    u32 pathEnd = 0;
+    for (u32 i = 0; i < _taskCount; ++i)
+    {
+        const Task& task = _tasks[i];
+        pathLength[i] += (f64)(task.EndTime - task.StartTime) * toMilliseconds;
+        if (pathLength[i] > pathLength[pathEnd])
+            pathEnd = i;
+
+        for (u32 j = 0; j < task.SuccessorCount; ++j)
+        {
+            const u32 successor = task.Successors[j];
+            if (pathPrevious[successor] == -1 || pathLength[i] > pathLength[successor])
+            {
+                pathLength[successor] = pathLength[i];
+                pathPrevious[successor] = (s32)i;
+            }
+        }
+    }
+
+    // Walk back from the end, print front to back
+    u32 path[MaxTasks];
+    u32 pathCount = 0;
+    for (s32 i = (s32)pathEnd; i != -1; i = pathPrevious[i])
+    {
+        path[pathCount++] = (u32)i;
+    }
+
+    SDL_Log("TaskGraph: %u tasks, %.3fms total, critical path %.3fms", _taskCount,
+            (f64)(_executeEndTime - _executeStartTime) * toMilliseconds, pathLength[pathEnd]);
+    while (pathCount--)
+    {
+        const Task& task = _tasks[path[pathCount]];
+        SDL_Log("  %-20s %8.3fms (started at %.3fms)", task.Name,
+                (f64)(task.EndTime - task.StartTime) * toMilliseconds,
+                (f64)(task.StartTime - _executeStartTime) * toMilliseconds);
+    }
+}
+}  // namespace DG
@@ -0,0 +1,75 @@
+/**
+ *  @file    TaskGraph.h
+ *  @author  Faaux (github.com/Faaux)
+ *  @date    17 October 2026
+ */
+
+#pragma once
+#include <atomic>
+#include "Job.h"
+#include "engine/Types.h"
+
+namespace DG
+{
+typedef void (*TaskFunction)(void* userData);
+
+// Set of tasks that is built once and then executed as often as needed on top of the JobSystem.
+// Every task declares the resources (one bit each) it reads and writes, a task depends on every
+// earlier added task it conflicts with. Executing does not allocate.
+class TaskGraph
+{
+   public:
+    enum : u32
+    {
+        MaxTasks = 64  // One bit each in the ready mask of the calling thread
+    };
+
+    enum TaskFlags : u8
+    {
+        None = 0,
+        MainThread = 1 << 0,  // Runs on the thread calling Execute, e.g. for SDL or ImGui
+    };
+
+    u32 AddTask(const char* name, TaskFunction function, u64 reads, u64 writes,
+                u8 flags = TaskFlags::None);
+    void Build();
+
+    // Runs every task with userData and returns once all of them are done
+    void Execute(void* userData, JobPriority priority = JobPriority::FrameCritical);
+
+    // Logs the longest chain of dependent tasks of the last Execute
+    void DumpCriticalPath() const;
+
+   private:
+    struct Task
+    {
+        const char* Name;
+        TaskFunction Function;
+        u64 Reads;
+        u64 Writes;
+        u8 Flags;
+        u8 PredecessorCount;
+        u8 SuccessorCount;
+        u8 Successors[MaxTasks];
+        std::atomic<s32> UnfinishedPredecessors{0};
+        u64 StartTime;
+        u64 EndTime;
+    };
+
+    static void TaskJob(Job* job, const void* data);
+    void Schedule(u32 taskIndex);
+    void RunTask(u32 taskIndex);
+
+    Task _tasks[MaxTasks];
+    u32 _taskCount = 0;
+    bool _isBuilt = false;
+
+    // Only valid during Execute
+    void* _userData = nullptr;
+    Job* _root = nullptr;
+    u64 _executeStartTime = 0;
+    u64 _executeEndTime = 0;
+    std::atomic<u32> _finishedTaskCount{0};
+    std::atomic<u64> _mainThreadReadyMask{0};
+};
+}  // namespace DG